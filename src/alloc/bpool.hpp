@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <bitset>
 #include <limits>
@@ -9,17 +10,45 @@
 #include <format>
 
 #include "utils/logging.hpp"
+#include "utils/probes.hpp"
 
 namespace alloc{
 
 constexpr std::size_t OPTIMAL_BPOOL_SEGMENT_ELEMENTS_COUNT = std::numeric_limits<unsigned long long>::digits; // = 64 on most platforms
+// how far (in slots) past the hint allocate_near looks before falling back to the regular placement
+constexpr std::size_t BPOOL_HINT_WINDOW = OPTIMAL_BPOOL_SEGMENT_ELEMENTS_COUNT;
+// stride of prefault(): one write per (smallest common) page
+constexpr std::size_t BPOOL_PAGE_SIZE = 4096;
 
-enum class placement_policy {
+enum class placement_policy : uint8_t {
     last,
-    first
+    first,
+    // single slots as last, n > 1 blocks from buddy system segments (see buddy_bpool.hpp)
+    buddy,
+    // last while the slots at the cursor are free (a hit), next fit / first fit on a miss, and the cursor moves
+    // to the placement found: bumps through freed regions, scans only when the run at the cursor ends
+    adaptive
     // best
 };
 
+// what adaptive placement did so far: hits at the cursor, misses (scans) and the bitmap words they went through
+struct placement_stats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t scanned = 0;
+};
+
+// result of allocate_at_least: count >= n slots from ptr on, all of them the caller's (deallocate(ptr, count))
+#ifdef __cpp_lib_allocate_at_least
+using std::allocation_result;
+#else
+template <typename Pointer>
+struct allocation_result {
+    Pointer ptr;
+    size_t count;
+};
+#endif
+
 template <typename T> // size N independent base class 
 struct bpool_base {
     virtual ~bpool_base(){
@@ -27,9 +56,18 @@ struct bpool_base {
     }
 
     virtual T* allocate(size_t n) = 0;
+    // allocate(n) under placement_policy::adaptive, counted in stats (bpool_alloc keeps them). sparse = false leaves
+    // the holes of a segment at most half free alone: nullptr unless the slots at the cursor are free
+    virtual T* allocate_adaptive(size_t n, placement_stats& stats, bool sparse) = 0;
+    // same as allocate, but tries the slots right after hint first (locality for node based containers)
+    virtual T* allocate_near(size_t n, const T* hint) = 0;
     virtual void deallocate(T* ptr, size_t n) = 0;
+    // allocate(n) that hands out the free slots right after the block as well, {nullptr, 0} if no placement
+    virtual allocation_result<T*> allocate_at_least(size_t n) = 0;
+    // grows the block [ptr, ptr + old_n) to new_n slots in place, false (nothing changed) if they are not free
+    virtual bool try_expand(T* ptr, size_t old_n, size_t new_n) noexcept = 0;
 
-    virtual bool contains(T *p, size_t n) noexcept = 0;
+    virtual bool contains(const T *p, size_t n) noexcept = 0;
 
     virtual size_t total_count() noexcept = 0;
     virtual size_t free_count() noexcept = 0;
@@ -40,8 +78,14 @@ struct bpool_base {
     virtual std::string repr() noexcept = 0;
 
     virtual void reset() noexcept = 0;    
+    // frees all slots at once (bulk counterpart of deallocate)
+    virtual void release() noexcept = 0;
+    // touches every page of the slot storage, so first allocations do not page fault
+    virtual void prefault() noexcept = 0;
 };
 
+// Members call each other non-virtually: a bpool placed in shared memory (shm_bpool.hpp) is used through its
+// concrete type by processes whose vtable addresses differ from the creator's.
 template<typename T, size_t N = OPTIMAL_BPOOL_SEGMENT_ELEMENTS_COUNT> // N is part of type cuz std::bitset<N> or use boost::bitset with dynamic size ...
 struct bpool final: bpool_base<T> {
     using value_t = T;
@@ -52,8 +96,13 @@ private:
     value_storage_t _pool[N]; // T-aligned
     std::bitset<N> _free{};
     placement_policy _policy;
+    // placement_policy::adaptive: every slot from _last_idx on is free (as under the other policies), so a hit is
+    // last's bounds check; false once the cursor moved back into a freed region, where hits test the bitmap
+    bool _at_tail = true;
+    uint32_t _free_slots = N; // _free.count(), kept up to date: an O(1) "no room here" for every policy
     // _last_idx used as workaround for fast determination (that requires processor bound assembler code) of first significant flag in a bitset
     size_t _last_idx = 0;
+    static_assert(N <= UINT32_MAX, "_free_slots shares a word with _policy");
 public:
     // ~bpool() noexcept override = default;
     ~bpool() noexcept override { 
@@ -67,47 +116,73 @@ public:
     bpool &operator=(const bpool&) = delete;
 
     T* allocate(size_t n) override;
+    T* allocate_adaptive(size_t n, placement_stats& stats, bool sparse) override;
+    T* allocate_near(size_t n, const T* hint) override;
     void deallocate(T* ptr, size_t n) override;
+    allocation_result<T*> allocate_at_least(size_t n) override;
+    bool try_expand(T* ptr, size_t old_n, size_t new_n) noexcept override;
 
-    bool contains(T *p, size_t n) noexcept override {
+    bool contains(const T *p, size_t n) noexcept override {
         // TRACE(__PRETTY_FUNCTION__);
-        T* from = reinterpret_cast<T*>(const_cast<value_storage_t*>(&_pool[0]));
+        const T* from = reinterpret_cast<const T*>(&_pool[0]);
         // std::cout << " contains " << p << " - " << (p + n) << " from " << from  << " to " << from + N << " = " << (bool)((from <= p) && ((p + n) <= (from + N))) << std::endl; 
         return (from <= p) && ((p + n) <= (from + N));
     }
 
-    void set(placement_policy pp) noexcept override { _policy = pp; }
+    // the first slot (lazy_bpool commits the pages from there on)
+    T* data() noexcept { return reinterpret_cast<T*>(&_pool[0]); }
+
+    void set(placement_policy pp) noexcept override;
 
     size_t total_count() noexcept override { return N; }
-    size_t free_count() noexcept override { return _free.count(); }
+    size_t free_count() noexcept override { return _free_slots; }
     bool is_free(size_t n) noexcept override {
         // TRACE(__PRETTY_FUNCTION__);
-        [[maybe_unused]] auto [pos, mask] = _find_placement(n);
-        return (pos != N);
+        return (_find_placement(n) != N);
     }
 
     std::string repr() noexcept override { return _free.to_string('*', '_'); }
 
-    void reset() noexcept  override { _free.reset(); }    
+    void reset() noexcept  override { _free.reset(); _free_slots = 0; _at_tail = false; }    
+    void release() noexcept override { _free.set(); _free_slots = N; _last_idx = 0; _at_tail = true; }
+    void prefault() noexcept override {
+        // rewrites bytes with their own value: faults the page in, keeps live slots intact
+        auto bytes = reinterpret_cast<volatile unsigned char*>(&_pool[0]);
+        for (size_t i = 0; i < sizeof(_pool); i += BPOOL_PAGE_SIZE)
+            bytes[i] = bytes[i];
+        bytes[sizeof(_pool) - 1] = bytes[sizeof(_pool) - 1];
+    }
 private:
-    size_t _get_index_from_address(T *p) noexcept {
+    size_t _get_index_from_address(const T *p) noexcept {
         // TRACE(__PRETTY_FUNCTION__);
-        return contains(p, 1) ? p - reinterpret_cast<T*>(&_pool) : N;
+        return bpool::contains(p, 1) ? p - reinterpret_cast<const T*>(&_pool) : N;
     }
-    std::pair<size_t, std::bitset<N>> _find_placement(size_t n) const noexcept{
+    T* _occupy(size_t pos, size_t n) noexcept;
+    // placements are returned as start index (N if not found), masks of N bits are too expensive for big segments
+    size_t _find_placement(size_t n) const noexcept{
         // if constexpr(P == placement_policy::first) - in case of P is part of this type
         switch (_policy) {
             case  placement_policy::first:
                 return _find_placement_first(n);
             case  placement_policy::last:
+            case  placement_policy::buddy:
                 return _find_placement_last(n);
+            case  placement_policy::adaptive:
+                return _find_placement_adaptive(n);
             default:
                 /// throw not implemented
                 return _find_placement_first(n);
         }
     }
-    std::pair<size_t, std::bitset<N>> _find_placement_first(size_t n) const noexcept;
-    std::pair<size_t, std::bitset<N>> _find_placement_last(size_t n) const noexcept;
+    size_t _find_placement_first(size_t n) const noexcept;
+    size_t _find_placement_last(size_t n) const noexcept;
+    size_t _find_placement_adaptive(size_t n) const noexcept;
+    // stats == nullptr: not counted (allocate)
+    T* _allocate_adaptive(size_t n, placement_stats* stats, bool sparse) noexcept;
+    // runs at the cursor and misses, out of line: inlined, their register saves would be paid for by every hit
+    [[gnu::noinline]] T* _allocate_adaptive_slow(size_t n, placement_stats* stats, bool sparse) noexcept;
+    bool _free_at_cursor(size_t n) const noexcept;
+    size_t _find_placement_near(size_t n, size_t from) const noexcept;
 };
 
 // flow of implementation details into interface cuz template... todo: try module )
@@ -120,75 +195,216 @@ template <size_t N>
 size_t countl(std::bitset<N> bs, bool value = true, size_t l_from = 0, size_t max_count = N);
 
 template <size_t N>
-size_t countr(std::bitset<N> bs, bool value = true, size_t r_from = 0, size_t max_count = N);
+size_t countr(const std::bitset<N>& bs, bool value = true, size_t r_from = 0, size_t max_count = N);
+
+template <size_t N>
+void set_range(std::bitset<N>& bs, size_t from, size_t to, bool value = true) noexcept;
 
 }
 
 template<typename T, size_t N>
 T* bpool<T, N>::allocate(size_t n) {
     // TRACE(__PRETTY_FUNCTION__);
-    if (n == 0 || n > free_count()) 
-        return nullptr;
+    ALLO_PROBE(bpool_allocate_start, this, n, N);
+    T* ptr = nullptr;
     // todo: add check of max available placement size (if it makes sense... not only for best placament policy)
-    if (auto [pos, mask] = _find_placement(n); pos != N){
-        if (n == 1)
-            _free.reset(pos);     
-        else 
-            _free &= mask.flip();
-        if (pos + n > _last_idx)
-            _last_idx = pos + n;
-        // return std::assume_aligned<value_alignment, T>(reinterpret_cast<T*>(&_pool[pos]));
-        return reinterpret_cast<T*>(&_pool[pos]);
-    } else {
-        // return static_cast<T *>(::operator new(value_size));
+    if (n != 0 && n <= _free_slots){
+        if (_policy != placement_policy::adaptive){
+            if (auto pos = _find_placement(n); pos != N)
+                ptr = _occupy(pos, n);
+        } else {
+            ptr = _allocate_adaptive(n, nullptr, true);    // bpool_alloc goes by allocate_adaptive
+        }
+    }
+    // ptr == nullptr: no placement in this segment (bpool_alloc tries the next one or extends)
+    ALLO_PROBE(bpool_allocate_done, this, n, ptr);
+    return ptr;
+}
+
+template<typename T, size_t N>
+T* bpool<T, N>::allocate_adaptive(size_t n, placement_stats& stats, bool sparse) {
+    if (_policy != placement_policy::adaptive)
+        return bpool::allocate(n);
+    ALLO_PROBE(bpool_allocate_start, this, n, N);
+    T* ptr = nullptr;
+    if (n != 0 && n <= _free_slots)
+        ptr = _allocate_adaptive(n, &stats, sparse);
+    ALLO_PROBE(bpool_allocate_done, this, n, ptr);
+    return ptr;
+}
+
+template<typename T, size_t N>
+inline T* bpool<T, N>::_allocate_adaptive(size_t n, placement_stats* stats, bool sparse) noexcept {
+    // hit: no scan, and in the free tail no bitmap either, as last
+    if (_at_tail ? _last_idx + n <= N : n == 1 && _last_idx < N && _free[_last_idx]){
+        if (stats != nullptr)
+            ++stats->hits;
+        return _occupy(_last_idx, n);
+    }
+    return _allocate_adaptive_slow(n, stats, sparse);
+}
+
+template<typename T, size_t N>
+T* bpool<T, N>::_allocate_adaptive_slow(size_t n, placement_stats* stats, bool sparse) noexcept {
+    if (_free_at_cursor(n)){
+        if (stats != nullptr)
+            ++stats->hits;
+        return _occupy(_last_idx, n);
+    }
+    if (!sparse && _free_slots <= N / 2)     // a miss per hole or so: dearer than bumping through a new segment
         return nullptr;
+    if (auto pos = _find_placement_adaptive(n); pos != N){
+        if (stats != nullptr){
+            ++stats->misses;
+            // words the scan went through: from the cursor, or from the start after wrapping
+            stats->scanned += (pos > _last_idx ? pos - _last_idx : pos) / 64 + 1;
+        }
+        return _occupy(pos, n);
     }
+    return nullptr;
+}
+
+template<typename T, size_t N>
+void bpool<T, N>::set(placement_policy pp) noexcept {
+    // the other policies take every slot from _last_idx on as free, adaptive moves it back over taken ones
+    if (_policy == placement_policy::adaptive && pp != placement_policy::adaptive)
+        _last_idx = N - _details::countl(_free, true);
+    else if (_policy != placement_policy::adaptive && pp == placement_policy::adaptive)
+        _at_tail = true;
+    _policy = pp;
+}
+
+template<typename T, size_t N>
+T* bpool<T, N>::allocate_near(size_t n, const T* hint) {
+    // TRACE(__PRETTY_FUNCTION__);
+    if (n == 0 || n > N) 
+        return nullptr;
+    if (auto i = _get_index_from_address(hint); i != N)
+        if (auto pos = _find_placement_near(n, i + 1); pos != N)
+            return _occupy(pos, n);
+    return bpool::allocate(n);
+}
+
+template<typename T, size_t N>
+allocation_result<T*> bpool<T, N>::allocate_at_least(size_t n) {
+    // TRACE(__PRETTY_FUNCTION__);
+    if (n == 0 || n > N)
+        return {nullptr, 0};
+    auto pos = _find_placement(n);
+    if (pos == N)
+        return {nullptr, 0};
+    // the free run goes on past n: take it, but no more than 2 n (under last it is the whole segment tail)
+    size_t extra = _details::countr(_free, true, pos + n, std::min(N - pos, 2 * n) - n);
+    return {_occupy(pos, n + extra), n + extra};
+}
+
+template<typename T, size_t N>
+bool bpool<T, N>::try_expand(T* p, size_t old_n, size_t new_n) noexcept {
+    // TRACE(__PRETTY_FUNCTION__);
+    auto i = _get_index_from_address(p);
+    if (i == N || new_n < old_n || new_n > N - i)
+        return false;
+    if (new_n == old_n)
+        return true;
+    if (_details::countr(_free, true, i + old_n, new_n - old_n) < new_n - old_n)
+        return false;
+    _occupy(i + old_n, new_n - old_n);
+    return true;
+}
+
+template<typename T, size_t N>
+T* bpool<T, N>::_occupy(size_t pos, size_t n) noexcept {
+    if (n == 1)
+        _free.reset(pos);     
+    else 
+        _details::set_range(_free, pos, pos + n, false);
+    _free_slots -= n;
+    if (pos < _last_idx)    // before the cursor: the slots up to it may be taken
+        _at_tail = false;
+    if (pos + n > _last_idx || _policy == placement_policy::adaptive)
+        _last_idx = pos + n;
+    // return std::assume_aligned<value_alignment, T>(reinterpret_cast<T*>(&_pool[pos]));
+    return reinterpret_cast<T*>(&_pool[pos]);
 }
 
 template<typename T, size_t N>
 void bpool<T, N>::deallocate(T* p, size_t n) {
     // TRACE(__PRETTY_FUNCTION__);
+    ALLO_PROBE(bpool_deallocate_start, this, p, n);
     if (auto i = _get_index_from_address(p); i != N){ // todo: check i + n > N and throw exception
         if (n == 1)
             _free.set(i);
         else 
-            _free |= _details::get_mask<N>(i, i + n);
+            _details::set_range(_free, i, i + n);
+        _free_slots += n;
         if (i + n >= _last_idx)
             _last_idx = i;
+        ALLO_PROBE(bpool_deallocate_done, this, p, n, 1);
     } else {
         // ::operator delete(p);
+        ALLO_PROBE(bpool_deallocate_done, this, p, n, 0); // not from this segment: ignored
     }
 }
 
 template<typename T, size_t N>
-std::pair<size_t, std::bitset<N>> bpool<T, N>::_find_placement_first(size_t n) const noexcept
+size_t bpool<T, N>::_find_placement_first(size_t n) const noexcept
 {
     // TRACE(__PRETTY_FUNCTION__);
     for (auto pos = _free._Find_first(); pos <= N - n;){
         if (_details::countr(_free, true, pos, n) >= n)
-            return std::make_pair(pos, _details::get_mask<N>(pos, pos + n));
+            return pos;
         pos = _free._Find_next(pos);
         // for "big" n
         // if (auto mask = get_mask<size>(pos, pos + n); (_free & mask).count() == n)
         //     return std::make_pair(pos, mask);
     }
-    return std::make_pair(N, std::bitset<N>());
+    return N;
 }
 
 template<typename T, size_t N>
-std::pair<size_t, std::bitset<N>> bpool<T, N>::_find_placement_last(size_t n) const noexcept
+size_t bpool<T, N>::_find_placement_last(size_t n) const noexcept
 {
     // TRACE(__PRETTY_FUNCTION__);
     // #include <bit> std::countl_one - only if T is an unsigned integer type...
     // if (size_t i = _details::countl(_free, true, 0); i >= n){   
     //     return std::make_pair(N - i, _details::get_mask<N>(N - i, N - i + n));
     if (_last_idx + n <= N){
-        return std::make_pair(_last_idx, _details::get_mask<N>(_last_idx, _last_idx + n));
+        return _last_idx;
     } else {
-        return std::make_pair(N, std::bitset<N>());
+        return N;
     }
 }
 
+template<typename T, size_t N>
+size_t bpool<T, N>::_find_placement_adaptive(size_t n) const noexcept
+{
+    // TRACE(__PRETTY_FUNCTION__);
+    if (_free_at_cursor(n))
+        return _last_idx;
+    // miss: next fit from the cursor (holes freed in address order come one after the other), then first fit
+    for (auto pos = _last_idx < N ? _free._Find_next(_last_idx) : N; pos + n <= N; pos = _free._Find_next(pos))
+        if (n == 1 || _details::countr(_free, true, pos, n) >= n)
+            return pos;
+    return _find_placement_first(n);
+}
+
+template<typename T, size_t N>
+bool bpool<T, N>::_free_at_cursor(size_t n) const noexcept
+{
+    return _last_idx + n <= N && _free[_last_idx] && (n == 1 || _details::countr(_free, true, _last_idx, n) >= n);
+}
+
+template<typename T, size_t N>
+size_t bpool<T, N>::_find_placement_near(size_t n, size_t from) const noexcept
+{
+    // TRACE(__PRETTY_FUNCTION__);
+    // bounded scan: a placement far from the hint gives no locality, so leave it to the policy
+    for (auto pos = from; pos < from + BPOOL_HINT_WINDOW && pos + n <= N; ++pos)
+        if (_free[pos] && _details::countr(_free, true, pos, n) >= n)
+            return pos;
+    return N;
+}
+
 template <size_t N>
 std::bitset<N> _details::get_mask(size_t from, size_t to) {
     if (to == from + 1){
@@ -214,7 +430,7 @@ size_t _details::countl(std::bitset<N> bs, bool value, size_t l_from, size_t max
 }
 
 template <size_t N>
-size_t _details::countr(std::bitset<N> bs, bool value, size_t r_from, size_t max_count) {
+size_t _details::countr(const std::bitset<N>& bs, bool value, size_t r_from, size_t max_count) {
     // for this task, fast optimization is possible
     // asm ("bsrl %1, %0" 
     //     : "=r" (position) 
@@ -225,4 +441,10 @@ size_t _details::countr(std::bitset<N> bs, bool value, size_t r_from, size_t max
     return max_count;
 }
 
+template <size_t N>
+void _details::set_range(std::bitset<N>& bs, size_t from, size_t to, bool value) noexcept {
+    for(size_t i = from; i < to; ++i)
+        bs[i] = value;
+}
+
 }
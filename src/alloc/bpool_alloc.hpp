@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
 #include <cstddef>
 #include <forward_list>
@@ -10,8 +12,13 @@
 #include <stdexcept>
 
 #include "utils/logging.hpp"
+#include "utils/probes.hpp"
 #include "utils/trace.hpp"
 #include "bpool.hpp"
+#include "buddy_bpool.hpp"
+#include "lazy_bpool.hpp"
+#include "memory_budget.hpp"
+#include "sizing_profile.hpp"
 
 namespace alloc{
 
@@ -28,49 +35,209 @@ struct bpool_alloc {
   // using is_always_equal                        = true_type;
 private:
   placement_policy _initial_placement_policy;
+  segment_backend _backend;
+  memory_budget *_budget; // not owned, shared with other allocators (rebound copies among them)
+  size_t _charged = 0; // slot bytes of the segments counted in _budget
+  sizing_record *_sizing = nullptr; // not owned, profile guided: recorded to, presized from (sizing_profile.hpp)
+  size_t _sized_blocks = 0; // allocated and not yet deallocated blocks, counted for _sizing only: release() frees them
+  bool _charge(size_t slots) noexcept {
+    if (_budget != nullptr && !_budget->try_charge(slots * sizeof(T)))
+      return false;
+    _charged += slots * sizeof(T);
+    return true;
+  }
+  void _refund(size_t slots) noexcept {
+    if (_budget != nullptr)
+      _budget->refund(slots * sizeof(T));
+    _charged -= slots * sizeof(T);
+  }
   std::forward_list<std::unique_ptr<alloc::bpool_base<T>>> _bpools;
   size_t _bpools_size = 0; // not to use distance(_bpools.begin(), _bpools.end())
-  void _extend_bpool(); // todo: add support for n depended extention
+  unsigned _bpool_sizes = 0; // bit k: the segment of N << k is live, the next one made is the first missing
+  size_t _used_count = 0; // allocated and not yet deallocated slots
+  // slots: the block is a run of n single slots (try_allocate_slots), n blocks for the sizing record
+  void _count_allocate(size_t n, bool slots = false) noexcept {
+    _used_count += n;
+    if (_sizing == nullptr)
+      return;
+    if (slots) {
+      _sized_blocks += n;
+      _sizing->on_allocate_slots(n, _used_count, _bpools_size + _buddies_size, sizeof(T));
+    } else {
+      ++_sized_blocks;
+      _sizing->on_allocate(n, _used_count, _bpools_size + _buddies_size, sizeof(T));
+    }
+  }
+  placement_stats _stats; // placement_policy::adaptive, counted by the segments
+  // placement_policy::adaptive once every segment declined: try_allocate leaves the holes of a segment at most half
+  // free alone while a new segment can be made (bumping through it costs less than a miss per hole), they are
+  // refilled once there is none
+  T *_extend_or_refill(size_t n, bool slots) noexcept;
+  T *_try_allocate(size_t n, bool slots) noexcept; // try_allocate, or try_allocate_slots with slots
+  bool _extend_bpool() noexcept; // false: segment limit reached or no memory. todo: add support for n depended extention
+  template <size_t M>
+  std::unique_ptr<alloc::bpool_base<T>> _make_bpool() const;
+  // placement_policy::buddy: n > 1 blocks live in their own segments, holes left by them are reused
+  std::forward_list<std::unique_ptr<alloc::bpool_base<T>>> _buddies;
+  size_t _buddies_size = 0;
+  unsigned _buddy_sizes = 0; // as _bpool_sizes
+  bool _extend_buddy() noexcept;
+  // power of two, and never too small for the free list links of buddy_bpool
+  static constexpr size_t _buddy_base = std::bit_ceil(std::max(N, OPTIMAL_BPOOL_SEGMENT_ELEMENTS_COUNT));
+  bool _use_buddy(size_t n) const noexcept { return n > 1 && _initial_placement_policy == placement_policy::buddy; }
+  allocation_result<T*> _allocate_buddy(size_t n) noexcept; // the whole block or {nullptr, 0}, _used_count is the caller's
 public:
-  bpool_alloc(placement_policy ipp = placement_policy::first) noexcept : _initial_placement_policy(ipp) {
+  // budget: segments are made only while their slots fit in it (memory_budget.hpp), nullptr for no limit
+  bpool_alloc(placement_policy ipp = placement_policy::first, segment_backend backend = segment_backend::heap,
+              memory_budget *budget = nullptr) noexcept
+      : _initial_placement_policy(ipp), _backend(backend), _budget(budget) {
     // TRACE(__PRETTY_FUNCTION__);
   }
+  // Profile guided: the placement policy of the last run (fallback for a tag new to the profile), the segments of its
+  // peak made by the first extension, and this run recorded to sizing for the next one
+  explicit bpool_alloc(sizing_record &sizing, placement_policy fallback = placement_policy::first,
+                       segment_backend backend = segment_backend::heap, memory_budget *budget = nullptr) noexcept
+      : bpool_alloc(sizing.policy_or(fallback), backend, budget) {
+    _sizing = &sizing;
+  }
   bpool_alloc(const bpool_alloc &) = delete; // ? deep copy
-  bpool_alloc(bpool_alloc && other) noexcept {
+  bpool_alloc(bpool_alloc && other) noexcept
+      : _initial_placement_policy(other._initial_placement_policy), _backend(other._backend), _budget(other._budget),
+        _sizing(other._sizing) {
     // TRACE(__PRETTY_FUNCTION__);
+    std::swap(_charged, other._charged);
     std::swap(_bpools, other._bpools);
-    std::swap(_initial_placement_policy, other._initial_placement_policy);
     std::swap(_bpools_size, other._bpools_size);
+    std::swap(_bpool_sizes, other._bpool_sizes);
+    std::swap(_buddies, other._buddies);
+    std::swap(_buddies_size, other._buddies_size);
+    std::swap(_buddy_sizes, other._buddy_sizes);
+    std::swap(_used_count, other._used_count);
+    std::swap(_sized_blocks, other._sized_blocks);
+    std::swap(_stats, other._stats);
   }
   bpool_alloc &operator=(const bpool_alloc &) = delete; // ? deep copy
+  ~bpool_alloc() {
+    if (_budget != nullptr)
+      _budget->refund(_charged);
+  }
 
+  // rebound copies get their own (empty) pools, but keep the placement policy, the segment backend, the budget and
+  // the sizing record
   template <class U>
-  bpool_alloc(bpool_alloc<U, N> const&) noexcept {
+  bpool_alloc(bpool_alloc<U, N> const& other) noexcept
+      : _initial_placement_policy(other._initial_placement_policy), _backend(other._backend), _budget(other._budget),
+        _sizing(other._sizing) {
     // TRACE(__PRETTY_FUNCTION__);
   }
+  template <class U, size_t M> friend struct bpool_alloc;
 
   template <class Up> struct rebind { 
     using other = bpool_alloc<Up, N>;
   };
 
   T *allocate(size_t n = 1) 
+  {
+    TRACE_FMT("n={} used={}", n, _used_count);
+    if (auto ptr = try_allocate(n); ptr != nullptr)
+      return ptr;
+    throw std::bad_alloc();
+  }
+
+  // allocate without the exception: nullptr once the segments are exhausted (or there is no memory for the next one),
+  // so a caller with another allocator to go to (fallback_allocator, composite_alloc.hpp) does not unwind for it
+  T *try_allocate(size_t n = 1) noexcept
+  {
+    return _try_allocate(n, false);
+  }
+
+  // n single slots next to each other: try_allocate(n), but deallocate(ptr, 1) frees any slot of the run on its own
+  // and the sizing record counts n allocations of a slot (node containers taking their nodes in bulk,
+  // slist::parallel_append). nullptr if no segment has n free slots in a row (no segment is made for it: reserve
+  // first), and always under placement_policy::buddy, where the run would be one buddy block.
+  T *try_allocate_slots(size_t n) noexcept
+  {
+    if (!allocates_slots())
+      return nullptr;
+    return _try_allocate(n, true);
+  }
+  // false: try_allocate_slots always returns nullptr, the caller may as well allocate slot by slot
+  bool allocates_slots() const noexcept { return _initial_placement_policy != placement_policy::buddy; }
+
+  // hinted overload, picked up by std::allocator_traits<>::allocate(a, n, hint):
+  // places the block right after hint when its segment has room there
+  T *allocate(size_t n, const void *hint)
   {
     // TRACE(__PRETTY_FUNCTION__);
-    if (n >  N * (1 << (_bpools_size + 1)) ) throw std::bad_alloc();
+    if (_use_buddy(n))
+      return allocate(n);
+    if (auto phint = static_cast<const T*>(hint); phint != nullptr)
+      for(auto& bp: _bpools)
+        if (bp->contains(phint, 1)){
+          if (auto ptr = bp->allocate_near(n, phint); ptr != nullptr){
+            _count_allocate(n);
+            return ptr;
+          }
+          break;
+        }
+    return allocate(n);
+  }
+
+  // C++23 allocate_at_least: allocate(n) that reports every slot it handed out, count >= n, so growing
+  // containers can use them as capacity. deallocate(ptr, count) (or any try_expand-ed size) frees them.
+  allocation_result<T*> allocate_at_least(size_t n)
+  {
+    TRACE_FMT("n={} used={}", n, _used_count);
+    if (n == 1 && _initial_placement_policy == placement_policy::buddy)
+      return {allocate(1), 1};  // a longer run would be freed as a buddy block
+    if (_use_buddy(n)){
+      auto r = _allocate_buddy(n);
+      if (r.ptr == nullptr)
+        throw std::bad_alloc();
+      _count_allocate(r.count);
+      return r;
+    }
+    if (n >  N * (size_t{1} << (std::bit_width(_bpool_sizes) + 1)) ) throw std::bad_alloc();
     for(auto& bp: _bpools)
-        if (auto ptr = bp->allocate(n); ptr != nullptr)
-          return ptr;
-    _extend_bpool(); // todo: + n
-    if (auto ptr = _bpools.front()->allocate(n); ptr != nullptr)
-          return ptr;
+        if (auto r = bp->allocate_at_least(n); r.ptr != nullptr){
+          _count_allocate(r.count);
+          return r;
+        }
+    if (!_extend_bpool())
+      throw std::bad_alloc();
+    if (auto r = _bpools.front()->allocate_at_least(n); r.ptr != nullptr){
+          _count_allocate(r.count);
+          return r;
+    }
     throw std::bad_alloc();
   }
 
+  // Grows the block [ptr, ptr + old_n) from allocate to new_n slots without moving it, if the slots after it
+  // are free; false leaves the block as it was. Never crosses segments (or buddy / single slot ones).
+  bool try_expand(T *ptr, size_t old_n, size_t new_n) noexcept
+  {
+    if (_use_buddy(old_n) != _use_buddy(new_n))
+      return false;
+    for(auto& bp : _use_buddy(old_n) ? _buddies : _bpools)
+        if (bp->contains(ptr, old_n)){
+          if (!bp->try_expand(ptr, old_n, new_n))
+            return false;
+          _used_count += new_n - old_n;
+          return true;
+        }
+    return false;
+  }
+
   void deallocate(T *ptr, std::size_t n = 1) {
-    // TRACE(__PRETTY_FUNCTION__);
-    for(auto& bp : _bpools)
+    TRACE_FMT("{} n={} used={}", static_cast<const void *>(ptr), n, _used_count);
+    for(auto& bp : _use_buddy(n) ? _buddies : _bpools)
         if (bp->contains(ptr, n)){
           bp->deallocate(ptr, n);
+          _used_count -= n;
+          if (_sizing != nullptr) {
+            --_sized_blocks;
+            _sizing->on_free();
+          }
           return;
         }
     throw_with_trace(std::out_of_range(std::format("{}", __PRETTY_FUNCTION__)));
@@ -91,11 +258,77 @@ public:
 
   // void shrink(); todo: add clean up
 
+  // Creates segments up front until count slots exist in total (std::bad_alloc past the 31 * N limit),
+  // so the first allocations do not pay for segment creation. prefault also maps their pages now.
+  // Only single slot segments are reserved, buddy segments (n > 1 under placement_policy::buddy) grow on demand.
+  void reserve(size_t count, bool prefault = false) {
+    auto total = [this] {   // recounted: the first extension of a sized allocator makes several segments
+      size_t i = 0;
+      for(const auto& bp: _bpools)
+        i += bp->total_count();
+      return i;
+    };
+    while (total() < count)
+      if (!_extend_bpool())
+        throw std::bad_alloc();
+    if (prefault)
+      for(auto& bp: _bpools)
+        bp->prefault();
+  }
+
+  // Frees every slot of every segment in O(segments), segments are kept for reuse.
+  // Containers owning all the allocations use it instead of per element deallocate (see slist::clear).
+  void release() noexcept {
+    for(auto& bp: _bpools)
+      bp->release();
+    for(auto& bp: _buddies)
+      bp->release();
+    _used_count = 0;
+    if (_sizing != nullptr)
+      _sizing->on_release(std::exchange(_sized_blocks, 0));
+  }
+
+  // Frees the segments without a slot in use and refunds them to the budget: what the soft limit callback of a
+  // memory_budget asks the other allocators for. The next segments remake the sizes freed, smallest first.
+  // Returns the slot bytes freed.
+  size_t trim() noexcept {
+    size_t slots = 0;
+    auto unused = [&slots](unsigned &sizes, size_t base) {
+      return [&slots, &sizes, base](const auto& bp) {
+        if (bp->free_count() != bp->total_count())
+          return false;
+        slots += bp->total_count();
+        sizes &= ~(1u << (std::bit_width(bp->total_count() / base) - 1));
+        return true;
+      };
+    };
+    _bpools_size -= _bpools.remove_if(unused(_bpool_sizes, N));
+    _buddies_size -= _buddies.remove_if(unused(_buddy_sizes, _buddy_base));
+    _refund(slots);
+    return slots * sizeof(T);
+  }
+
+  memory_budget *budget() const noexcept { return _budget; }
+
+  // p (a block of n) was handed out by this allocator: fallback_allocator routes deallocate with it
+  bool owns(const T *p, size_t n = 1) const noexcept {
+    for(const auto& bp : _use_buddy(n) ? _buddies : _bpools)
+      if (bp->contains(p, n))
+        return true;
+    return false;
+  }
+
+  size_t used_count() const noexcept {
+    return _used_count;
+  }
+
   size_t total_count() const noexcept {
     size_t i = 0;
     for(const auto& bp: _bpools){
       i += bp->total_count();
     }
+    for(const auto& bp: _buddies)
+      i += bp->total_count();
     return i;
   }
 
@@ -104,9 +337,16 @@ public:
     for(const auto& bp: _bpools){
       i += bp->free_count();
     }
+    for(const auto& bp: _buddies)
+      i += bp->free_count();
     return i;
   }
 
+  // placement_policy::adaptive: hits at the cursor, misses and the words they scanned, over all segments so far
+  placement_stats stats() const noexcept {
+    return _stats;
+  }
+
   size_t get_bpools_size() const noexcept {
     return _bpools_size;
   }
@@ -116,40 +356,178 @@ public:
     for(const auto& bp: _bpools){
       ss << bp->repr() << "\n";
     }
+    for(const auto& bp: _buddies)  // free blocks per order
+      ss << "buddy: " << bp->repr() << "\n";
     return ss.str();
   }
 
 };
 
+// bpool_alloc with the placement policy fixed by the type: default constructed in that policy,
+// for std containers that copy (or default construct) their allocator, e.g. std::map(comp, alloc)
+template <class T, size_t N, placement_policy P>
+struct policy_bpool_alloc : bpool_alloc<T, N> {
+  policy_bpool_alloc() noexcept : bpool_alloc<T, N>(P) {}
+  template <class U>
+  policy_bpool_alloc(policy_bpool_alloc<U, N, P> const&) noexcept : policy_bpool_alloc() {}
+
+  template <class Up> struct rebind {
+    using other = policy_bpool_alloc<Up, N, P>;
+  };
+};
+
 template <class T, size_t N>
-void bpool_alloc<T, N>::_extend_bpool(){
+bool bpool_alloc<T, N>::_extend_bpool() noexcept {
   // TRACE(__PRETTY_FUNCTION__);
+  ALLO_PROBE(bpool_alloc_extend_start, this, _bpools_size, _used_count);
   // todo: switch to use next multiple of OPTIMAL_BPOOL_SEGMENT_ELEMENTS_COUNT from N if benchmarks are positive. 
   // constexpr size_t M = ((N + OPTIMAL_BPOOL_SEGMENT_ELEMENTS_COUNT - 1) / OPTIMAL_BPOOL_SEGMENT_ELEMENTS_COUNT) * OPTIMAL_BPOOL_SEGMENT_ELEMENTS_COUNT;
-  switch (_bpools_size){
-    // static extentions
-    case 0:
-      // _bpools.push_front(std::unique_ptr<bpool_base<T>>(new bpool<T, N>(_initial_placement_policy)));
-      _bpools.push_front(std::make_unique<bpool<T, N>>(_initial_placement_policy));
-      break;
-    case 1:
-      _bpools.push_front(std::make_unique<bpool<T, 2*N>>(_initial_placement_policy));
-      break;
-    case 2:
-      _bpools.push_front(std::make_unique<bpool<T, 4*N>>(_initial_placement_policy));
-      break;
-    case 3:
-      _bpools.push_front(std::make_unique<bpool<T, 8*N>>(_initial_placement_policy));
-      break;
-    case 4:
-      _bpools.push_front(std::make_unique<bpool<T, 16*N>>(_initial_placement_policy));
-      break;
-    // ...
-    default:
-      // todo: add support for dynamic extention of n depended 
-      throw std::bad_alloc();
+  const int k = std::countr_one(_bpool_sizes); // the smallest size missing, trim() may have freed it
+  const size_t slots = N << k; // of the segment made below
+  if (k < 5 && !_charge(slots)) {
+    ALLO_PROBE(bpool_alloc_exhausted, this, _bpools_size, _used_count);
+    return false;
+  }
+  try {
+    switch (k){
+      // static extentions
+      case 0:
+        // _bpools.push_front(std::unique_ptr<bpool_base<T>>(new bpool<T, N>(_initial_placement_policy)));
+        _bpools.push_front(_make_bpool<N>());
+        break;
+      case 1:
+        _bpools.push_front(_make_bpool<2*N>());
+        break;
+      case 2:
+        _bpools.push_front(_make_bpool<4*N>());
+        break;
+      case 3:
+        _bpools.push_front(_make_bpool<8*N>());
+        break;
+      case 4:
+        _bpools.push_front(_make_bpool<16*N>());
+        break;
+      // ...
+      default:
+        // todo: add support for dynamic extention of n depended 
+        ALLO_PROBE(bpool_alloc_exhausted, this, _bpools_size, _used_count);
+        return false;
+    }
+  } catch (const std::bad_alloc&) { // the segment itself
+    _refund(slots);
+    return false;
   }
   ++_bpools_size;
+  _bpool_sizes |= 1u << k;
+  ALLO_PROBE(bpool_alloc_extend_done, this, _bpools_size, _bpools.front()->total_count());
+  if (_bpools_size == 1 && _sizing != nullptr) // the segments of the last run's peak, up front
+    while (total_count() * sizeof(T) < _sizing->presize_bytes && _extend_bpool()) {}
+  return true;
+}
+
+template <class T, size_t N>
+T *bpool_alloc<T, N>::_try_allocate(size_t n, bool slots) noexcept {
+  if (_use_buddy(n)){
+    auto ptr = _allocate_buddy(n).ptr;
+    if (ptr != nullptr)
+      _count_allocate(n, slots);
+    return ptr;
+  }
+  if (n >  N * (size_t{1} << (std::bit_width(_bpool_sizes) + 1)) ) return nullptr;
+  if (_initial_placement_policy == placement_policy::adaptive){
+    for(auto& bp: _bpools)
+      if (auto ptr = bp->allocate_adaptive(n, _stats, false); ptr != nullptr){
+        _count_allocate(n, slots);
+        return ptr;
+      }
+    return _extend_or_refill(n, slots);
+  }
+  for(auto& bp: _bpools)
+      if (auto ptr = bp->allocate(n); ptr != nullptr){
+        _count_allocate(n, slots);
+        return ptr;
+      }
+  if (slots || !_extend_bpool()) // runs of slots only from the segments there are, todo: + n
+    return nullptr;
+  if (auto ptr = _bpools.front()->allocate(n); ptr != nullptr){
+        _count_allocate(n, slots);
+        return ptr;
+  }
+  return nullptr;
+}
+
+template <class T, size_t N>
+T *bpool_alloc<T, N>::_extend_or_refill(size_t n, bool slots) noexcept {
+  T *ptr = !slots && _extend_bpool() ? _bpools.front()->allocate_adaptive(n, _stats, false) : nullptr;
+  for(auto it = _bpools.begin(); ptr == nullptr && it != _bpools.end(); ++it)
+    ptr = (*it)->allocate_adaptive(n, _stats, true);
+  if (ptr != nullptr)
+    _count_allocate(n, slots);
+  return ptr;
+}
+
+template <class T, size_t N>
+template <size_t M>
+std::unique_ptr<alloc::bpool_base<T>> bpool_alloc<T, N>::_make_bpool() const {
+  if constexpr (lazy_bpool<T, M>::pool_bytes >= 2 * BPOOL_COMMIT_CHUNK)
+    if (_backend == segment_backend::lazy)
+      return std::make_unique<lazy_bpool<T, M>>(_initial_placement_policy);
+  return std::make_unique<bpool<T, M>>(_initial_placement_policy);
+}
+
+template <class T, size_t N>
+allocation_result<T*> bpool_alloc<T, N>::_allocate_buddy(size_t n) noexcept {
+  for(auto& bp: _buddies)
+    if (auto r = bp->allocate_at_least(n); r.ptr != nullptr)
+      return r;
+  do
+    if (!_extend_buddy())
+      return {nullptr, 0};
+  while (_buddies.front()->total_count() < n);
+  if (auto r = _buddies.front()->allocate_at_least(n); r.ptr != nullptr)
+    return r;
+  return {nullptr, 0};
+}
+
+template <class T, size_t N>
+bool bpool_alloc<T, N>::_extend_buddy() noexcept {
+  constexpr size_t B = _buddy_base;
+  ALLO_PROBE(bpool_alloc_extend_buddy_start, this, _buddies_size, _used_count);
+  const int k = std::countr_one(_buddy_sizes);
+  const size_t slots = B << k;
+  if (k < 5 && !_charge(slots)) {
+    ALLO_PROBE(bpool_alloc_exhausted, this, _buddies_size, _used_count);
+    return false;
+  }
+  try {
+    switch (k){
+      case 0:
+        _buddies.push_front(std::make_unique<buddy_bpool<T, B>>());
+        break;
+      case 1:
+        _buddies.push_front(std::make_unique<buddy_bpool<T, 2*B>>());
+        break;
+      case 2:
+        _buddies.push_front(std::make_unique<buddy_bpool<T, 4*B>>());
+        break;
+      case 3:
+        _buddies.push_front(std::make_unique<buddy_bpool<T, 8*B>>());
+        break;
+      case 4:
+        _buddies.push_front(std::make_unique<buddy_bpool<T, 16*B>>());
+        break;
+      default:
+        ALLO_PROBE(bpool_alloc_exhausted, this, _buddies_size, _used_count);
+        return false;
+    }
+  } catch (const std::bad_alloc&) {
+    _refund(slots);
+    return false;
+  }
+  ++_buddies_size;
+  _buddy_sizes |= 1u << k;
+  ALLO_PROBE(bpool_alloc_extend_buddy_done, this, _buddies_size, _buddies.front()->total_count());
+  return true;
 }
 
 } // namespace alloc
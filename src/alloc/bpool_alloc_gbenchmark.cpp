@@ -1,14 +1,24 @@
 #include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <malloc.h>
+#include <memory>
+#include <vector>
 // #include <iostream>
 #include "bpool_alloc.hpp"
+#include "utils/perf_scope.hpp"
 
 /////////////////////////////////////////////////////////////////////////
 constexpr static size_t optimal_max_count = alloc::OPTIMAL_BPOOL_SEGMENT_ELEMENTS_COUNT;
+// allocate + deallocate calls per iteration, perf counters are reported per call
+constexpr static size_t linear_ops = 2 * optimal_max_count;
+constexpr static size_t optimum_mix_ops = optimal_max_count / 2 + optimal_max_count / 4 + optimal_max_count / 2 - 1;
 
 static void BM_vector_std_alloc_optimum_linear_monotonic(benchmark::State& state)
 {
     std::vector<int*> vpi;
     vpi.reserve(optimal_max_count);
+    utils::perf_scope perf(state, linear_ops);
     for(auto _: state)
     {
         auto alloc = std::allocator<int>();
@@ -27,6 +37,7 @@ static void BM_vector_bpool_alloc_optimum_first_linear_monotonic(benchmark::Stat
 {
     std::vector<int*> vpi;
     vpi.reserve(optimal_max_count);
+    utils::perf_scope perf(state, linear_ops);
     for(auto _: state)
     {
         auto alloc = alloc::bpool_alloc<int, optimal_max_count>(alloc::placement_policy::first);
@@ -46,6 +57,7 @@ static void BM_vector_bpool_alloc_optimum_last_linear_monotonic(benchmark::State
 {
     std::vector<int*> vpi;
     vpi.reserve(optimal_max_count);
+    utils::perf_scope perf(state, linear_ops);
     for(auto _: state)
     {
         auto alloc = alloc::bpool_alloc<int, optimal_max_count>(alloc::placement_policy::last);
@@ -61,11 +73,32 @@ static void BM_vector_bpool_alloc_optimum_last_linear_monotonic(benchmark::State
 }
 BENCHMARK(BM_vector_bpool_alloc_optimum_last_linear_monotonic);
 
+static void BM_vector_bpool_alloc_optimum_adaptive_linear_monotonic(benchmark::State& state)
+{
+    std::vector<int*> vpi;
+    vpi.reserve(optimal_max_count);
+    utils::perf_scope perf(state, linear_ops);
+    for(auto _: state)
+    {
+        auto alloc = alloc::bpool_alloc<int, optimal_max_count>(alloc::placement_policy::adaptive);
+        for (size_t i = 0; i < optimal_max_count; i++)
+            vpi.push_back(alloc.allocate(1));
+        for (auto pi: vpi)
+        {
+            alloc.deallocate(pi, 1);
+        }
+        // std::cout << alloc.get_bpools_size() << "\n";        
+        vpi.clear();
+    }
+}
+BENCHMARK(BM_vector_bpool_alloc_optimum_adaptive_linear_monotonic);
+
 ///////////////////////////////////////////////////////////
 static void BM_vector_std_alloc_optimum_mix(benchmark::State& state)
 {
     std::vector<int*> vpi;
     vpi.reserve(optimal_max_count);
+    utils::perf_scope perf(state, optimum_mix_ops);
     for(auto _: state)
     {
         auto alloc = std::allocator<int>();
@@ -84,6 +117,7 @@ static void BM_vector_bpool_alloc_optimum_first_mix(benchmark::State& state)
 {
     std::vector<int*> vpi;
     vpi.reserve(optimal_max_count);
+    utils::perf_scope perf(state, optimum_mix_ops);
     for(auto _: state)
     {
         auto alloc = alloc::bpool_alloc<int, optimal_max_count>(alloc::placement_policy::first);
@@ -102,6 +136,7 @@ static void BM_vector_bpool_alloc_optimum_last_mix(benchmark::State& state)
 {
     std::vector<int*> vpi;
     vpi.reserve(optimal_max_count);
+    utils::perf_scope perf(state, optimum_mix_ops);
     for(auto _: state)
     {
         auto alloc = alloc::bpool_alloc<int, optimal_max_count>(alloc::placement_policy::last);
@@ -116,12 +151,33 @@ static void BM_vector_bpool_alloc_optimum_last_mix(benchmark::State& state)
 }
 BENCHMARK(BM_vector_bpool_alloc_optimum_last_mix);
 
+static void BM_vector_bpool_alloc_optimum_adaptive_mix(benchmark::State& state)
+{
+    std::vector<int*> vpi;
+    vpi.reserve(optimal_max_count);
+    utils::perf_scope perf(state, optimum_mix_ops);
+    for(auto _: state)
+    {
+        auto alloc = alloc::bpool_alloc<int, optimal_max_count>(alloc::placement_policy::adaptive);
+        for (size_t i = 0; i < optimal_max_count / 2; i++)
+            vpi.push_back(alloc.allocate(1));
+        for (size_t i = 0; i < optimal_max_count / 2; i += 2)
+            alloc.deallocate(vpi[i], 1);
+        for (size_t i = optimal_max_count / 2 + 1; i < optimal_max_count; i++)
+            vpi.push_back(alloc.allocate(1));
+        vpi.clear();
+    }
+}
+BENCHMARK(BM_vector_bpool_alloc_optimum_adaptive_mix);
+
 ///////////////////////////////////////////////////////////
 constexpr static size_t freestyle_max_count = 1024;
+constexpr static size_t freestyle_mix_ops = freestyle_max_count / 2 + freestyle_max_count / 4 + freestyle_max_count / 2 - 1;
 
 static void BM_vector_std_alloc_freestyle_mix(benchmark::State& state)
 {
     std::vector<int*> vpi;
+    utils::perf_scope perf(state, freestyle_mix_ops);
     for(auto _: state)
     {
         auto alloc = std::allocator<int>();
@@ -139,6 +195,7 @@ BENCHMARK(BM_vector_std_alloc_freestyle_mix);
 static void BM_vector_bpool_alloc_freestyle_first_mix(benchmark::State& state)
 {  
     std::vector<int*> vpi;
+    utils::perf_scope perf(state, freestyle_mix_ops);
     for(auto _: state)
     {
         auto alloc = alloc::bpool_alloc<int>(alloc::placement_policy::first);
@@ -156,6 +213,7 @@ BENCHMARK(BM_vector_bpool_alloc_freestyle_first_mix);
 static void BM_vector_bpool_alloc_freestyle_last_mix(benchmark::State& state)
 {
     std::vector<int*> vpi;
+    utils::perf_scope perf(state, freestyle_mix_ops);
     for(auto _: state)
     {
         auto alloc = alloc::bpool_alloc<int>(alloc::placement_policy::last);
@@ -170,6 +228,264 @@ static void BM_vector_bpool_alloc_freestyle_last_mix(benchmark::State& state)
 }
 BENCHMARK(BM_vector_bpool_alloc_freestyle_last_mix);
 
+static void BM_vector_bpool_alloc_freestyle_adaptive_mix(benchmark::State& state)
+{
+    std::vector<int*> vpi;
+    utils::perf_scope perf(state, freestyle_mix_ops);
+    for(auto _: state)
+    {
+        auto alloc = alloc::bpool_alloc<int>(alloc::placement_policy::adaptive);
+        for (size_t i = 0; i < freestyle_max_count / 2; i++)
+            vpi.push_back(alloc.allocate(1));
+        for (size_t i = 0; i < freestyle_max_count / 2; i += 2)
+            alloc.deallocate(vpi[i], 1);
+        for (size_t i = freestyle_max_count / 2 + 1; i < freestyle_max_count; i++)
+            vpi.push_back(alloc.allocate(1));
+        vpi.clear();
+    }
+}
+BENCHMARK(BM_vector_bpool_alloc_freestyle_adaptive_mix);
+
+/////////////////////////////////////////////////////////////////////////
+// A service with a known working set of range(1) slots: segments grown lazily on demand (0),
+// reserved at startup (1) or reserved and prefaulted (2). startup times the allocator setup,
+// first_request the first working set allocations right after it.
+// Fixed mmap threshold: every segment is fresh memory, as it is in a starting process
+// (glibc would otherwise keep freed segments around between iterations).
+struct ws_node { size_t v[4]; };
+constexpr static size_t ws_segment = 1 << 14;
+using ws_alloc = alloc::bpool_alloc<ws_node, ws_segment>;
+
+static void ws_setup(ws_alloc& a, int64_t mode, size_t count)
+{
+    if (mode > 0)
+        a.reserve(count, mode == 2);
+}
+
+static void BM_bpool_alloc_startup(benchmark::State& state)
+{
+    mallopt(M_MMAP_THRESHOLD, 128 * 1024);
+    const auto count = static_cast<size_t>(state.range(1));
+    for (auto _: state)
+    {
+        auto a = std::make_unique<ws_alloc>(alloc::placement_policy::last);
+        ws_setup(*a, state.range(0), count);
+        benchmark::DoNotOptimize(a.get());
+        state.PauseTiming();
+        a.reset();
+        state.ResumeTiming();
+    }
+}
+
+static void BM_bpool_alloc_first_request(benchmark::State& state)
+{
+    mallopt(M_MMAP_THRESHOLD, 128 * 1024);
+    const auto count = static_cast<size_t>(state.range(1));
+    std::vector<ws_node*> nodes;
+    nodes.reserve(count);
+    for (auto _: state)
+    {
+        state.PauseTiming();
+        auto a = std::make_unique<ws_alloc>(alloc::placement_policy::last);
+        ws_setup(*a, state.range(0), count);
+        state.ResumeTiming();
+        for (size_t i = 0; i < count; ++i)
+            nodes.push_back(new(a->allocate()) ws_node{{i}});
+        benchmark::DoNotOptimize(nodes.data());
+        state.PauseTiming();
+        nodes.clear();
+        a.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void ws_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"mode", "count"});
+    for (int64_t count: {int64_t(ws_segment), int64_t(ws_segment) * 7, int64_t(ws_segment) * 31})
+        for (int64_t mode: {0, 1, 2})
+            b->Args({mode, count});
+}
+BENCHMARK(BM_bpool_alloc_startup)->Apply(ws_args)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_bpool_alloc_first_request)->Apply(ws_args)->Unit(benchmark::kMicrosecond);
+
+// Vector growth churn: churn_vectors arrays grow by doubling (allocate 2x, copy, free the old block) up to random
+// sizes and are dropped again, all from one allocator. Under last the freed blocks left behind the tail are not
+// reused and the segments run out; first reuses them but scans bitmaps for n free bits; buddy keeps them in
+// per size free lists. Segments are never released back, so std::bad_alloc ends a run (reported as an error).
+constexpr static size_t churn_segment = 1 << 10;
+constexpr static size_t churn_vectors = 8;
+constexpr static size_t churn_max_size = 1000;
+
+template <class Alloc>
+static void vector_churn(benchmark::State& state, Alloc& a)
+{
+    struct array { int* data = nullptr; size_t size = 0, capacity = 0; };
+    std::array<array, churn_vectors> vs{};
+    uint64_t x = 88172645463325252ull;              // xorshift, same sequence for every allocator
+    auto next = [&x]{ x ^= x << 13; x ^= x >> 7; x ^= x << 17; return x; };
+    size_t reallocations = 0;
+    utils::perf_scope perf(state);                 // per iteration: a vector grown or dropped
+    try {
+        for(auto _: state)
+        {
+            auto& v = vs[next() % churn_vectors];
+            if (v.data != nullptr && next() % 4 == 0) {
+                a.deallocate(v.data, v.capacity);
+                v = array{};
+                continue;
+            }
+            for (size_t target = 1 + next() % churn_max_size; v.size < target; ++v.size) {
+                if (v.size == v.capacity) {
+                    size_t capacity = v.capacity ? 2 * v.capacity : 1;
+                    int* data = a.allocate(capacity);
+                    if (v.data != nullptr) {
+                        std::copy(v.data, v.data + v.size, data);
+                        a.deallocate(v.data, v.capacity);
+                    }
+                    v.data = data;
+                    v.capacity = capacity;
+                    ++reallocations;
+                }
+                v.data[v.size] = int(v.size);
+            }
+            benchmark::DoNotOptimize(v.data);
+        }
+    } catch (const std::bad_alloc&) {
+        state.SkipWithError("std::bad_alloc");
+    }
+    for (auto& v: vs)
+        if (v.data != nullptr)
+            a.deallocate(v.data, v.capacity);
+    state.counters["reallocations"] = benchmark::Counter(double(reallocations), benchmark::Counter::kIsRate);
+}
+
+static void BM_vector_churn_std_alloc(benchmark::State& state)
+{
+    std::allocator<int> a;
+    vector_churn(state, a);
+}
+BENCHMARK(BM_vector_churn_std_alloc);
+
+static void BM_vector_churn_bpool_alloc(benchmark::State& state)
+{
+    alloc::bpool_alloc<int, churn_segment> a(static_cast<alloc::placement_policy>(state.range(0)));
+    vector_churn(state, a);
+    state.counters["segments"] = double(a.get_bpools_size());
+    state.counters["slots"] = double(a.total_count());
+}
+BENCHMARK(BM_vector_churn_bpool_alloc)
+    ->ArgName("policy")
+    ->Arg(int64_t(alloc::placement_policy::last))
+    ->Arg(int64_t(alloc::placement_policy::first))
+    ->Arg(int64_t(alloc::placement_policy::buddy))
+    ->Arg(int64_t(alloc::placement_policy::adaptive));
+
+// Cost per allocate / deallocate call by placement policy and segment size, with the perf counters
+// (utils/perf_scope.hpp) as the per call summary: a fresh allocator per iteration (as above), ops_count
+// slots allocated, every other one freed and allocated again, then all of them freed. Smaller segments
+// mean more of them to walk, larger ones longer bitmap scans for first.
+constexpr static size_t ops_count = 1 << 12;
+
+template <class Make>
+static void alloc_ops(benchmark::State& state, Make make)
+{
+    std::vector<int*> vpi(ops_count);
+    size_t segments = 0;
+    utils::perf_scope perf(state, 3 * ops_count);
+    for(auto _: state)
+    {
+        auto a = make();
+        for (auto& p: vpi)
+            p = a.allocate(1);
+        for (size_t i = 0; i < ops_count; i += 2)
+            a.deallocate(vpi[i], 1);
+        for (size_t i = 0; i < ops_count; i += 2)
+            vpi[i] = a.allocate(1);
+        if constexpr (requires { a.get_bpools_size(); })
+            segments = a.get_bpools_size();
+        for (auto p: vpi)
+            a.deallocate(p, 1);
+    }
+    state.SetItemsProcessed(state.iterations() * 3 * ops_count);
+    if (segments != 0)
+        state.counters["segments"] = double(segments);
+}
+
+static void BM_ops_std_alloc(benchmark::State& state)
+{
+    alloc_ops(state, []{ return std::allocator<int>(); });
+}
+BENCHMARK(BM_ops_std_alloc);
+
+template <size_t N>
+static void BM_ops_bpool_alloc(benchmark::State& state)
+{
+    auto policy = static_cast<alloc::placement_policy>(state.range(0));
+    alloc_ops(state, [policy]{ return alloc::bpool_alloc<int, N>(policy); });
+}
+static void ops_policies(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("policy")
+        ->Arg(int64_t(alloc::placement_policy::last))
+        ->Arg(int64_t(alloc::placement_policy::first))
+        ->Arg(int64_t(alloc::placement_policy::buddy))
+        ->Arg(int64_t(alloc::placement_policy::adaptive));
+}
+BENCHMARK_TEMPLATE(BM_ops_bpool_alloc, 256)->Apply(ops_policies);
+BENCHMARK_TEMPLATE(BM_ops_bpool_alloc, 1024)->Apply(ops_policies);
+BENCHMARK_TEMPLATE(BM_ops_bpool_alloc, 4096)->Apply(ops_policies);
+
+// Phase changing service: one allocator for the whole run, each iteration fills the live set up to
+// phases_live slots (monotonic, last's case), replaces random slots one by one (churn, holes everywhere,
+// first's case) and drops all but one in 16 slots, which stay into the next iteration. last leaves the
+// holes behind its cursor and runs out of segments (reported as an error), first scans from the start
+// in every phase, adaptive bumps while the run at its cursor is free and scans only when it is not.
+constexpr static size_t phases_live = 1 << 12;
+constexpr static size_t phases_segment = 1 << 10;
+
+static void BM_phases_bpool_alloc(benchmark::State& state)
+{
+    alloc::bpool_alloc<int, phases_segment> a(static_cast<alloc::placement_policy>(state.range(0)));
+    std::vector<int*> live;
+    live.reserve(phases_live);
+    uint64_t x = 88172645463325252ull;
+    auto next = [&x]{ x ^= x << 13; x ^= x >> 7; x ^= x << 17; return x; };
+    size_t ops = 0;
+    try {
+        utils::perf_scope perf(state, double(phases_live) * 3);
+        for(auto _: state)
+        {
+            while (live.size() < phases_live)
+                live.push_back(a.allocate());
+            for (size_t i = 0; i < phases_live; ++i) {
+                auto& p = live[next() % phases_live];
+                a.deallocate(p);
+                p = a.allocate();
+            }
+            size_t kept = 0;
+            for (size_t i = 0; i < live.size(); ++i)
+                if (i % 16 == 0) live[kept++] = live[i]; else a.deallocate(live[i]);
+            live.resize(kept);
+            ops += 3 * phases_live;
+        }
+    } catch (const std::bad_alloc&) {
+        state.SkipWithError("std::bad_alloc");
+    }
+    for (auto p: live)
+        a.deallocate(p);
+    state.SetItemsProcessed(int64_t(ops));
+    state.counters["segments"] = double(a.get_bpools_size());
+    if (auto s = a.stats(); s.hits + s.misses > 0)
+        state.counters["hit_rate"] = double(s.hits) / double(s.hits + s.misses);
+}
+BENCHMARK(BM_phases_bpool_alloc)
+    ->ArgName("policy")
+    ->Arg(int64_t(alloc::placement_policy::last))
+    ->Arg(int64_t(alloc::placement_policy::first))
+    ->Arg(int64_t(alloc::placement_policy::adaptive));
+
 BENCHMARK_MAIN();
 
 /*
@@ -201,4 +517,97 @@ BM_vector_bpool_alloc_optimum_last_mix                      710 ns          710
 BM_vector_std_alloc_freestyle_mix                         94234 ns        93954 ns        16736
 BM_vector_bpool_alloc_freestyle_first_mix                 30013 ns        30011 ns        23364
 BM_vector_bpool_alloc_freestyle_last_mix                  27251 ns        27249 ns        25454
-*/
\ No newline at end of file
+*/
+/*
+Startup / first request, run on (1 X 2100 MHz CPU s), -O2, 32 byte slots, N = 2^14.
+Creating segments is cheap (new of untouched memory), page faults are what the first request pays:
+reserve alone barely moves it, reserve + prefault halves it and moves the fault cost to startup.
+-------------------------------------------------------------------------------------------
+Benchmark                                                 Time             CPU   Iterations
+-------------------------------------------------------------------------------------------
+BM_bpool_alloc_startup/mode:0/count:16384             0.289 us        0.288 us      2448008
+BM_bpool_alloc_startup/mode:1/count:16384              4.56 us         4.36 us       161149
+BM_bpool_alloc_startup/mode:2/count:16384               136 us          135 us         5475
+BM_bpool_alloc_startup/mode:0/count:114688            0.298 us        0.294 us      2417299
+BM_bpool_alloc_startup/mode:1/count:114688             16.0 us         15.4 us        44107
+BM_bpool_alloc_startup/mode:2/count:114688              990 us          978 us          731
+BM_bpool_alloc_startup/mode:0/count:507904            0.281 us        0.281 us      2450617
+BM_bpool_alloc_startup/mode:1/count:507904             36.4 us         35.4 us        19148
+BM_bpool_alloc_startup/mode:2/count:507904             5912 us         5849 us          116
+BM_bpool_alloc_first_request/mode:0/count:16384         217 us          215 us         3134 items_per_second=76.1323M/s
+BM_bpool_alloc_first_request/mode:1/count:16384         228 us          223 us         3430 items_per_second=73.4884M/s
+BM_bpool_alloc_first_request/mode:2/count:16384        94.5 us         93.4 us         7891 items_per_second=175.329M/s
+BM_bpool_alloc_first_request/mode:0/count:114688       1677 us         1658 us          378 items_per_second=69.1865M/s
+BM_bpool_alloc_first_request/mode:1/count:114688       1951 us         1926 us          387 items_per_second=59.5511M/s
+BM_bpool_alloc_first_request/mode:2/count:114688        907 us          898 us          787 items_per_second=127.71M/s
+BM_bpool_alloc_first_request/mode:0/count:507904       9843 us         9651 us           72 items_per_second=52.626M/s
+BM_bpool_alloc_first_request/mode:1/count:507904      11043 us        10739 us           67 items_per_second=47.2953M/s
+BM_bpool_alloc_first_request/mode:2/count:507904       4948 us         4899 us          121 items_per_second=103.674M/s
+*/
+/*
+Vector growth churn, run on (1 X 2100 MHz CPU s), -O2, int elements, N = 2^10, 8 arrays up to 1000 elements.
+last runs out of segments, first pays a bitmap scan for every n > 1 block, buddy stays close to malloc
+(segments counts the single slot segments, slots includes the 1024 + 2048 + 4096 + 8192 buddy segments).
+-----------------------------------------------------------------------------------------------
+Benchmark                                     Time             CPU   Iterations UserCounters...
+-----------------------------------------------------------------------------------------------
+BM_vector_churn_std_alloc                   266 ns          263 ns      3534411 reallocations=8.08455M/s
+BM_vector_churn_bpool_alloc/policy:0 ERROR OCCURRED: 'std::bad_alloc'
+BM_vector_churn_bpool_alloc/policy:1      80708 ns        79831 ns         8542 reallocations=26.9374k/s segments=4 slots=15.36k
+BM_vector_churn_bpool_alloc/policy:2        333 ns          329 ns      2084937 reallocations=6.46834M/s segments=1 slots=16.384k
+*/
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2, a VM without PMU access: perf_event_open gives page_faults only, the
+hardware events are reported as missing on stderr and left out of the counters.
+perf_event_open: not counted (no PMU, perf_event_paranoid or seccomp): cycles instructions L1d_misses LLC_misses dTLB_misses branch_misses
+--------------------------------------------------------------------------------------------
+Benchmark                                  Time             CPU   Iterations UserCounters...
+--------------------------------------------------------------------------------------------
+BM_ops_std_alloc                      170565 ns       168731 ns         4012 items_per_second=72.8261M/s page_faults=0
+BM_ops_bpool_alloc<256>/policy:0      129759 ns       128168 ns         5330 items_per_second=95.8741M/s page_faults=0 segments=5
+BM_ops_bpool_alloc<256>/policy:1      193672 ns       191624 ns         4772 items_per_second=64.1255M/s page_faults=0 segments=5
+BM_ops_bpool_alloc<256>/policy:2      129725 ns       127096 ns         5211 items_per_second=96.6829M/s page_faults=0 segments=5
+BM_ops_bpool_alloc<1024>/policy:0     109086 ns       107499 ns         7652 items_per_second=114.308M/s page_faults=0 segments=3
+BM_ops_bpool_alloc<1024>/policy:1     222253 ns       219712 ns         3370 items_per_second=55.9278M/s page_faults=0 segments=3
+BM_ops_bpool_alloc<1024>/policy:2     127355 ns       123984 ns         5516 items_per_second=99.1098M/s page_faults=0 segments=3
+BM_ops_bpool_alloc<4096>/policy:0     119362 ns       118429 ns         5952 items_per_second=103.758M/s page_faults=0 segments=2
+BM_ops_bpool_alloc<4096>/policy:1     283997 ns       282179 ns         2469 items_per_second=43.5468M/s page_faults=0 segments=1
+BM_ops_bpool_alloc<4096>/policy:2      93650 ns        92535 ns         6040 items_per_second=132.793M/s page_faults=0 segments=2
+With a PMU the same rows carry cycles, instructions, IPC, L1d/LLC/dTLB and branch misses per call.
+*/
+
+/*
+Adaptive placement, run on (1 X 2100 MHz CPU s), -O2, medians of 8 randomly interleaved repetitions (this VM is noisy,
++-15% between runs). In the free tail of a segment a hit is last's bounds check, the bitmap is only read at the cursor
+once it moved back into a freed region. Holes: adaptive refills them at about the cost of a bump (hit_rate: share of
+allocations taken at the cursor) where first scans from the start. Segments at most half free are left alone while
+a new one can be made, so freestyle and ops bump through a new segment as last does; churn and phases run where last
+throws. Not met: "at least as fast as the better static policy on every pattern". freestyle is 4% behind last here,
+two other runs put it level with last and 10% ahead; the earlier build (bitmap read on every hit) was 6-10% behind last on all three
+bump patterns.
+----------------------------------------------------------------------------------------------------------------
+Benchmark                                                      Time             CPU   Iterations UserCounters...
+----------------------------------------------------------------------------------------------------------------
+BM_vector_bpool_alloc_optimum_first_linear_monotonic_median     1074 ns         1066 ns            8
+BM_vector_bpool_alloc_optimum_last_linear_monotonic_median      1058 ns         1049 ns            8
+BM_vector_bpool_alloc_optimum_adaptive_linear_monotonic_median   990 ns          981 ns            8
+BM_vector_bpool_alloc_optimum_first_mix_median                   809 ns          803 ns            8
+BM_vector_bpool_alloc_optimum_last_mix_median                    723 ns          716 ns            8
+BM_vector_bpool_alloc_optimum_adaptive_mix_median                665 ns          657 ns            8
+BM_vector_bpool_alloc_freestyle_first_mix_median               16291 ns        16163 ns            8
+BM_vector_bpool_alloc_freestyle_last_mix_median                11878 ns        11695 ns            8
+BM_vector_bpool_alloc_freestyle_adaptive_mix_median            12400 ns        12285 ns            8
+BM_vector_churn_bpool_alloc/policy:0                  ERROR OCCURRED: 'std::bad_alloc'
+BM_vector_churn_bpool_alloc/policy:1_median                    64826 ns        64342 ns            8 segments=4 slots=15.36k
+BM_vector_churn_bpool_alloc/policy:3_median                    18757 ns        18604 ns            8 segments=5 slots=31.744k
+BM_ops_bpool_alloc<256>/policy:0_median                       121453 ns       117316 ns            8 segments=5
+BM_ops_bpool_alloc<256>/policy:1_median                       207793 ns       200305 ns            8 segments=5
+BM_ops_bpool_alloc<256>/policy:3_median                       111776 ns       110253 ns            8 segments=5
+BM_ops_bpool_alloc<4096>/policy:0_median                      103283 ns       102515 ns            8 segments=2
+BM_ops_bpool_alloc<4096>/policy:1_median                      290924 ns       288364 ns            8 segments=1
+BM_ops_bpool_alloc<4096>/policy:3_median                       92233 ns        91189 ns            8 segments=2
+BM_phases_bpool_alloc/policy:0                        ERROR OCCURRED: 'std::bad_alloc'
+BM_phases_bpool_alloc/policy:1_median                         381978 ns       378592 ns            8 segments=3
+BM_phases_bpool_alloc/policy:3_median                         178802 ns       176620 ns            8 hit_rate=0.8174 segments=4
+*/
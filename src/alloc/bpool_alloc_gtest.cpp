@@ -1,3 +1,4 @@
+#include <vector>
 #include <gtest/gtest.h>
 
 #include "memuse.hpp"
@@ -34,6 +35,155 @@ TEST(alloc_unit_tests, bpool_alloc_ctor){
     EXPECT_EQ(memuse(), initial);    
 }
 
+TEST(alloc_unit_tests, bpool_alloc_reserve){
+    bpool_alloc<double, 4> ba(placement_policy::last);
+    ba.reserve(0);
+    EXPECT_EQ(ba.get_bpools_size(), 0);
+    ba.reserve(10);                                 // 4 + 8 slots
+    EXPECT_EQ(ba.get_bpools_size(), 2);
+    EXPECT_EQ(ba.total_count(), 12);
+    EXPECT_EQ(ba.used_count(), 0);
+    ba.reserve(12, true);                           // enough already, only prefaulted
+    EXPECT_EQ(ba.get_bpools_size(), 2);
+    EXPECT_EQ(ba.free_count(), 12);
+
+    std::vector<double*> ps;
+    for (int i = 0; i < 12; ++i)
+        ps.push_back(ba.allocate());
+    EXPECT_EQ(ba.get_bpools_size(), 2);             // no growth while within the reservation
+    for (auto p: ps)
+        ba.deallocate(p);
+
+    double* live = ba.allocate();
+    *live = 42.5;
+    ba.reserve(12, true);                           // prefault leaves live slots alone
+    EXPECT_EQ(*live, 42.5);
+    ba.deallocate(live);
+
+    EXPECT_THROW(ba.reserve(31 * 4 + 1), std::bad_alloc);
+    EXPECT_EQ(ba.total_count(), 31 * 4);            // all 5 segments were made on the way
+}
+
+TEST(alloc_unit_tests, bpool_alloc_trim){
+    bpool_alloc<double, 4> ba(placement_policy::first);
+    std::vector<double*> first;
+    for (int i = 0; i < 4; ++i)
+        first.push_back(ba.allocate());
+    double* second = ba.allocate(8);
+    double* third = ba.allocate();                  // 4 + 8 + 16 slots
+    EXPECT_EQ(ba.get_bpools_size(), 3);
+    for (auto p: first)
+        ba.deallocate(p);
+    EXPECT_EQ(ba.trim(), 4 * sizeof(double));       // only the first segment is unused
+    EXPECT_EQ(ba.get_bpools_size(), 2);
+    EXPECT_EQ(ba.total_count(), 8 + 16);
+
+    ba.reserve(31 * 4);                             // the 4 slots one made again, not a second 16
+    EXPECT_EQ(ba.get_bpools_size(), 5);
+    EXPECT_EQ(ba.total_count(), 31 * 4);
+    EXPECT_THROW(ba.reserve(31 * 4 + 1), std::bad_alloc);
+    EXPECT_NE(ba.try_allocate(64), nullptr);        // the largest segment is still in reach
+    ba.deallocate(second, 8);
+    ba.deallocate(third);
+}
+
+TEST(alloc_unit_tests, bpool_alloc_buddy){
+    bpool_alloc<double, 4> ba(placement_policy::buddy);
+    double* p1 = ba.allocate();                     // single slots: bitmap segments as last
+    double* p3 = ba.allocate(3);                    // arrays: a 64 slot buddy segment, 4 slot block
+    EXPECT_EQ(ba.get_bpools_size(), 1);
+    EXPECT_EQ(ba.repr(), "___*\nbuddy: 0 0 1 1 1 1 0\n");
+    EXPECT_EQ(ba.used_count(), 4);
+    EXPECT_EQ(ba.total_count(), 4 + 64);
+
+    for (size_t n = 2; n <= 32; ++n)                // churn: every hole is reused, nothing grows
+        ba.deallocate(ba.allocate(n), n);
+    EXPECT_EQ(ba.repr(), "___*\nbuddy: 0 0 1 1 1 1 0\n");
+    double* p64 = ba.allocate(64);                  // does not fit the first one: a 128 slot segment
+    EXPECT_EQ(ba.total_count(), 4 + 64 + 128);
+
+    ba.deallocate(p3, 3);
+    ba.deallocate(p64, 64);
+    ba.deallocate(p1);
+    EXPECT_EQ(ba.used_count(), 0);
+    EXPECT_EQ(ba.free_count(), ba.total_count());
+    EXPECT_THROW(ba.allocate(64 * 16 + 1), std::bad_alloc);
+
+    // vector growth: each reallocation frees the old block for the next ones; the old and the new block
+    // are live together, so 512 is the last capacity doubling that fits 64..1024 slot segments
+    std::vector<int, policy_bpool_alloc<int, 64, placement_policy::buddy>> v;
+    for (int i = 0; i < 500; ++i)
+        v.push_back(i);
+    EXPECT_EQ(v[499], 499);
+    EXPECT_EQ(v.capacity(), 512);
+    v.clear();
+    for (int i = 0; i < 500; ++i)                   // no reallocation, no growth
+        v.push_back(i);
+    EXPECT_EQ(v.capacity(), 512);
+}
+
+TEST(alloc_unit_tests, bpool_alloc_adaptive){
+    // keep one slot in 8, free the rest, refill: last leaves the holes behind its cursor and runs out
+    // of segments, adaptive bumps while it can and takes the holes by first fit when it cannot
+    auto churn = [](bpool_alloc<int, 64>& ba){
+        std::vector<int*> live;
+        for (int round = 0; round < 40; ++round) {
+            while (live.size() < 64)
+                live.push_back(ba.allocate());
+            std::vector<int*> kept;
+            for (size_t i = 0; i < live.size(); ++i)
+                if (i % 8 == 0) kept.push_back(live[i]); else ba.deallocate(live[i]);
+            live = kept;
+        }
+        return live.size();
+    };
+    bpool_alloc<int, 64> last(placement_policy::last);
+    EXPECT_THROW(churn(last), std::bad_alloc);
+    bpool_alloc<int, 64> adaptive(placement_policy::adaptive);
+    EXPECT_EQ(churn(adaptive), 8);
+    EXPECT_EQ(adaptive.used_count(), 8);
+    EXPECT_LE(adaptive.get_bpools_size(), 2);
+    EXPECT_GT(adaptive.stats().hits, 0);
+    EXPECT_GT(adaptive.stats().misses, 0);
+    EXPECT_EQ(last.stats().hits, 0);                // counted for adaptive only
+
+    // every other slot freed: holes that sparse are left alone while a segment can be made, refilled after
+    bpool_alloc<int, 4> sparse(placement_policy::adaptive);
+    std::vector<int*> v;
+    for (int i = 0; i < 12; ++i)
+        v.push_back(sparse.allocate());             // segments of 4 and 8
+    for (int i = 0; i < 12; i += 2)
+        sparse.deallocate(v[i]);
+    sparse.allocate();
+    EXPECT_EQ(sparse.get_bpools_size(), 3);
+    while (sparse.used_count() < 4 + 8 + 16 + 32 + 64)
+        sparse.allocate();
+    EXPECT_EQ(sparse.get_bpools_size(), 5);
+    EXPECT_THROW(sparse.allocate(), std::bad_alloc);
+}
+
+TEST(alloc_unit_tests, bpool_alloc_at_least_expand){
+    bpool_alloc<int, 8> ba(placement_policy::first);
+    auto r = ba.allocate_at_least(3);               // empty segment: 2 n
+    EXPECT_EQ(r.count, 6);
+    EXPECT_EQ(ba.used_count(), 6);
+    EXPECT_TRUE(ba.try_expand(r.ptr, 6, 8));
+    EXPECT_FALSE(ba.try_expand(r.ptr, 8, 9));       // segments are not joined
+    EXPECT_EQ(ba.used_count(), 8);
+    ba.deallocate(r.ptr, 8);
+    EXPECT_EQ(ba.used_count(), 0);
+
+    bpool_alloc<int, 8> buddy(placement_policy::buddy);
+    int* one = buddy.allocate();
+    EXPECT_FALSE(buddy.try_expand(one, 1, 2));      // single slot -> buddy block: must move
+    auto b = buddy.allocate_at_least(5);
+    EXPECT_EQ(b.count, 8);
+    EXPECT_TRUE(buddy.try_expand(b.ptr, 8, 16));
+    EXPECT_EQ(buddy.used_count(), 1 + 16);
+    buddy.deallocate(b.ptr, 16);
+    buddy.deallocate(one);
+    EXPECT_EQ(buddy.free_count(), buddy.total_count());
+}
 
 // TEST(alloc_unit_tests, bpool_alloc_2){
 //     bpool_alloc<double, 10> ba(placement_policy::first);
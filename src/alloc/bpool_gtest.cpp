@@ -38,6 +38,106 @@ TEST(alloc_unit_tests, bpool_last){
     EXPECT_TRUE(out == nullptr);
 }
 
+TEST(alloc_unit_tests, bpool_adaptive){
+    alloc::bpool<int, 4> bp(alloc::placement_policy::adaptive);
+    alloc::placement_stats s;
+    int *a = bp.allocate_adaptive(1, s, true);
+    int *b = bp.allocate_adaptive(1, s, true);
+    EXPECT_STREQ(bp.repr().c_str(), "__**");
+    bp.deallocate(a, 1);
+    EXPECT_STREQ(bp.repr().c_str(), "__*_");
+    int *c = bp.allocate_adaptive(1, s, true);      // as last: at the cursor
+    EXPECT_STREQ(bp.repr().c_str(), "_**_");
+    bp.allocate_adaptive(1, s, true);
+    EXPECT_STREQ(bp.repr().c_str(), "***_");
+    EXPECT_EQ(bp.allocate_adaptive(1, s, true), a); // cursor at the end: first fit instead of nullptr
+    EXPECT_STREQ(bp.repr().c_str(), "****");
+    EXPECT_EQ(bp.allocate(1), nullptr);
+    EXPECT_EQ(s.hits, 4);
+    EXPECT_EQ(s.misses, 1);
+
+    bp.deallocate(c, 1);                            // the cursor follows a free at or past it
+    EXPECT_EQ(bp.allocate_adaptive(1, s, true), c);
+    EXPECT_EQ(s.hits, 5);
+    bp.deallocate(a, 1);                            // one hole in four: scanned for only if sparse
+    EXPECT_EQ(bp.allocate_adaptive(1, s, false), nullptr);
+    EXPECT_EQ(bp.allocate_adaptive(1, s, true), a);
+    EXPECT_EQ(s.misses, 2);
+    bp.deallocate(a, 1);
+    bp.deallocate(b, 1);
+    EXPECT_EQ(bp.allocate(2), a);                   // a run, the cursor bumps on behind it
+    EXPECT_EQ(bp.free_count(), 0);
+
+    bp.deallocate(c, 1);
+    bp.deallocate(a, 2);
+    EXPECT_EQ(bp.allocate(1), a);                   // cursor back at the start, slot 3 still taken
+    bp.set(alloc::placement_policy::last);          // last again: the cursor goes past the last taken slot
+    EXPECT_EQ(bp.allocate(1), nullptr);
+    EXPECT_STREQ(bp.repr().c_str(), "*__*");
+
+    bp.set(alloc::placement_policy::adaptive);
+    bp.release();
+    s = {};
+    int *r = bp.allocate_adaptive(2, s, true);      // runs in the free tail: hits, as last
+    EXPECT_EQ(bp.allocate_adaptive(2, s, true), r + 2);
+    bp.deallocate(r, 2);
+    EXPECT_EQ(bp.allocate_adaptive(1, s, true), r); // the cursor moves back into the hole
+    EXPECT_EQ(bp.allocate_adaptive(1, s, true), r + 1);
+    EXPECT_EQ(s.hits, 3);
+    EXPECT_EQ(s.misses, 1);
+    bp.deallocate(r, 1);                            // cursor on a taken slot, not in a free tail any more
+    EXPECT_EQ(bp.allocate_adaptive(1, s, true), r);
+    EXPECT_EQ(s.misses, 2);
+}
+
+TEST(alloc_unit_tests, bpool_near){
+    alloc::bpool<int, 8> bp(alloc::placement_policy::first);
+    int *p[8];
+    for (auto& pi: p)
+        pi = bp.allocate(1);
+    EXPECT_STREQ(bp.repr().c_str(), "********");
+    bp.deallocate(p[1], 1);
+    bp.deallocate(p[5], 1);
+    bp.deallocate(p[6], 1);
+    EXPECT_EQ(bp.free_count(), 3);
+    EXPECT_EQ(bp.allocate_near(1, p[4]), p[5]); // first policy would take p[1]
+    EXPECT_EQ(bp.allocate_near(1, p[0]), p[1]);
+    EXPECT_EQ(bp.allocate_near(1, p[7]), p[6]); // nothing after hint -> policy placement
+    EXPECT_EQ(bp.free_count(), 0);
+    EXPECT_EQ(bp.allocate_near(1, p[0]), nullptr);
+}
+
+TEST(alloc_unit_tests, bpool_at_least_expand){
+    alloc::bpool<int, 8> bp(alloc::placement_policy::first);
+    int *a = bp.allocate(1);
+    int *b = bp.allocate(2);
+    int *c = bp.allocate(1);
+    bp.deallocate(b, 2);
+    EXPECT_STREQ(bp.repr().c_str(), "____*__*");
+    auto r = bp.allocate_at_least(1);               // the whole hole, it is no longer than 2 n
+    EXPECT_EQ(r.ptr, b);
+    EXPECT_EQ(r.count, 2);
+    EXPECT_STREQ(bp.repr().c_str(), "____****");
+    bp.deallocate(r.ptr, r.count);
+
+    EXPECT_TRUE(bp.try_expand(a, 1, 3));
+    EXPECT_STREQ(bp.repr().c_str(), "____****");
+    EXPECT_FALSE(bp.try_expand(a, 3, 5));           // c is in the way
+    EXPECT_STREQ(bp.repr().c_str(), "____****");
+    EXPECT_TRUE(bp.try_expand(c, 1, 5));
+    EXPECT_STREQ(bp.repr().c_str(), "********");
+    EXPECT_FALSE(bp.try_expand(c, 5, 6));           // past the segment end
+    bp.deallocate(c, 5);
+    bp.deallocate(a, 3);
+
+    alloc::bpool<int, 8> tail(alloc::placement_policy::last);
+    r = tail.allocate_at_least(3);                  // the free tail, capped at 2 n
+    EXPECT_EQ(r.count, 6);
+    r = tail.allocate_at_least(1);
+    EXPECT_EQ(r.count, 2);
+    EXPECT_EQ(tail.allocate_at_least(1).ptr, nullptr);
+}
+
 // int main(int argc, char **argv) {
 //   ::testing::InitGoogleTest(&argc, argv);
 //   return RUN_ALL_TESTS();
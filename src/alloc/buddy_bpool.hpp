@@ -0,0 +1,182 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "bpool.hpp"
+
+namespace alloc{
+
+// Buddy system segment of N (power of two) slots for multi slot (array) blocks: a request of n slots
+// takes a block of bit_ceil(n) slots, split from a bigger free block if needed, and a freed block merges
+// with its free buddy (same size, address differing in that one bit) as far up as possible.
+// Both are O(log N): one doubly linked free list per order, threaded through the free blocks themselves,
+// plus a free flag per (order, block) in heap order: block i of order k is bit (N >> k) + i.
+template<typename T, size_t N>
+struct buddy_bpool final: bpool_base<T> {
+    static_assert(std::has_single_bit(N), "buddy segment size must be a power of two");
+    static_assert(N <= (size_t{1} << 31), "free list links are 32 bit slot indices");
+    using value_t = T;
+    using value_storage_t = std::aligned_storage_t<sizeof(T), alignof(T)>;
+    constexpr static size_t max_order = std::bit_width(N) - 1;
+    // smallest block that holds the two links of a free list node
+    constexpr static size_t min_order = [] {
+        size_t k = 0;
+        while ((sizeof(value_storage_t) << k) < 2 * sizeof(uint32_t))
+            ++k;
+        return k;
+    }();
+    static_assert(min_order <= max_order, "segment too small for its free list links");
+private:
+    constexpr static uint32_t npos = UINT32_MAX;
+
+    value_storage_t _pool[N];
+    std::bitset<2 * N> _free_block{};
+    std::array<uint32_t, max_order + 1> _heads;
+    size_t _free_slots = 0;
+
+    static constexpr size_t _order(size_t n) noexcept {
+        size_t k = std::bit_width(n - 1);   // ceil(log2 n)
+        return k < min_order ? min_order : k;
+    }
+    static constexpr size_t _flag(size_t order, size_t idx) noexcept { return (N >> order) + (idx >> order); }
+
+    // links live in the first bytes of the free block
+    uint32_t _next(uint32_t idx) const noexcept { uint32_t v; std::memcpy(&v, &_pool[idx], sizeof(v)); return v; }
+    uint32_t _prev(uint32_t idx) const noexcept { uint32_t v; std::memcpy(&v, reinterpret_cast<const char*>(&_pool[idx]) + sizeof(v), sizeof(v)); return v; }
+    void _set_next(uint32_t idx, uint32_t v) noexcept { std::memcpy(&_pool[idx], &v, sizeof(v)); }
+    void _set_prev(uint32_t idx, uint32_t v) noexcept { std::memcpy(reinterpret_cast<char*>(&_pool[idx]) + sizeof(v), &v, sizeof(v)); }
+
+    void _push(size_t order, uint32_t idx) noexcept {
+        _set_next(idx, _heads[order]);
+        _set_prev(idx, npos);
+        if (_heads[order] != npos)
+            _set_prev(_heads[order], idx);
+        _heads[order] = idx;
+        _free_block.set(_flag(order, idx));
+    }
+    void _unlink(size_t order, uint32_t idx) noexcept {
+        uint32_t next = _next(idx), prev = _prev(idx);
+        if (prev != npos)
+            _set_next(prev, next);
+        else
+            _heads[order] = next;
+        if (next != npos)
+            _set_prev(next, prev);
+        _free_block.reset(_flag(order, idx));
+    }
+public:
+    buddy_bpool() { release(); }
+    buddy_bpool(const buddy_bpool&) = delete;
+    buddy_bpool &operator=(const buddy_bpool&) = delete;
+
+    T* allocate(size_t n) override {
+        if (n == 0 || n > N)
+            return nullptr;
+        const size_t order = _order(n);
+        size_t k = order;
+        while (k <= max_order && _heads[k] == npos)
+            ++k;
+        if (k > max_order)
+            return nullptr;
+        uint32_t idx = _heads[k];
+        _unlink(k, idx);
+        while (k > order) {                 // split, the upper halves stay free
+            --k;
+            _push(k, idx + (uint32_t{1} << k));
+        }
+        _free_slots -= size_t{1} << order;
+        return reinterpret_cast<T*>(&_pool[idx]);
+    }
+    T* allocate_adaptive(size_t n, placement_stats&, bool) override { return allocate(n); }
+    T* allocate_near(size_t n, const T*) override { return allocate(n); }
+    // the whole block: bit_ceil(n) slots, or the smallest block
+    allocation_result<T*> allocate_at_least(size_t n) override {
+        if (T* ptr = allocate(n); ptr != nullptr)
+            return {ptr, size_t{1} << _order(n)};
+        return {nullptr, 0};
+    }
+    // in place while the block is the lower half at each order up to new_n and the upper halves are free
+    bool try_expand(T* p, size_t old_n, size_t new_n) noexcept override {
+        if (!contains(p, old_n) || new_n < old_n || new_n > N)
+            return false;
+        const size_t order = _order(old_n), target = _order(new_n);
+        auto idx = static_cast<uint32_t>(p - reinterpret_cast<const T*>(&_pool[0]));
+        for (size_t k = order; k < target; ++k)
+            if (((idx >> k) & 1) != 0 || !_free_block[_flag(k, idx + (uint32_t{1} << k))])
+                return false;
+        for (size_t k = order; k < target; ++k)
+            _unlink(k, idx + (uint32_t{1} << k));
+        _free_slots -= (size_t{1} << target) - (size_t{1} << order);
+        return true;
+    }
+
+    void deallocate(T* p, size_t n) override {
+        if (!contains(p, n))
+            return;
+        size_t order = _order(n);
+        auto idx = static_cast<uint32_t>(p - reinterpret_cast<const T*>(&_pool[0]));
+        _free_slots += size_t{1} << order;
+        for (; order < max_order; ++order) {
+            uint32_t buddy = idx ^ (uint32_t{1} << order);
+            if (!_free_block[_flag(order, buddy)])
+                break;
+            _unlink(order, buddy);
+            idx &= ~(uint32_t{1} << order);
+        }
+        _push(order, idx);
+    }
+
+    bool contains(const T *p, size_t n) noexcept override {
+        const T* from = reinterpret_cast<const T*>(&_pool[0]);
+        return (from <= p) && ((p + n) <= (from + N));
+    }
+
+    size_t total_count() noexcept override { return N; }
+    size_t free_count() noexcept override { return _free_slots; }
+    bool is_free(size_t n) noexcept override {
+        if (n == 0 || n > N)
+            return false;
+        for (size_t k = _order(n); k <= max_order; ++k)
+            if (_heads[k] != npos)
+                return true;
+        return false;
+    }
+    void set(placement_policy) noexcept override {} // placement is the buddy system's own
+
+    // free block count per order, lowest order first
+    std::string repr() noexcept override {
+        std::string s;
+        for (size_t k = min_order; k <= max_order; ++k) {
+            size_t count = 0;
+            for (uint32_t i = _heads[k]; i != npos; i = _next(i))
+                ++count;
+            s += std::to_string(count) + (k == max_order ? "" : " ");
+        }
+        return s;
+    }
+
+    void reset() noexcept override {        // everything taken
+        _heads.fill(npos);
+        _free_block.reset();
+        _free_slots = 0;
+    }
+    void release() noexcept override {      // one free block of the whole segment
+        reset();
+        _push(max_order, 0);
+        _free_slots = N;
+    }
+    void prefault() noexcept override {
+        // same value rewrite as bpool::prefault: free list links and live blocks stay intact
+        auto bytes = reinterpret_cast<volatile unsigned char*>(&_pool[0]);
+        for (size_t i = 0; i < sizeof(_pool); i += BPOOL_PAGE_SIZE)
+            bytes[i] = bytes[i];
+        bytes[sizeof(_pool) - 1] = bytes[sizeof(_pool) - 1];
+    }
+};
+
+} // namespace alloc
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "buddy_bpool.hpp"
+
+using namespace alloc;
+
+TEST(alloc_unit_tests, buddy_bpool_split_coalesce){
+    buddy_bpool<uint64_t, 16> bp;                   // orders 0..4
+    EXPECT_EQ(bp.repr(), "0 0 0 0 1");
+
+    uint64_t* a = bp.allocate(3);                   // 4 slots: 16 -> 8 + 4 + [4]
+    EXPECT_EQ(bp.repr(), "0 0 1 1 0");
+    EXPECT_EQ(bp.free_count(), 12);
+    uint64_t* b = bp.allocate(1);                   // 4 -> 2 + 1 + [1]
+    EXPECT_EQ(bp.repr(), "1 1 0 1 0");
+    uint64_t* c = bp.allocate(8);
+    EXPECT_EQ(bp.repr(), "1 1 0 0 0");
+    EXPECT_EQ(c - a, 8);                            // buddies are adjacent
+    EXPECT_EQ(b - a, 4);
+    EXPECT_EQ(bp.allocate(4), nullptr);
+    EXPECT_TRUE(bp.is_free(2));
+    EXPECT_FALSE(bp.is_free(3));
+
+    bp.deallocate(a, 3);
+    EXPECT_EQ(bp.repr(), "1 1 1 0 0");              // buddy of a still split
+    bp.deallocate(b, 1);                            // 1 + 1 -> 2, + 2 -> 4, + 4 -> 8
+    EXPECT_EQ(bp.repr(), "0 0 0 1 0");
+    bp.deallocate(c, 8);
+    EXPECT_EQ(bp.repr(), "0 0 0 0 1");
+    EXPECT_EQ(bp.free_count(), 16);
+}
+
+TEST(alloc_unit_tests, buddy_bpool_small_slots){
+    buddy_bpool<char, 64> bp;                       // 8 byte blocks at least: free list links
+    EXPECT_EQ((buddy_bpool<char, 64>::min_order), 3);
+    char* a = bp.allocate(1);
+    char* b = bp.allocate(2);
+    EXPECT_EQ(b - a, 8);
+    EXPECT_EQ(bp.free_count(), 48);
+    bp.deallocate(a, 1);
+    bp.deallocate(b, 2);
+    EXPECT_EQ(bp.free_count(), 64);
+    EXPECT_EQ(bp.repr(), "0 0 0 1");
+}
+
+TEST(alloc_unit_tests, buddy_bpool_random){
+    constexpr size_t N = 1 << 12;
+    buddy_bpool<uint32_t, N> bp;
+    std::mt19937 rng(7);
+    std::vector<std::pair<uint32_t*, size_t>> live;
+    for (int step = 0; step < 20000; ++step) {
+        if (live.empty() || rng() % 3 != 0) {
+            size_t n = 1 + rng() % 100;
+            if (auto p = bp.allocate(n); p != nullptr)
+                live.emplace_back(p, n);
+        } else {
+            size_t i = rng() % live.size();
+            bp.deallocate(live[i].first, live[i].second);
+            live[i] = live.back();
+            live.pop_back();
+        }
+    }
+    std::sort(live.begin(), live.end());            // no two live blocks overlap
+    for (size_t i = 1; i < live.size(); ++i)
+        EXPECT_LE(live[i - 1].first + live[i - 1].second, live[i].first);
+    for (auto [p, n]: live)
+        bp.deallocate(p, n);
+    EXPECT_EQ(bp.free_count(), N);
+    EXPECT_NE(bp.allocate(N), nullptr);             // fully coalesced again
+}
+
+TEST(alloc_unit_tests, buddy_bpool_at_least_expand){
+    buddy_bpool<uint64_t, 16> bp;
+    auto r = bp.allocate_at_least(3);
+    EXPECT_EQ(r.count, 4);
+    EXPECT_TRUE(bp.try_expand(r.ptr, 3, 4));        // same block
+    EXPECT_TRUE(bp.try_expand(r.ptr, 4, 16 / 2));   // [0, 4) takes its free buddy [4, 8)
+    EXPECT_EQ(bp.repr(), "0 0 0 1 0");
+    uint64_t* b = bp.allocate(8);
+    EXPECT_FALSE(bp.try_expand(r.ptr, 8, 16));      // buddy taken
+    EXPECT_FALSE(bp.try_expand(b, 8, 16));          // upper half never grows in place
+    bp.deallocate(b, 8);
+    EXPECT_TRUE(bp.try_expand(r.ptr, 8, 9));
+    EXPECT_EQ(bp.free_count(), 0);
+    bp.deallocate(r.ptr, 9);
+    EXPECT_EQ(bp.repr(), "0 0 0 0 1");
+    EXPECT_EQ(bp.allocate_at_least(17).ptr, nullptr);
+}
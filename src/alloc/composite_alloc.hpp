@@ -0,0 +1,163 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace alloc{
+
+// Building blocks composing allocators of the same value_type into one, decided by type: no virtual calls,
+// no exceptions on the way from one allocator to the other when they have try_allocate (bpool_alloc does).
+//   fallback_allocator<bpool_alloc<T>, std::allocator<T>>                      pool first, heap once it is full
+//   segregator<256, bpool_alloc<T>, std::allocator<T>>                         pool for blocks <= 256 bytes
+//   segregator<64, bpool_alloc<T>, fallback_allocator<bpool_alloc<T, 1 << 16>, std::allocator<T>>>
+
+namespace _details {
+
+template <class A>
+concept has_try_allocate = requires (A a, size_t n) { { a.try_allocate(n) } noexcept; };
+
+template <class A, class T>
+concept has_owns = requires (const A a, const T* p, size_t n) { { a.owns(p, n) } -> std::same_as<bool>; };
+
+// nullptr instead of std::bad_alloc, without a throw when the allocator can tell on its own
+template <class A>
+auto try_allocate(A& a, size_t n) noexcept -> typename std::allocator_traits<A>::pointer {
+  if constexpr (has_try_allocate<A>) {
+    return a.try_allocate(n);
+  } else {
+    try {
+      return std::allocator_traits<A>::allocate(a, n);
+    } catch (const std::bad_alloc&) {
+      return nullptr;
+    }
+  }
+}
+
+} // namespace _details
+
+// Allocates from Primary, and from Secondary when Primary has no room. Primary must tell its blocks
+// (owns, as bpool_alloc): deallocate gives back to Primary what it owns, the rest to Secondary.
+template <class Primary, class Secondary>
+struct fallback_allocator {
+  using primary_traits = std::allocator_traits<Primary>;
+  using secondary_traits = std::allocator_traits<Secondary>;
+  using value_type = typename primary_traits::value_type;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+  static_assert(std::is_same_v<value_type, typename secondary_traits::value_type>, "allocators of one value_type");
+  static_assert(_details::has_owns<Primary, value_type>, "Primary needs owns(p, n)");
+private:
+  Primary _primary;
+  [[no_unique_address]] Secondary _secondary;
+public:
+  fallback_allocator() = default;
+  fallback_allocator(Primary primary, Secondary secondary = Secondary())
+      : _primary(std::move(primary)), _secondary(std::move(secondary)) {}
+  fallback_allocator(fallback_allocator&&) = default;
+  fallback_allocator(const fallback_allocator&) = delete; // as bpool_alloc
+  fallback_allocator &operator=(const fallback_allocator&) = delete;
+
+  // rebound copies get rebound parts (bpool_alloc: fresh pools, same policy)
+  template <class P, class S>
+  fallback_allocator(fallback_allocator<P, S> const& other)
+      : _primary(other.primary()), _secondary(other.secondary()) {}
+
+  template <class Up> struct rebind {
+    using other = fallback_allocator<typename primary_traits::template rebind_alloc<Up>,
+                                     typename secondary_traits::template rebind_alloc<Up>>;
+  };
+
+  pointer allocate(size_t n = 1) {
+    if (auto p = _details::try_allocate(_primary, n); p != nullptr)
+      return p;
+    return secondary_traits::allocate(_secondary, n);
+  }
+  pointer try_allocate(size_t n = 1) noexcept {
+    if (auto p = _details::try_allocate(_primary, n); p != nullptr)
+      return p;
+    return _details::try_allocate(_secondary, n);
+  }
+  void deallocate(pointer p, size_t n = 1) {
+    if (_primary.owns(p, n))
+      primary_traits::deallocate(_primary, p, n);
+    else
+      secondary_traits::deallocate(_secondary, p, n);
+  }
+  // owned by Primary, or by Secondary when it can tell (so fallback_allocator may be a Primary itself)
+  bool owns(const_pointer p, size_t n = 1) const noexcept {
+    if constexpr (_details::has_owns<Secondary, value_type>)
+      return _primary.owns(p, n) || _secondary.owns(p, n);
+    else
+      return _primary.owns(p, n);
+  }
+
+  // member-wise; deleted when a part has no operator== (bpool_alloc, whose pools are its own)
+  bool operator==(const fallback_allocator &other) const = default;
+
+  const Primary &primary() const noexcept { return _primary; }
+  Primary &primary() noexcept { return _primary; }
+  const Secondary &secondary() const noexcept { return _secondary; }
+  Secondary &secondary() noexcept { return _secondary; }
+};
+
+// Blocks of up to Threshold bytes (n * sizeof(value_type)) from Small, larger ones from Large. The size
+// alone routes deallocate, so neither part needs owns.
+template <size_t Threshold, class Small, class Large>
+struct segregator {
+  using small_traits = std::allocator_traits<Small>;
+  using large_traits = std::allocator_traits<Large>;
+  using value_type = typename small_traits::value_type;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+  static_assert(std::is_same_v<value_type, typename large_traits::value_type>, "allocators of one value_type");
+private:
+  [[no_unique_address]] Small _small;
+  [[no_unique_address]] Large _large;
+
+  static constexpr bool _is_small(size_t n) noexcept { return n <= Threshold / sizeof(value_type); }
+public:
+  segregator() = default;
+  segregator(Small small, Large large = Large()) : _small(std::move(small)), _large(std::move(large)) {}
+  segregator(segregator&&) = default;
+  segregator(const segregator&) = delete;
+  segregator &operator=(const segregator&) = delete;
+
+  template <class S, class L>
+  segregator(segregator<Threshold, S, L> const& other) : _small(other.small()), _large(other.large()) {}
+
+  template <class Up> struct rebind {
+    using other = segregator<Threshold, typename small_traits::template rebind_alloc<Up>,
+                             typename large_traits::template rebind_alloc<Up>>;
+  };
+
+  pointer allocate(size_t n = 1) {
+    return _is_small(n) ? small_traits::allocate(_small, n) : large_traits::allocate(_large, n);
+  }
+  pointer try_allocate(size_t n = 1) noexcept {
+    return _is_small(n) ? _details::try_allocate(_small, n) : _details::try_allocate(_large, n);
+  }
+  void deallocate(pointer p, size_t n = 1) {
+    if (_is_small(n))
+      small_traits::deallocate(_small, p, n);
+    else
+      large_traits::deallocate(_large, p, n);
+  }
+  bool owns(const_pointer p, size_t n = 1) const noexcept
+    requires _details::has_owns<Small, value_type> && _details::has_owns<Large, value_type> {
+    return _is_small(n) ? _small.owns(p, n) : _large.owns(p, n);
+  }
+
+  // member-wise, as fallback_allocator
+  bool operator==(const segregator &other) const = default;
+
+  const Small &small() const noexcept { return _small; }
+  Small &small() noexcept { return _small; }
+  const Large &large() const noexcept { return _large; }
+  Large &large() noexcept { return _large; }
+};
+
+} // namespace alloc
@@ -0,0 +1,130 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+#include "bpool_alloc.hpp"
+#include "composite_alloc.hpp"
+#include "utils/perf_scope.hpp"
+
+/////////////////////////////////////////////////////////////////////////
+// A live set of composite_live blocks, every iteration frees the oldest one and allocates a new one in its place.
+// Same xorshift sequence of sizes for every allocator.
+constexpr static size_t composite_live = 1 << 14;
+
+template <class Alloc>
+static void replace_blocks(benchmark::State& state, Alloc& a, size_t (*size_of)(uint64_t))
+{
+    struct block { int* p = nullptr; size_t n = 0; };
+    std::vector<block> live(composite_live);
+    uint64_t x = 88172645463325252ull;
+    auto next = [&x]{ x ^= x << 13; x ^= x >> 7; x ^= x << 17; return x; };
+    for (auto& b: live) {
+        b.n = size_of(next());
+        b.p = a.allocate(b.n);
+    }
+    size_t i = 0;
+    utils::perf_scope perf(state, 2);
+    for(auto _: state)
+    {
+        auto& b = live[i];
+        a.deallocate(b.p, b.n);
+        b.n = size_of(next());
+        b.p = a.allocate(b.n);
+        *b.p = int(i);
+        i = (i + 1) % composite_live;
+    }
+    for (auto& b: live)
+        a.deallocate(b.p, b.n);
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+// segregator: mostly small blocks (1..4 ints) from a pool, one in 16 is 64..1023 ints from the heap
+static size_t mixed_size(uint64_t r) { return r % 16 ? 1 + (r >> 8) % 4 : 64 + (r >> 8) % 960; }
+
+static void BM_segregated_std_alloc(benchmark::State& state)
+{
+    std::allocator<int> a;
+    replace_blocks(state, a, mixed_size);
+}
+BENCHMARK(BM_segregated_std_alloc);
+
+static void BM_segregated_pool_small_heap_large(benchmark::State& state)
+{
+    using pool = alloc::bpool_alloc<int, 1 << 14>;
+    using pool_or_heap = alloc::fallback_allocator<pool, std::allocator<int>>;
+    // under last the holes left behind are not reused: the pool runs full and spills to the heap
+    alloc::segregator<16, pool_or_heap, std::allocator<int>> a(pool_or_heap(pool(static_cast<alloc::placement_policy>(state.range(0)))));
+    replace_blocks(state, a, mixed_size);
+}
+BENCHMARK(BM_segregated_pool_small_heap_large)
+    ->ArgName("policy")
+    ->Arg(int64_t(alloc::placement_policy::last))
+    ->Arg(int64_t(alloc::placement_policy::first))
+    ->Arg(int64_t(alloc::placement_policy::buddy));
+
+// fallback: single slots, the live set is twice what the pool holds (31 * 256 slots), so about every
+// other allocate falls through to the heap. try_allocate: a nullptr says so; exceptions: bpool_alloc::allocate
+// throws std::bad_alloc and the fallback catches it, as the commented out ::operator new in bpool would have.
+template <class Primary, class Secondary>
+struct exception_fallback {
+    using value_type = typename Primary::value_type;
+    Primary primary;
+    Secondary secondary;
+
+    value_type* allocate(size_t n) {
+        try {
+            return primary.allocate(n);
+        } catch (const std::bad_alloc&) {
+            return secondary.allocate(n);
+        }
+    }
+    void deallocate(value_type* p, size_t n) {
+        if (primary.owns(p, n))
+            primary.deallocate(p, n);
+        else
+            secondary.deallocate(p, n);
+    }
+};
+
+static size_t single(uint64_t) { return 1; }
+using fallback_pool = alloc::bpool_alloc<int, 256>;
+static_assert(31 * 256 < composite_live);
+
+static void BM_fallback_std_alloc(benchmark::State& state)
+{
+    std::allocator<int> a;
+    replace_blocks(state, a, single);
+}
+BENCHMARK(BM_fallback_std_alloc);
+
+static void BM_fallback_try_allocate(benchmark::State& state)
+{
+    alloc::fallback_allocator<fallback_pool, std::allocator<int>> a(fallback_pool(alloc::placement_policy::first));
+    replace_blocks(state, a, single);
+}
+BENCHMARK(BM_fallback_try_allocate);
+
+static void BM_fallback_exceptions(benchmark::State& state)
+{
+    exception_fallback<fallback_pool, std::allocator<int>> a{fallback_pool(alloc::placement_policy::first), {}};
+    replace_blocks(state, a, single);
+}
+BENCHMARK(BM_fallback_exceptions);
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2
+A miss of the pool costs ~100 ns with try_allocate (the segments are searched, then the heap), ~700 ns when
+it is a thrown and caught std::bad_alloc. glibc serves this single threaded replace pattern from its
+tcache, faster than bitmap searches in a 16K slot segment; the compositions pay off where the pool does.
+-------------------------------------------------------------------------------------------------------
+Benchmark                                             Time             CPU   Iterations UserCounters...
+-------------------------------------------------------------------------------------------------------
+BM_segregated_std_alloc                            33.3 ns         32.9 ns     21814751 items_per_second=60.7399M/s page_faults=0
+BM_segregated_pool_small_heap_large/policy:0       67.1 ns         66.4 ns     11345421 items_per_second=30.12M/s page_faults=4.18671u
+BM_segregated_pool_small_heap_large/policy:1        214 ns          211 ns      2881164 items_per_second=9.48424M/s page_faults=0
+BM_segregated_pool_small_heap_large/policy:2       57.2 ns         54.6 ns     10000000 items_per_second=36.6171M/s page_faults=13.95u
+BM_fallback_std_alloc                              19.3 ns         19.1 ns     43310773 items_per_second=104.589M/s page_faults=0
+BM_fallback_try_allocate                            112 ns          112 ns      5868356 items_per_second=17.9066M/s page_faults=0
+BM_fallback_exceptions                              680 ns          674 ns       845461 items_per_second=2.96636M/s page_faults=0
+*/
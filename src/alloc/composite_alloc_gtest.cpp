@@ -0,0 +1,92 @@
+#include <concepts>
+#include <numeric>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "bpool_alloc.hpp"
+#include "composite_alloc.hpp"
+#include "slist.hpp"
+
+using namespace alloc;
+
+namespace {
+
+// 31 * 4 slots in five segments
+using small_pool = bpool_alloc<int, 4>;
+using pool_or_heap = fallback_allocator<small_pool, std::allocator<int>>;
+
+}
+
+TEST(alloc_unit_tests, bpool_alloc_try_allocate){
+    small_pool a(placement_policy::last);
+    std::vector<int*> v;
+    while (int* p = a.try_allocate(1))
+        v.push_back(p);
+    EXPECT_EQ(v.size(), 31 * 4);
+    EXPECT_EQ(a.used_count(), v.size());
+    EXPECT_EQ(a.try_allocate(1), nullptr);          // nothing changed by the failure
+    EXPECT_EQ(a.used_count(), v.size());
+    EXPECT_THROW(a.allocate(1), std::bad_alloc);
+    EXPECT_TRUE(a.owns(v.front()));
+    int outside = 0;
+    EXPECT_FALSE(a.owns(&outside));
+    a.deallocate(v.back(), 1);
+    EXPECT_EQ(a.try_allocate(1), v.back());
+
+    bpool_alloc<int, 64> b(placement_policy::buddy); // buddy blocks: 5 segments, then nullptr
+    EXPECT_NE(b.try_allocate(64), nullptr);
+    EXPECT_EQ(b.try_allocate(1 << 20), nullptr);
+}
+
+TEST(alloc_unit_tests, fallback_allocator){
+    pool_or_heap a(small_pool(placement_policy::last));
+    std::vector<int*> v;
+    for (int i = 0; i < 200; ++i) {
+        v.push_back(a.allocate(1));
+        *v.back() = i;
+    }
+    EXPECT_EQ(a.primary().used_count(), 31 * 4);   // the rest came from the heap
+    EXPECT_TRUE(a.owns(v.front()));
+    EXPECT_FALSE(a.owns(v.back()));
+    for (int i = 0; i < 200; ++i)
+        EXPECT_EQ(*v[i], i);
+    for (auto p: v)
+        a.deallocate(p, 1);                         // each to the allocator it came from
+    EXPECT_EQ(a.primary().used_count(), 0);
+    EXPECT_NE(a.try_allocate(1), nullptr);
+
+    // a node container over it: the rebound allocator falls back as well
+    cont::slist<int, pool_or_heap> l;
+    for (int i = 0; i < 500; ++i)
+        l.push_back(i);
+    EXPECT_EQ(std::accumulate(l.begin(), l.end(), 0), 499 * 500 / 2);
+    EXPECT_EQ(l.get_node_allocator().primary().used_count(), 31 * 4);
+    l.clear();
+    EXPECT_EQ(l.get_node_allocator().primary().used_count(), 0);
+}
+
+TEST(alloc_unit_tests, segregator){
+    // up to 4 ints from the pool, larger blocks from a pool that spills to the heap
+    segregator<16, bpool_alloc<int, 64>, fallback_allocator<bpool_alloc<int, 256>, std::allocator<int>>> a;
+    int* small = a.allocate(4);
+    int* large = a.allocate(5);
+    EXPECT_TRUE(a.small().owns(small, 4));
+    EXPECT_FALSE(a.small().owns(large, 5));
+    EXPECT_TRUE(a.large().primary().owns(large, 5));
+    EXPECT_TRUE(a.owns(small, 4));
+    EXPECT_TRUE(a.owns(large, 5));
+    int* huge = a.allocate(1 << 16);                // too large for any segment: heap
+    EXPECT_FALSE(a.owns(huge, 1 << 16));
+    a.deallocate(huge, 1 << 16);
+    a.deallocate(large, 5);
+    a.deallocate(small, 4);
+    EXPECT_EQ(a.small().used_count(), 0);
+    EXPECT_EQ(a.large().primary().used_count(), 0);
+
+    // equality is member-wise: stateless parts compare equal, pool parts (no operator==) leave it deleted
+    using heap_only = segregator<16, std::allocator<int>, std::allocator<int>>;
+    EXPECT_TRUE(heap_only() == heap_only());
+    EXPECT_FALSE(heap_only() != heap_only());
+    static_assert(!std::equality_comparable<decltype(a)>);
+    static_assert(!std::equality_comparable<pool_or_heap>);
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <tuple>
+
+#include "bpool_alloc.hpp"
+#include "composite_alloc.hpp"
+
+namespace alloc{
+
+// slots of the frame size classes: a segment of 1 KiB frames is 256 KiB
+constexpr std::size_t CORO_FRAME_SEGMENT_ELEMENTS = 256;
+// freed frames a size class keeps for the next coroutine before it gives them back to its segments
+constexpr std::size_t CORO_FRAME_RECENT_COUNT = 64;
+
+// a coroutine frame of up to S bytes, aligned as global operator new aligns
+template <size_t S>
+struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) frame_slot {
+    std::byte bytes[S];
+};
+
+// Coroutine frames of the calling thread: size classes of 64 .. 1024 bytes, each a bpool_alloc falling back to
+// the heap once its five segments are full (fallback_allocator), larger frames from the heap. The frame size
+// picks the class again on delete (sized operator delete), frames carry no header. A freed frame goes on a short
+// list of its class first (CORO_FRAME_RECENT_COUNT, linked through the frame) and the next coroutine of the class
+// takes it from there: a frame is a push and a pop when coroutines come and go, the segments are searched when the
+// list is empty or full.
+// A frame must be destroyed on the thread that created it, before the thread exits: the pools are thread_local
+// and not synchronized (a frame resumed and destroyed elsewhere would be freed to the heap, which never had it).
+template <size_t N = CORO_FRAME_SEGMENT_ELEMENTS>
+class frame_pools {
+    template <size_t S>
+    using pool = fallback_allocator<bpool_alloc<frame_slot<S>, N>, std::allocator<frame_slot<S>>>;
+    // adaptive: past the recent lists frames are freed in bursts, the cursor takes them back in order
+    template <size_t S>
+    static pool<S> _make() { return pool<S>(bpool_alloc<frame_slot<S>, N>(placement_policy::adaptive)); }
+
+    std::tuple<pool<64>, pool<128>, pool<256>, pool<512>, pool<1024>> _pools{
+        _make<64>(), _make<128>(), _make<256>(), _make<512>(), _make<1024>()};
+
+    struct recent_frame {
+        recent_frame *next;
+    };
+    recent_frame *_recent[5] = {};
+    size_t _recent_count[5] = {};
+
+    // 0 for up to 64 bytes .. 4 for up to 1024, 5 past them
+    static constexpr unsigned _class(size_t size) noexcept {
+        return size <= 64 ? 0 : size <= 1024 ? unsigned(std::bit_width(size - 1)) - 6 : 5;
+    }
+    // back to the pool of class c (c < 5), or to the heap if the pool fell back to it
+    void _free(unsigned c, void *p) noexcept {
+        switch (c) {
+            case 0: return std::get<0>(_pools).deallocate(static_cast<frame_slot<64>*>(p), 1);
+            case 1: return std::get<1>(_pools).deallocate(static_cast<frame_slot<128>*>(p), 1);
+            case 2: return std::get<2>(_pools).deallocate(static_cast<frame_slot<256>*>(p), 1);
+            case 3: return std::get<3>(_pools).deallocate(static_cast<frame_slot<512>*>(p), 1);
+            case 4: return std::get<4>(_pools).deallocate(static_cast<frame_slot<1024>*>(p), 1);
+        }
+    }
+    frame_pools() = default;
+public:
+    frame_pools(const frame_pools&) = delete;
+    frame_pools &operator=(const frame_pools&) = delete;
+    ~frame_pools() { // at thread exit: the recent frames from the heap are freed there, the others with the segments
+        for (unsigned c = 0; c < 5; ++c)
+            while (recent_frame *f = _recent[c]) {
+                _recent[c] = f->next;
+                _free(c, f);
+            }
+    }
+
+    static frame_pools &local() {
+        thread_local frame_pools pools;
+        return pools;
+    }
+
+    void *allocate(size_t size) {
+        const unsigned c = _class(size);
+        if (c < 5 && _recent[c] != nullptr) {
+            recent_frame *f = _recent[c];
+            _recent[c] = f->next;
+            --_recent_count[c];
+            return f;
+        }
+        switch (c) {
+            case 0: return std::get<0>(_pools).allocate(1);
+            case 1: return std::get<1>(_pools).allocate(1);
+            case 2: return std::get<2>(_pools).allocate(1);
+            case 3: return std::get<3>(_pools).allocate(1);
+            case 4: return std::get<4>(_pools).allocate(1);
+            default: return ::operator new(size);
+        }
+    }
+    void deallocate(void *p, size_t size) noexcept {
+        const unsigned c = _class(size);
+        if (c < 5 && _recent_count[c] < CORO_FRAME_RECENT_COUNT) {
+            _recent[c] = ::new(p) recent_frame{_recent[c]};
+            ++_recent_count[c];
+            return;
+        }
+        if (c < 5)
+            return _free(c, p);
+        ::operator delete(p, size);
+    }
+
+    // frames of the size classes in use on this thread (the heap ones are not counted, nor the recent ones)
+    size_t used_count() const noexcept {
+        size_t recent = 0; // the recent frames in a segment: those from the heap never were in used_count()
+        for (unsigned c = 0; c < 5; ++c)
+            for (const recent_frame *f = _recent[c]; f != nullptr; f = f->next)
+                recent += owns(f, size_t{64} << c);
+        return std::apply([](const auto&... p) { return (p.primary().used_count() + ...); }, _pools) - recent;
+    }
+    // p, a frame of size bytes, is in a segment of this thread's pools
+    bool owns(const void *p, size_t size) const noexcept {
+        switch (_class(size)) {
+            case 0: return std::get<0>(_pools).primary().owns(static_cast<const frame_slot<64>*>(p));
+            case 1: return std::get<1>(_pools).primary().owns(static_cast<const frame_slot<128>*>(p));
+            case 2: return std::get<2>(_pools).primary().owns(static_cast<const frame_slot<256>*>(p));
+            case 3: return std::get<3>(_pools).primary().owns(static_cast<const frame_slot<512>*>(p));
+            case 4: return std::get<4>(_pools).primary().owns(static_cast<const frame_slot<1024>*>(p));
+            default: return false;
+        }
+    }
+};
+
+// Promise type mixin: coroutines whose promise_type derives from it get their frames from frame_pools<N>::local()
+// instead of global operator new.
+//   struct promise_type : alloc::pooled_frame<> { ... };
+template <size_t N = CORO_FRAME_SEGMENT_ELEMENTS>
+struct pooled_frame {
+    static void *operator new(size_t size) { return frame_pools<N>::local().allocate(size); }
+    static void operator delete(void *p, size_t size) noexcept { frame_pools<N>::local().deallocate(p, size); }
+};
+
+} // namespace alloc
@@ -0,0 +1,126 @@
+#include <coroutine>
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "coro_alloc.hpp"
+#include "memuse.hpp"
+
+using namespace alloc;
+
+namespace {
+
+// minimal generator, frames from the thread's frame_pools
+struct int_generator {
+    struct promise_type : pooled_frame<> {
+        int value = 0;
+        int_generator get_return_object() { return int_generator{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(int v) noexcept { value = v; return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+    explicit int_generator(std::coroutine_handle<promise_type> h) : handle(h) {}
+    int_generator(int_generator&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    ~int_generator() { if (handle) handle.destroy(); }
+
+    bool next() { handle.resume(); return !handle.done(); }
+    int value() const { return handle.promise().value; }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// frames from frame_pools<4>: 124 of up to 64 bytes, then the heap
+struct small_pools_task {
+    struct promise_type : pooled_frame<4> {
+        small_pools_task get_return_object() { return small_pools_task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+    explicit small_pools_task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    small_pools_task(small_pools_task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    ~small_pools_task() { if (handle) handle.destroy(); }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+small_pools_task noop() { co_return; }
+
+int_generator count_to(int n) {
+    for (int i = 0; i < n; ++i)
+        co_yield i;
+}
+
+int_generator big_frame(int n) {
+    volatile char local[4096] = {};         // lives across the suspension: in the frame
+    for (int i = 0; i < n; ++i) {
+        local[i] = char(i);
+        co_yield local[i];
+    }
+}
+
+}
+
+TEST(alloc_unit_tests, coro_frame_pools){
+    auto &pools = frame_pools<>::local();
+    const size_t before = pools.used_count();
+    {
+        std::vector<int_generator> gens;
+        for (int g = 0; g < 1000; ++g)      // more frames than the first segment holds
+            gens.push_back(count_to(3));
+        EXPECT_EQ(pools.used_count(), before + 1000);
+        EXPECT_TRUE(pools.owns(gens.back().handle.address(), 64));
+        int sum = 0;
+        for (auto &g : gens)
+            while (g.next())
+                sum += g.value();
+        EXPECT_EQ(sum, 1000 * 3);
+    }
+    EXPECT_EQ(pools.used_count(), before);  // sized delete found the class again
+
+    void *last = nullptr;
+    {
+        auto gen = count_to(1);
+        last = gen.handle.address();
+    }
+    auto again = count_to(1);               // the frame just freed, from the recent list
+    EXPECT_EQ(again.handle.address(), last);
+    EXPECT_EQ(pools.used_count(), before + 1);
+
+    auto big = big_frame(3);                // past the classes: the heap
+    EXPECT_EQ(pools.used_count(), before + 1);
+    ASSERT_TRUE(big.next());
+    ASSERT_TRUE(big.next());
+    EXPECT_EQ(big.value(), 1);
+
+    std::thread other([] {                  // pools of its own
+        auto gen = count_to(2);
+        EXPECT_EQ(frame_pools<>::local().used_count(), 1);
+        EXPECT_TRUE(gen.next());
+        EXPECT_EQ(gen.value(), 0);
+    });
+    other.join();
+    EXPECT_EQ(pools.used_count(), before + 1);
+}
+
+TEST(alloc_unit_tests, coro_frame_pools_heap_recent){
+    const auto live = memuse().second;
+    std::thread([] {
+        auto &pools = frame_pools<4>::local();
+        std::vector<small_pools_task> tasks;
+        tasks.reserve(200);
+        for (int t = 0; t < 200; ++t)       // 124 frames in the segments, 76 from the heap
+            tasks.push_back(noop());
+        EXPECT_EQ(pools.used_count(), 124);
+        EXPECT_FALSE(pools.owns(tasks.back().handle.address(), 64));
+        while (!tasks.empty())              // the heap frames go on the recent list first
+            tasks.pop_back();
+        EXPECT_EQ(pools.used_count(), 0);
+    }).join();
+    EXPECT_EQ(memuse().second, live);       // the recent heap frames freed at thread exit
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <sys/mman.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include "bpool.hpp"
+#include "index_ptr.hpp"
+
+namespace alloc{
+
+// Address range the index_bpool_alloc<..., Tag, ...> segments are placed in: index_ptr<T, index_arena<Tag>> keeps
+// the offset of its target from the start of the range by 4 bytes, so 32 bits reach 16 GiB and decoding is a
+// shift and an add to a base that stays in a register over a traversal. The range is reserved (PROT_NONE, no
+// commit charge) by the first segment and committed segment by segment; nothing is given back before the exit.
+// The pointers carry nothing but the 32 bits, so the arena is static: one per Tag in the process, shared by the
+// allocators of every slot type of the Tag, not synchronized (single thread, as bpool_alloc).
+template <typename Tag>
+struct index_arena {
+    constexpr static uint32_t null_index = 0;           // the start of the range is a segment header, never a slot
+    constexpr static size_t reach = (size_t(UINT32_MAX) + 1) * 4;
+
+    static void* decode(uint32_t idx) noexcept {
+        return idx == null_index ? nullptr : reinterpret_cast<void*>(_base + (uintptr_t(idx) << 2));
+    }
+    // null_index for nullptr and for addresses outside the arena (index_ptr is pool_only)
+    static uint32_t encode(const volatile void* p) noexcept {
+        const uintptr_t off = reinterpret_cast<uintptr_t>(p) - _base;
+        return off < _placed ? uint32_t(off >> 2) : null_index;
+    }
+
+    // bytes for a segment at the next page of the range, committed; std::bad_alloc past the reach
+    static void* place(size_t bytes) {
+        if (_base == 0) {
+            void* p = ::mmap(nullptr, reach, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (p == MAP_FAILED)
+                throw std::bad_alloc();
+            _base = reinterpret_cast<uintptr_t>(p);
+        }
+        bytes = (bytes + BPOOL_PAGE_SIZE - 1) / BPOOL_PAGE_SIZE * BPOOL_PAGE_SIZE;
+        if (bytes > reach - _placed)
+            throw std::bad_alloc();
+        void* p = reinterpret_cast<void*>(_base + _placed);
+        if (::mprotect(p, bytes, PROT_READ | PROT_WRITE) != 0)
+            throw std::bad_alloc();
+        _placed += bytes;
+        return p;
+    }
+    // bytes of the range committed to segments
+    static size_t placed() noexcept { return _placed; }
+private:
+    inline static uintptr_t _base = 0;
+    inline static size_t _placed = 0;
+};
+
+// Allocator of single slots (list nodes) addressed by 32 bit index_ptr links instead of 8 byte pointers:
+// cont::slist<int, index_bpool_alloc<int, Tag, N>> has 8 byte nodes (16 with std::allocator or bpool_alloc),
+// twice as many per cache line. Segments grow as bpool_alloc's (N, 2N .. 16N slots, std::bad_alloc past 31 N),
+// in placement_policy::last, in the arena of Tag; they live until the exit, so every index stays decodable.
+// Stateless (all instances of a Tag and T share the segments), hence always equal: lists of one Tag relink nodes.
+template <class T, class Tag, size_t N = OPTIMAL_BPOOL_SEGMENT_ELEMENTS_COUNT>
+struct index_bpool_alloc {
+    using arena = index_arena<Tag>;
+    using value_type = T;
+    using pointer = index_ptr<T, arena>;
+    using const_pointer = index_ptr<const T, arena>;
+    using void_pointer = index_ptr<void, arena>;
+    using const_void_pointer = index_ptr<const void, arena>;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+    using is_always_equal = std::true_type;
+
+    template <class U> struct rebind {
+        using other = index_bpool_alloc<U, Tag, N>;
+    };
+
+    index_bpool_alloc() noexcept = default;
+    template <class U>
+    index_bpool_alloc(index_bpool_alloc<U, Tag, N> const&) noexcept {}
+
+    // only slots are checked: index_bpool_alloc<char, ...> is fine as the allocator a list rebinds to its nodes
+    pointer allocate(size_t n) {
+        static_assert(alignof(T) >= 4, "index_ptr offsets are by 4 bytes");
+        for (size_t k = _segments_size; k-- > 0; )      // the last (largest) segment has the most room
+            if (T* p = _segments[k]->allocate(n); p != nullptr) {
+                _used_count += n;
+                return p;
+            }
+        if (!_extend())
+            throw std::bad_alloc();
+        if (T* p = _segments[_segments_size - 1]->allocate(n); p != nullptr) {
+            _used_count += n;
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+    void deallocate(pointer p, size_t n) noexcept {
+        T* ptr = p.get();
+        for (size_t k = _segments_size; k-- > 0; )
+            if (_segments[k]->contains(ptr, n)) {
+                _segments[k]->deallocate(ptr, n);
+                _used_count -= n;
+                return;
+            }
+    }
+
+    // as bpool_alloc: segments up to count slots made now, and every slot freed at once (slist::clear)
+    void reserve(size_t count) {
+        while (total_count() < count)
+            if (!_extend())
+                throw std::bad_alloc();
+    }
+    void release() noexcept {
+        for (size_t k = 0; k < _segments_size; ++k)
+            _segments[k]->release();
+        _used_count = 0;
+    }
+
+    size_t used_count() const noexcept { return _used_count; }
+    size_t total_count() const noexcept {
+        size_t total = 0;
+        for (size_t k = 0; k < _segments_size; ++k)
+            total += _segments[k]->total_count();
+        return total;
+    }
+
+    template <class U>
+    bool operator==(index_bpool_alloc<U, Tag, N> const&) const noexcept { return true; }
+private:
+    inline static std::array<bpool_base<T>*, 5> _segments = {};
+    inline static size_t _segments_size = 0;
+    inline static size_t _used_count = 0;
+
+    template <size_t M>
+    static void _make() {
+        _segments[_segments_size] = ::new(arena::place(sizeof(bpool<T, M>))) bpool<T, M>(placement_policy::last);
+        ++_segments_size;
+    }
+    static bool _extend() {
+        try {
+            switch (_segments_size) {
+                case 0: _make<N>(); break;
+                case 1: _make<2 * N>(); break;
+                case 2: _make<4 * N>(); break;
+                case 3: _make<8 * N>(); break;
+                case 4: _make<16 * N>(); break;
+                default: return false;
+            }
+        } catch (const std::bad_alloc&) {
+            return false;
+        }
+        return true;
+    }
+};
+
+} // namespace alloc
@@ -0,0 +1,114 @@
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "index_bpool.hpp"
+#include "slist.hpp"
+
+using namespace alloc;
+
+namespace {
+
+constexpr size_t index_test_n = 1 << 8;
+struct list_tag {};
+struct other_tag {};
+using index_int_alloc = index_bpool_alloc<int, list_tag, index_test_n>;
+using index_list = cont::slist<int, index_int_alloc>;
+using index_node = cont::slist_details::node<int, index_ptr<void, index_arena<list_tag>>>;
+using index_node_alloc = index_bpool_alloc<index_node, list_tag, index_test_n>;   // the one the list rebinds to
+
+}
+
+TEST(alloc_unit_tests, index_ptr){
+    index_bpool_alloc<int64_t, other_tag, index_test_n> a;
+    auto p = a.allocate(1);
+    *p = 7;
+    EXPECT_EQ(sizeof(p), 4);
+    EXPECT_TRUE(p);
+    EXPECT_EQ(*p, 7);
+    index_ptr<void, index_arena<other_tag>> v = p;
+    EXPECT_EQ(static_cast<decltype(p)>(v), p);
+    EXPECT_EQ(decltype(p)(p.get()), p);             // encoded again from the address: the same index
+    EXPECT_EQ(decltype(p)::pointer_to(*p).get(), p.get());
+    EXPECT_FALSE(decltype(p)());
+    EXPECT_EQ(decltype(p)(), nullptr);
+    EXPECT_EQ(std::to_address(decltype(p)()), nullptr);
+    int64_t outside = 0;
+    EXPECT_EQ(decltype(p)(&outside), nullptr);      // pool only
+
+    std::vector<decltype(p)> ps;                    // into the second and third segments
+    for (size_t i = 0; i < 3 * index_test_n; ++i)
+        *ps.emplace_back(a.allocate(1)) = int64_t(i);
+    EXPECT_EQ(a.total_count(), 7 * index_test_n);
+    for (size_t i = 0; i < ps.size(); ++i)
+        ASSERT_EQ(*ps[i], int64_t(i));
+
+    // the other slot types of the tag place their segments in the same arena
+    const size_t placed = index_arena<other_tag>::placed();
+    index_bpool_alloc<int32_t, other_tag, index_test_n> other;
+    auto q = other.allocate(1);
+    *q = 9;
+    EXPECT_GT(index_arena<other_tag>::placed(), placed);
+    EXPECT_GT(q.index(), ps.back().index());
+    EXPECT_EQ(*q, 9);
+    EXPECT_EQ(*ps.back(), int64_t(ps.size() - 1));
+    other.deallocate(q, 1);
+
+    for (auto r: ps)
+        a.deallocate(r, 1);
+    a.deallocate(p, 1);
+    EXPECT_EQ(a.used_count(), 0);
+    EXPECT_EQ(other.used_count(), 0);
+}
+
+TEST(alloc_unit_tests, index_bpool_slist){
+    EXPECT_EQ(sizeof(index_node), 8);               // 4 byte link + int
+    index_list list;
+    for (int i = 0; i < 1000; ++i)
+        list.push_back(i);
+    list.push_front(-1);
+    EXPECT_EQ(list.size(), 1001);
+    EXPECT_EQ(list.front(), -1);
+    EXPECT_EQ(std::accumulate(list.begin(), list.end(), 0), 999 * 1000 / 2 - 1);
+    EXPECT_EQ(index_node_alloc().used_count(), 1001);
+
+    list.remove_if([](int x) { return x % 2 != 0; });   // the tail goes: ptail_ moves back
+    EXPECT_EQ(list.size(), 500);
+    list.push_back(5000);
+    list.reverse();
+    EXPECT_EQ(list.front(), 5000);
+    list.sort();
+    EXPECT_EQ(list.front(), 0);
+
+    index_list other;                               // same arena: nodes relink
+    other.push_back(1);
+    other.push_back(3);
+    list.splice(list.begin(), other);
+    EXPECT_TRUE(other.empty());
+    other.push_back(7);                             // other's tail is back at its head
+    EXPECT_EQ(other.front(), 7);
+    list.sort();
+    list.merge(other);
+    std::vector<int> seen(list.begin(), list.end());
+    EXPECT_TRUE(std::is_sorted(seen.begin(), seen.end()));
+    EXPECT_EQ(seen.size(), 504);
+    EXPECT_EQ(index_node_alloc().used_count(), 504);
+
+    list.clear();                                   // every slot of the arena: release()
+    EXPECT_EQ(index_node_alloc().used_count(), 0);
+    list.push_back(42);
+    EXPECT_EQ(list.front(), 42);
+}
+
+TEST(alloc_unit_tests, index_bpool_slist_char){
+    struct char_tag {};
+    cont::slist<char, index_bpool_alloc<char, char_tag, index_test_n>> list;    // char slots never allocated
+    for (char c = 'a'; c <= 'z'; ++c)
+        list.push_front(c);
+    EXPECT_EQ(list.size(), 26);
+    EXPECT_EQ(list.front(), 'z');
+    list.reverse();
+    EXPECT_EQ(std::string(list.begin(), list.end()), "abcdefghijklmnopqrstuvwxyz");
+}
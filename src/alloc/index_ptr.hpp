@@ -0,0 +1,52 @@
+#pragma once
+
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace alloc{
+
+// 32 bit link into the slots of an arena (index_bpool.hpp): half the size of a raw pointer, decoded by
+// Arena::decode from the arena's base address. A fancy pointer for allocator_traits / pointer_traits
+// (pointer, void_pointer of index_bpool_alloc), as offset_ptr; unlike it, it can only point into the arena:
+// containers keep their pointers to members of their own (slist: ptail_ at head_) raw (pool_only).
+template <typename T, typename Arena>
+class index_ptr {
+    uint32_t _idx = Arena::null_index;
+
+    template <typename U, typename A> friend class index_ptr;
+public:
+    using element_type = T;
+    using difference_type = std::ptrdiff_t;
+    using arena_type = Arena;
+    constexpr static bool pool_only = true;
+
+    index_ptr() noexcept = default;
+    index_ptr(std::nullptr_t) noexcept {}
+    template <typename U> requires std::convertible_to<U*, T*>
+    index_ptr(U* p) noexcept : _idx(Arena::encode(static_cast<const volatile T*>(p))) {}
+    template <typename U> requires std::convertible_to<U*, T*>
+    index_ptr(const index_ptr<U, Arena>& other) noexcept : _idx(other._idx) {}
+    // static_cast from index_ptr<void> and base classes, as for raw pointers: slots are not shared by
+    // subobjects at other offsets (the node types of the containers start with their link)
+    template <typename U> requires (!std::convertible_to<U*, T*> && requires (U* u) { static_cast<T*>(u); })
+    explicit index_ptr(const index_ptr<U, Arena>& other) noexcept : _idx(other._idx) {}
+
+    uint32_t index() const noexcept { return _idx; }
+
+    T* get() const noexcept { return static_cast<T*>(Arena::decode(_idx)); }
+    T* operator->() const noexcept { return get(); }
+    std::add_lvalue_reference_t<T> operator*() const noexcept requires (!std::is_void_v<T>) { return *get(); }
+    explicit operator bool() const noexcept { return _idx != Arena::null_index; }
+
+    template <typename U = T> requires (!std::is_void_v<U>)
+    static index_ptr pointer_to(U& r) noexcept { return index_ptr(&r); }
+
+    friend bool operator==(const index_ptr& a, const index_ptr& b) noexcept { return a._idx == b._idx; }
+    friend bool operator==(const index_ptr& a, std::nullptr_t) noexcept { return a._idx == Arena::null_index; }
+    friend auto operator<=>(const index_ptr& a, const index_ptr& b) noexcept { return a.get() <=> b.get(); }
+};
+
+} // namespace alloc
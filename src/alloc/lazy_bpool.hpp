@@ -0,0 +1,162 @@
+#pragma once
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <string>
+
+#include "bpool.hpp"
+
+namespace alloc{
+
+// lazy_bpool commits slot pages by this much at a time: one mprotect + populate per 64 KiB of high-water mark
+constexpr std::size_t BPOOL_COMMIT_CHUNK = 16 * BPOOL_PAGE_SIZE;
+
+// where bpool_alloc gets its (single slot) segments from
+enum class segment_backend {
+    heap,   // operator new: the kernel maps pages on the first write to them, wherever it happens
+    // reserved address space, committed by BPOOL_COMMIT_CHUNK as the blocks handed out reach it (lazy_bpool);
+    // segments smaller than two chunks come from the heap anyway
+    lazy
+};
+
+// A bpool<T, N> in a mapping of its own: the address space is reserved up front (PROT_NONE, no commit charge),
+// the members around the slots are committed at once, the slots chunk by chunk when a block handed out first
+// reaches past the committed ones (mprotect + MADV_POPULATE_WRITE). RSS follows the high-water mark instead
+// of the segment size, a fresh segment costs one mmap, the page faults of a filling segment come in chunks
+// from allocate instead of one per page from the writes to the slots, and release() gives the pages back.
+template<typename T, size_t N>
+struct lazy_bpool final: bpool_base<T> {
+    using segment_t = bpool<T, N>;
+    constexpr static size_t pool_bytes = N * sizeof(typename segment_t::value_storage_t);
+    static_assert(alignof(typename segment_t::value_storage_t) < BPOOL_PAGE_SIZE, "slots start in the first page");
+private:
+    size_t _committed;              // bytes of the mapping from its start on that are accessible
+    segment_t _bp;
+
+    static constexpr size_t _round_up(size_t n, size_t to) noexcept { return (n + to - 1) / to * to; }
+    static constexpr size_t _round_down(size_t n, size_t to) noexcept { return n / to * to; }
+    // the pages after the slots (the other members of _bp), committed by operator new: the slots end past
+    // pool_bytes, as only the few bytes before them (vptrs, _committed) share the first page with them
+    static constexpr size_t _tail() noexcept { return std::max(BPOOL_PAGE_SIZE, _round_down(pool_bytes, BPOOL_PAGE_SIZE)); }
+
+    char* _base() noexcept { return reinterpret_cast<char*>(this); }
+
+    // [start of the mapping, end) accessible, end rounded up to a chunk; false if the kernel refuses the commit
+    bool _commit(const T* end) noexcept {
+        const size_t need = static_cast<size_t>(reinterpret_cast<const char*>(end) - _base());
+        if (need <= _committed)
+            return true;
+        const size_t to = std::min(_round_up(need, BPOOL_COMMIT_CHUNK), _tail());
+        if (to <= _committed)       // the rest is in the tail pages
+            return true;
+        if (::mprotect(_base() + _committed, to - _committed, PROT_READ | PROT_WRITE) != 0)
+            return false;
+#ifdef MADV_POPULATE_WRITE
+        // best effort (Linux 5.14+): what is not populated now faults in on the first write
+        ::madvise(_base() + _committed, to - _committed, MADV_POPULATE_WRITE);
+#endif
+        _committed = to;
+        return true;
+    }
+    void _decommit() noexcept {
+        if (_committed <= BPOOL_PAGE_SIZE)
+            return;
+        ::madvise(_base() + BPOOL_PAGE_SIZE, _committed - BPOOL_PAGE_SIZE, MADV_DONTNEED);
+        ::mprotect(_base() + BPOOL_PAGE_SIZE, _committed - BPOOL_PAGE_SIZE, PROT_NONE);
+        _committed = BPOOL_PAGE_SIZE;
+    }
+public:
+    lazy_bpool(placement_policy pp = placement_policy::last) : _committed(BPOOL_PAGE_SIZE), _bp(pp) {}
+    ~lazy_bpool() noexcept override {}
+    lazy_bpool(const lazy_bpool&) = delete;
+    lazy_bpool &operator=(const lazy_bpool&) = delete;
+
+    // the mapping: reserved in full, the first page (vptr, _committed) and the tail (bitmap...) committed
+    static void* operator new(size_t size) {
+        const size_t length = _round_up(size, BPOOL_PAGE_SIZE);
+        void* p = ::mmap(nullptr, length, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+        auto base = static_cast<char*>(p);
+        if (::mprotect(base, BPOOL_PAGE_SIZE, PROT_READ | PROT_WRITE) != 0
+            || ::mprotect(base + _tail(), length - _tail(), PROT_READ | PROT_WRITE) != 0) {
+            ::munmap(p, length);
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+    static void operator delete(void* p, size_t size) noexcept { ::munmap(p, _round_up(size, BPOOL_PAGE_SIZE)); }
+
+    T* allocate(size_t n) override {
+        T* ptr = _bp.allocate(n);
+        if (ptr != nullptr && !_commit(ptr + n)) {
+            _bp.deallocate(ptr, n);
+            return nullptr;
+        }
+        return ptr;
+    }
+    T* allocate_adaptive(size_t n, placement_stats& stats, bool sparse) override {
+        T* ptr = _bp.allocate_adaptive(n, stats, sparse);
+        if (ptr != nullptr && !_commit(ptr + n)) {
+            _bp.deallocate(ptr, n);
+            return nullptr;
+        }
+        return ptr;
+    }
+    T* allocate_near(size_t n, const T* hint) override {
+        T* ptr = _bp.allocate_near(n, hint);
+        if (ptr != nullptr && !_commit(ptr + n)) {
+            _bp.deallocate(ptr, n);
+            return nullptr;
+        }
+        return ptr;
+    }
+    allocation_result<T*> allocate_at_least(size_t n) override {
+        auto r = _bp.allocate_at_least(n);
+        if (r.ptr != nullptr && !_commit(r.ptr + r.count)) {
+            _bp.deallocate(r.ptr, r.count);
+            return {nullptr, 0};
+        }
+        return r;
+    }
+    bool try_expand(T* p, size_t old_n, size_t new_n) noexcept override {
+        if (!_bp.try_expand(p, old_n, new_n))
+            return false;
+        if (!_commit(p + new_n)) {
+            if (new_n > old_n)
+                _bp.deallocate(p + old_n, new_n - old_n);
+            return false;
+        }
+        return true;
+    }
+    void deallocate(T* p, size_t n) override { _bp.deallocate(p, n); }
+
+    bool contains(const T *p, size_t n) noexcept override { return _bp.contains(p, n); }
+    size_t total_count() noexcept override { return N; }
+    size_t free_count() noexcept override { return _bp.free_count(); }
+    bool is_free(size_t n) noexcept override { return _bp.is_free(n); }
+    void set(placement_policy pp) noexcept override { _bp.set(pp); }
+    std::string repr() noexcept override { return _bp.repr(); }
+
+    void reset() noexcept override { _bp.reset(); }
+    // all slots free again: their pages go back to the kernel, the next blocks commit them anew
+    void release() noexcept override {
+        _bp.release();
+        _decommit();
+    }
+    // commits every slot page now (and faults it in): the segment behaves as a heap one from then on
+    void prefault() noexcept override {
+        if (_commit(_bp.data() + N))
+            _bp.prefault();
+    }
+
+    // accessible bytes of the mapping: first page, slots up to the high-water mark (by chunk), tail
+    size_t committed() const noexcept {
+        return _committed + (_round_up(sizeof(lazy_bpool), BPOOL_PAGE_SIZE) - _tail());
+    }
+};
+
+} // namespace alloc
@@ -0,0 +1,145 @@
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "utils/histogram.hpp"
+#include "utils/perf_scope.hpp"
+#include "bpool_alloc.hpp"
+
+/////////////////////////////////////////////////////////////////////////
+// Segment backends (lazy_bpool.hpp): heap segments (0) against lazily committed ones (1), 32 byte slots,
+// N = 2^14, so segments of 512 KiB up to 8 MiB. Fixed mmap threshold as in BM_bpool_alloc_startup: heap
+// segments are fresh memory too, untouched pages of both are not resident.
+struct lazy_node { size_t v[4]; };
+constexpr static size_t lazy_segment = 1 << 14;
+using lazy_node_alloc = alloc::bpool_alloc<lazy_node, lazy_segment>;
+
+static auto lazy_make(benchmark::State& state)
+{
+    mallopt(M_MMAP_THRESHOLD, 128 * 1024);
+    auto backend = state.range(0) == 0 ? alloc::segment_backend::heap : alloc::segment_backend::lazy;
+    return std::make_unique<lazy_node_alloc>(alloc::placement_policy::last, backend);
+}
+
+// resident set of the process, /proc/self/statm
+static double rss_mb()
+{
+    long pages = 0, resident = 0;
+    if (auto f = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2)
+            resident = 0;
+        std::fclose(f);
+    }
+    return double(resident) * double(::sysconf(_SC_PAGESIZE)) / (1 << 20);
+}
+
+// all 5 segments (31 N slots) made up front: heap pays for the bitmaps only, lazy for the mappings
+static void BM_lazy_reserve(benchmark::State& state)
+{
+    for (auto _: state)
+    {
+        auto a = lazy_make(state);
+        a->reserve(31 * lazy_segment);
+        benchmark::DoNotOptimize(a.get());
+        state.PauseTiming();
+        a.reset();
+        state.ResumeTiming();
+    }
+}
+
+// First touch: range(1) slots allocated and written right after the segments were reserved, per slot latency
+// (allocate + write, steady_clock around each) in a histogram. Heap segments fault one page per 128 slots in the
+// writes, lazy ones populate 16 pages per 2048 slots in allocate: fewer and longer stalls.
+static void BM_lazy_first_touch(benchmark::State& state)
+{
+    const auto count = static_cast<size_t>(state.range(1));
+    utils::histogram latency;
+    std::vector<lazy_node*> nodes;
+    nodes.reserve(count);
+    utils::perf_scope perf(state, double(count));
+    for (auto _: state)
+    {
+        state.PauseTiming();
+        auto a = lazy_make(state);
+        a->reserve(31 * lazy_segment);
+        state.ResumeTiming();
+        for (size_t i = 0; i < count; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            nodes.push_back(new(a->allocate()) lazy_node{{i}});
+            latency.record(uint64_t(std::chrono::nanoseconds(std::chrono::steady_clock::now() - start).count()));
+        }
+        benchmark::DoNotOptimize(nodes.data());
+        state.PauseTiming();
+        nodes.clear();
+        a.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.counters["p50_ns"] = double(latency.percentile(50));
+    state.counters["p99_ns"] = double(latency.percentile(99));
+    state.counters["p99.9_ns"] = double(latency.percentile(99.9));
+    state.counters["max_ns"] = double(latency.max());
+}
+
+// RSS: all segments reserved, range(1) slots written (fill_mb), then release() and an eighth of them written
+// again (refill_mb), both over the RSS before the allocator. Heap segments keep every page they were given.
+static void BM_lazy_rss(benchmark::State& state)
+{
+    const auto count = static_cast<size_t>(state.range(1));
+    double fill = 0, refill = 0;
+    for (auto _: state)
+    {
+        const double before = rss_mb();
+        auto a = lazy_make(state);
+        a->reserve(31 * lazy_segment);
+        for (size_t i = 0; i < count; ++i)
+            new(a->allocate()) lazy_node{{i}};
+        fill = rss_mb() - before;
+        a->release();
+        for (size_t i = 0; i < count / 8; ++i)
+            new(a->allocate()) lazy_node{{i}};
+        refill = rss_mb() - before;
+        state.PauseTiming();
+        a.reset();
+        state.ResumeTiming();
+    }
+    state.counters["fill_mb"] = fill;
+    state.counters["refill_mb"] = refill;
+}
+
+static void lazy_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"backend", "count"});
+    for (int64_t count: {int64_t(lazy_segment) * 7, int64_t(lazy_segment) * 31})
+        for (int64_t backend: {0, 1})
+            b->Args({backend, count});
+}
+BENCHMARK(BM_lazy_reserve)->ArgName("backend")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_lazy_first_touch)->Apply(lazy_args)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_lazy_rss)->Apply(lazy_args)->Unit(benchmark::kMicrosecond)->Iterations(10);
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2, a VM without PMU access (page_faults only, per slot).
+reserve: both pay for the bitmaps (a bit per slot, set), lazy 3 syscalls per segment on top.
+first_touch: heap takes a page fault every 128 slots (p99.9 ~2 us), lazy one populate every 2048 slots
+(p99.9 ~0.15 us); the max is VM preemption for both. RSS: the same after a fill, after release() + 1/8 refill
+lazy gives the pages back and heap keeps all of them.
+----------------------------------------------------------------------------------------------------------------
+Benchmark                                                 Time             CPU   Iterations UserCounters...
+----------------------------------------------------------------------------------------------------------------
+BM_lazy_reserve/backend:0                              39.3 us         38.1 us        20341
+BM_lazy_reserve/backend:1                              66.3 us         62.9 us        11595
+BM_lazy_first_touch/backend:0/count:114688            11485 us        11416 us           60 items_per_second=10.0463M/s max_ns=1.40377M p50_ns=46 p99.9_ns=2.271k p99_ns=82 page_faults=8.06303m
+BM_lazy_first_touch/backend:1/count:114688             8883 us         8804 us           57 items_per_second=13.0265M/s max_ns=1012.6k p50_ns=37 p99.9_ns=116 p99_ns=58 page_faults=252.248u
+BM_lazy_first_touch/backend:0/count:507904            41258 us        41047 us           16 items_per_second=12.3738M/s max_ns=984.077k p50_ns=36 p99.9_ns=1.823k p99_ns=61 page_faults=7.97395m
+BM_lazy_first_touch/backend:1/count:507904            45054 us        44584 us           16 items_per_second=11.392M/s max_ns=3.09461M p50_ns=42 p99.9_ns=189 p99_ns=74 page_faults=171.292u
+BM_lazy_rss/backend:0/count:114688/iterations:10       2941 us         2884 us           10 fill_mb=3.59766 refill_mb=3.59766
+BM_lazy_rss/backend:1/count:114688/iterations:10       3222 us         3213 us           10 fill_mb=3.65625 refill_mb=0.59375
+BM_lazy_rss/backend:0/count:507904/iterations:10      14412 us        14212 us           10 fill_mb=15.5781 refill_mb=15.5781
+BM_lazy_rss/backend:1/count:507904/iterations:10      12538 us        12526 us           10 fill_mb=15.5781 refill_mb=2.09375
+*/
@@ -0,0 +1,91 @@
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "lazy_bpool.hpp"
+#include "bpool_alloc.hpp"
+
+using namespace alloc;
+
+namespace {
+
+// resident pages of [p, p + bytes), by mincore(2)
+size_t resident_pages(const void* p, size_t bytes) {
+    const auto page = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+    auto from = reinterpret_cast<uintptr_t>(p) / page * page;
+    auto to = (reinterpret_cast<uintptr_t>(p) + bytes + page - 1) / page * page;
+    std::vector<unsigned char> pages((to - from) / page);
+    if (::mincore(reinterpret_cast<void*>(from), to - from, pages.data()) != 0)
+        return SIZE_MAX;
+    size_t count = 0;
+    for (auto v: pages)
+        count += v & 1;
+    return count;
+}
+
+} // namespace
+
+TEST(alloc_unit_tests, lazy_bpool_commit){
+    constexpr size_t n = 1 << 20;                   // 8 MiB of slots
+    using segment = lazy_bpool<uint64_t, n>;
+    auto seg = std::make_unique<segment>(placement_policy::last);
+    const size_t fresh = seg->committed();
+    EXPECT_LT(fresh, segment::pool_bytes / 32);     // first page and the bitmap (a bit per slot)
+
+    uint64_t* first = seg->allocate(1);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(seg->committed(), fresh);             // still in the first page
+    EXPECT_NE(seg->allocate(BPOOL_PAGE_SIZE / sizeof(uint64_t)), nullptr);
+    EXPECT_EQ(seg->committed(), fresh + BPOOL_COMMIT_CHUNK - BPOOL_PAGE_SIZE);  // the first chunk
+    std::vector<uint64_t*> ps{first};
+    for (size_t i = 1; i < n / 8; ++i)              // an eighth of the segment, written to
+        *ps.emplace_back(seg->allocate(1)) = i;
+    EXPECT_LE(seg->committed(), segment::pool_bytes / 8 + BPOOL_COMMIT_CHUNK + fresh);
+    // + the page the slots share with the bitmap after them
+    EXPECT_LE(resident_pages(first, segment::pool_bytes), (segment::pool_bytes / 8 + BPOOL_COMMIT_CHUNK) / BPOOL_PAGE_SIZE + 1);
+    EXPECT_EQ(*ps.back(), n / 8 - 1);
+
+    seg->release();                                 // pages back to the kernel
+    EXPECT_EQ(seg->committed(), fresh);
+    EXPECT_LE(resident_pages(first, segment::pool_bytes), 2);   // the first and the last one stay
+    uint64_t* again = seg->allocate(n / 8);         // committed anew, zero filled
+    EXPECT_EQ(again, first);
+    EXPECT_EQ(again[n / 8 - 1], 0);
+
+    seg->prefault();
+    EXPECT_GE(seg->committed(), segment::pool_bytes);
+    EXPECT_EQ(seg->free_count(), n - n / 8);
+}
+
+TEST(alloc_unit_tests, lazy_bpool_alloc){
+    constexpr size_t n = 1 << 14;
+    bpool_alloc<uint64_t, n> lazy(placement_policy::first, segment_backend::lazy);
+    lazy.reserve(31 * n);                           // all 5 segments: address space only
+    EXPECT_EQ(lazy.total_count(), 31 * n);
+
+    std::vector<uint64_t*> ps;
+    for (size_t i = 0; i < 2 * n; ++i)
+        *ps.emplace_back(lazy.allocate()) = i;
+    uint64_t* block = lazy.allocate(1000);          // runs commit as far as they go
+    block[999] = 42;
+    EXPECT_TRUE(lazy.owns(block, 1000));
+    EXPECT_EQ(lazy.used_count(), 2 * n + 1000);
+    for (size_t i = 0; i < ps.size(); ++i)
+        ASSERT_EQ(*ps[i], i);
+    lazy.deallocate(block, 1000);
+    for (auto p: ps)
+        lazy.deallocate(p);
+    EXPECT_EQ(lazy.free_count(), lazy.total_count());
+
+    lazy.release();
+    *lazy.allocate(2 * n) = 1;
+    EXPECT_EQ(lazy.used_count(), 2 * n);
+
+    bpool_alloc<int64_t, n> rebound(lazy);          // rebound copies keep the backend
+    *rebound.allocate() = 1;
+    EXPECT_EQ(rebound.used_count(), 1);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace alloc{
+
+// Byte budget shared by the allocators of a process (tenants, containers): bpool_alloc charges the slots of
+// every segment it makes and refunds them when the segments go (trim(), destruction), the allocate / deallocate
+// of slots in segments it has costs nothing. Past the hard limit no segment is made: try_allocate returns
+// nullptr (the non-throwing failure), allocate throws std::bad_alloc as for an exhausted allocator.
+// The charge that takes the usage over the soft limit calls on_soft, again at the next crossing after the usage
+// went back below it: in the charging thread, before the segment is made, so it may shed load or trim other
+// allocators, not the charging one, and must not throw. Thread safe, the usage is one atomic counter.
+class memory_budget {
+public:
+    using callback = std::function<void(memory_budget&)>;
+
+    explicit memory_budget(size_t hard_limit, size_t soft_limit = SIZE_MAX, callback on_soft = {})
+        : _hard(hard_limit), _soft(soft_limit), _on_soft(std::move(on_soft)) {}
+    memory_budget(const memory_budget&) = delete;
+    memory_budget &operator=(const memory_budget&) = delete;
+
+    // bytes counted in, or false (and nothing counted) if they do not fit under the hard limit
+    bool try_charge(size_t bytes) noexcept {
+        size_t used = _used.load(std::memory_order_relaxed);
+        do {
+            if (bytes > _hard || used > _hard - bytes) {
+                _refused.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!_used.compare_exchange_weak(used, used + bytes, std::memory_order_relaxed));
+        if (used <= _soft && used + bytes > _soft && _on_soft)
+            _on_soft(*this);
+        return true;
+    }
+    void refund(size_t bytes) noexcept { _used.fetch_sub(bytes, std::memory_order_relaxed); }
+
+    size_t used() const noexcept { return _used.load(std::memory_order_relaxed); }
+    size_t hard_limit() const noexcept { return _hard; }
+    size_t soft_limit() const noexcept { return _soft; }
+    bool over_soft_limit() const noexcept { return used() > _soft; }
+    // charges refused at the hard limit so far
+    size_t refused() const noexcept { return _refused.load(std::memory_order_relaxed); }
+private:
+    const size_t _hard;
+    const size_t _soft;
+    const callback _on_soft;
+    std::atomic<size_t> _used{0};
+    std::atomic<size_t> _refused{0};
+};
+
+} // namespace alloc
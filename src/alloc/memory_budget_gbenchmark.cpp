@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "utils/perf_scope.hpp"
+#include "bpool_alloc.hpp"
+#include "memory_budget.hpp"
+
+/////////////////////////////////////////////////////////////////////////
+// memory_budget accounting (0: no budget, 1: a budget far above the usage). The charges come with the segments:
+// a fresh allocator per iteration pays five of them (BM_budget_grow), slot allocations in segments that exist
+// pay nothing (BM_budget_steady).
+constexpr static size_t budget_segment = 1 << 8;
+constexpr static size_t budget_count = 15 * budget_segment + 1;   // all five segments
+
+static auto budget_make(benchmark::State& state, alloc::memory_budget& budget, alloc::placement_policy policy)
+{
+    return alloc::bpool_alloc<int, budget_segment>(policy, alloc::segment_backend::heap,
+                                                   state.range(0) == 0 ? nullptr : &budget);
+}
+
+static void BM_budget_grow(benchmark::State& state)
+{
+    alloc::memory_budget budget(SIZE_MAX / 2, SIZE_MAX / 4);
+    std::vector<int*> vpi(budget_count);
+    utils::perf_scope perf(state, 2 * budget_count);
+    for(auto _: state)
+    {
+        auto a = budget_make(state, budget, alloc::placement_policy::last);
+        for (auto& p: vpi)
+            p = a.allocate(1);
+        for (auto p: vpi)
+            a.deallocate(p, 1);
+    }
+    state.SetItemsProcessed(state.iterations() * 2 * budget_count);
+}
+
+// one allocator (first: the freed slot is the one handed out next), live set of budget_count slots, each
+// iteration frees and allocates them all again
+static void BM_budget_steady(benchmark::State& state)
+{
+    alloc::memory_budget budget(SIZE_MAX / 2, SIZE_MAX / 4);
+    auto a = budget_make(state, budget, alloc::placement_policy::first);
+    std::vector<int*> vpi(budget_count);
+    for (auto& p: vpi)
+        p = a.allocate(1);
+    utils::perf_scope perf(state, 2 * budget_count);
+    for(auto _: state)
+    {
+        for (auto& p: vpi) {
+            a.deallocate(p, 1);
+            p = a.allocate(1);
+        }
+        benchmark::DoNotOptimize(vpi.data());
+    }
+    for (auto p: vpi)
+        a.deallocate(p, 1);
+    state.SetItemsProcessed(state.iterations() * 2 * budget_count);
+}
+BENCHMARK(BM_budget_grow)->ArgName("budget")->Arg(0)->Arg(1);
+BENCHMARK(BM_budget_steady)->ArgName("budget")->Arg(0)->Arg(1);
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2, 8 repetitions interleaved, means: no difference beyond the noise of the VM
+(+-5%); grow charges five segments per 7.7k calls, steady charges nothing.
+-------------------------------------------------------------------------------------------
+Benchmark                                 Time             CPU   Iterations UserCounters...
+-------------------------------------------------------------------------------------------
+BM_budget_grow/budget:0_mean          63731 ns        63221 ns            8 items_per_second=123.362M/s
+BM_budget_grow/budget:1_mean          59066 ns        58523 ns            8 items_per_second=132.079M/s
+BM_budget_steady/budget:0_mean       103833 ns       102751 ns            8 items_per_second=75.3508M/s
+BM_budget_steady/budget:1_mean       100400 ns        99136 ns            8 items_per_second=77.8357M/s
+*/
@@ -0,0 +1,85 @@
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "bpool_alloc.hpp"
+#include "memory_budget.hpp"
+#include "slist.hpp"
+
+using namespace alloc;
+
+namespace {
+
+// segments of 64, 128, 256 ... int slots: 256, 512, 1024 ... bytes charged
+constexpr size_t budget_n = 64;
+using budget_pool = bpool_alloc<int, budget_n>;
+
+}
+
+TEST(alloc_unit_tests, memory_budget_limits){
+    size_t soft_calls = 0;
+    memory_budget budget(256 + 512 + 1024, 600, [&soft_calls](memory_budget& b) {
+        ++soft_calls;
+        EXPECT_TRUE(b.over_soft_limit());           // the crossing charge is counted in
+    });
+    budget_pool a(placement_policy::last, segment_backend::heap, &budget);
+    EXPECT_EQ(a.budget(), &budget);
+
+    std::vector<int*> v;
+    while (int* p = a.try_allocate(1))              // three segments, then the hard limit
+        v.push_back(p);
+    EXPECT_EQ(v.size(), 7 * budget_n);
+    EXPECT_EQ(a.get_bpools_size(), 3);
+    EXPECT_EQ(budget.used(), 256 + 512 + 1024);
+    EXPECT_EQ(soft_calls, 1);                       // at the second segment
+    EXPECT_TRUE(budget.over_soft_limit());
+    EXPECT_EQ(budget.refused(), 1);
+    EXPECT_THROW(a.allocate(1), std::bad_alloc);
+    EXPECT_EQ(budget.refused(), 2);
+
+    a.deallocate(v.back(), 1);                      // slots in the segments made: no accounting
+    v.back() = a.allocate(1);
+    EXPECT_EQ(budget.used(), 256 + 512 + 1024);
+
+    for (size_t i = budget_n; i < v.size(); ++i)    // the second and third segments unused
+        a.deallocate(v[i], 1);
+    EXPECT_EQ(a.trim(), 512 + 1024);
+    EXPECT_EQ(a.get_bpools_size(), 1);
+    EXPECT_EQ(budget.used(), 256);
+    EXPECT_FALSE(budget.over_soft_limit());
+    EXPECT_NE(a.allocate(budget_n), nullptr);       // a new second segment: the soft limit crossed again
+    EXPECT_EQ(soft_calls, 2);
+
+    memory_budget tiny(100);                        // not even the first segment: nullptr, not an exception
+    budget_pool b(placement_policy::first, segment_backend::heap, &tiny);
+    EXPECT_EQ(b.try_allocate(1), nullptr);
+    EXPECT_EQ(tiny.used(), 0);
+}
+
+TEST(alloc_unit_tests, memory_budget_shared){
+    memory_budget budget(1 << 12);
+    {
+        budget_pool a(placement_policy::last, segment_backend::heap, &budget);
+        bpool_alloc<int64_t, budget_n> rebound(a);  // rebound copies charge the same budget
+        EXPECT_NE(a.allocate(1), nullptr);
+        EXPECT_NE(rebound.allocate(1), nullptr);
+        EXPECT_EQ(budget.used(), 256 + 512);
+        budget_pool moved(std::move(a));            // the charge goes with the segments
+        EXPECT_EQ(budget.used(), 256 + 512);
+    }
+    EXPECT_EQ(budget.used(), 0);                    // refunded by the destructors
+
+    // a list that runs into the hard limit of its tenant: std::bad_alloc, the list as it was
+    memory_budget tenant(sizeof(cont::slist_details::node<int>) * budget_n * 3);
+    cont::slist<int, budget_pool> list(budget_pool(placement_policy::last, segment_backend::heap, &tenant));
+    size_t pushed = 0;
+    try {
+        for (;; ++pushed)
+            list.push_back(int(pushed));
+    } catch (const std::bad_alloc&) {
+    }
+    EXPECT_EQ(pushed, 3 * budget_n);
+    EXPECT_EQ(list.size(), pushed);
+    EXPECT_EQ(tenant.refused(), 1);
+}
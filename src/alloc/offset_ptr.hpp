@@ -0,0 +1,55 @@
+#pragma once
+
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace alloc{
+
+// Self relative pointer: keeps the distance from its own address to the target, so a structure linked with
+// offset_ptr stays valid in a mapping placed at a different address in every process (shm_bpool.hpp).
+// A fancy pointer for allocator_traits / pointer_traits (pointer, void_pointer of shm_bpool_alloc).
+// Copies recompute the distance: an offset_ptr copied out of the mapping (to the stack) still points into it.
+template <typename T>
+class offset_ptr {
+    // 1 is null: 0 would be the pointer itself, and 1 byte off is never another object's address
+    std::ptrdiff_t _off = 1;
+
+    void _set(const volatile void* p) noexcept {
+        _off = p == nullptr ? 1 : reinterpret_cast<std::intptr_t>(p) - reinterpret_cast<std::intptr_t>(this);
+    }
+public:
+    using element_type = T;
+    using difference_type = std::ptrdiff_t;
+
+    offset_ptr() noexcept = default;
+    offset_ptr(std::nullptr_t) noexcept {}
+    template <typename U> requires std::convertible_to<U*, T*>
+    offset_ptr(U* p) noexcept { _set(p); }
+    offset_ptr(const offset_ptr& other) noexcept { _set(other.get()); }
+    template <typename U> requires std::convertible_to<U*, T*>
+    offset_ptr(const offset_ptr<U>& other) noexcept { _set(other.get()); }
+    // static_cast from offset_ptr<void> and base classes, as for raw pointers
+    template <typename U> requires (!std::convertible_to<U*, T*> && requires (U* u) { static_cast<T*>(u); })
+    explicit offset_ptr(const offset_ptr<U>& other) noexcept { _set(static_cast<T*>(other.get())); }
+
+    offset_ptr& operator=(const offset_ptr& other) noexcept { _set(other.get()); return *this; }
+
+    T* get() const noexcept {
+        return _off == 1 ? nullptr : reinterpret_cast<T*>(reinterpret_cast<std::intptr_t>(this) + _off);
+    }
+    T* operator->() const noexcept { return get(); }
+    std::add_lvalue_reference_t<T> operator*() const noexcept requires (!std::is_void_v<T>) { return *get(); }
+    explicit operator bool() const noexcept { return _off != 1; }
+
+    template <typename U = T> requires (!std::is_void_v<U>)
+    static offset_ptr pointer_to(U& r) noexcept { return offset_ptr(&r); }
+
+    friend bool operator==(const offset_ptr& a, const offset_ptr& b) noexcept { return a.get() == b.get(); }
+    friend bool operator==(const offset_ptr& a, std::nullptr_t) noexcept { return a._off == 1; }
+    friend auto operator<=>(const offset_ptr& a, const offset_ptr& b) noexcept { return a.get() <=> b.get(); }
+};
+
+} // namespace alloc
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "utils/trace.hpp"
+#include "bpool.hpp"
+#include "offset_ptr.hpp"
+
+namespace alloc{
+
+// Start of a shared segment. Objects placed in the segment after it (construct) are never freed and must link
+// with offset_ptr only; root is the one object the creator publishes to the other processes.
+struct shm_header {
+    constexpr static uint64_t shm_magic = 0x6c6c6f2d6d687331; // "1shm-oll"
+    // of this header and of the pool placed after it (bpool's members): raise it when either changes, a file of
+    // an older build is refused instead of being read as the new layout
+    constexpr static uint64_t shm_layout_version = 3;
+
+    uint64_t magic = shm_magic;
+    uint64_t layout = shm_layout_version;
+    size_t size;                    // of the whole mapping
+    size_t used = sizeof(shm_header);
+    offset_ptr<void> root;
+    offset_ptr<void> pool;          // slots of shm_bpool_alloc, made on its first allocation
+    size_t pool_slot_size = 0;      // and its layout, checked by every later user (another build, another type)
+    size_t pool_slot_count = 0;
+
+    explicit shm_header(size_t mapping_size) noexcept : size(mapping_size) {}
+
+    template <typename U, typename... Args>
+    U* construct(Args&&... args) {
+        auto base = reinterpret_cast<std::uintptr_t>(this);
+        auto at = (base + used + alignof(U) - 1) & ~(std::uintptr_t{alignof(U)} - 1);
+        if (at + sizeof(U) > base + size)
+            throw std::bad_alloc();
+        used = at + sizeof(U) - base;
+        return ::new(reinterpret_cast<void*>(at)) U(std::forward<Args>(args)...);
+    }
+};
+
+// A shared mapping starting with a shm_header: POSIX shared memory (shm_open by name or an anonymous memfd),
+// or a regular file that keeps the structures for the next start of the process (create_file / open_file).
+// Every process maps it at its own address. A named shm segment is removed by the destructor of the process
+// that created it; the mappings of the others stay valid until they are destroyed.
+// Access is not synchronized: one process at a time works on the structures inside.
+class shm_segment {
+    shm_header* _header = nullptr;
+    size_t _size = 0;
+    int _fd = -1;
+    std::string _name;              // non empty for the creator of a named segment: unlinks it
+
+    shm_segment(int fd, size_t size, std::string owned_name) : _size(size), _fd(fd), _name(std::move(owned_name)) {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            auto e = errno;
+            _close();
+            throw_with_trace(std::system_error(e, std::generic_category(), "mmap"));
+        }
+        _header = static_cast<shm_header*>(p);
+    }
+    static void _truncate(int fd, size_t size) {
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            auto e = errno;
+            ::close(fd);
+            throw_with_trace(std::system_error(e, std::generic_category(), "ftruncate"));
+        }
+    }
+    static size_t _fd_size(int fd) {
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            auto e = errno;
+            ::close(fd);
+            throw_with_trace(std::system_error(e, std::generic_category(), "fstat"));
+        }
+        return static_cast<size_t>(st.st_size);
+    }
+    void _init() {
+        ::new(static_cast<void*>(_header)) shm_header(_size);
+    }
+    void _check() {
+        if (_size < sizeof(shm_header) || _header->magic != shm_header::shm_magic || _header->size != _size)
+            throw_with_trace(std::invalid_argument("not a shm_segment"));
+        if (_header->layout != shm_header::shm_layout_version)
+            throw_with_trace(std::invalid_argument("shm_segment of another layout version"));
+    }
+    void _close() noexcept {
+        if (_fd != -1)
+            ::close(_fd);
+        if (!_name.empty())
+            ::shm_unlink(_name.c_str());
+        _fd = -1;
+        _name.clear();
+    }
+public:
+    // name as for shm_open ("/allo-..."), fails if it exists
+    static shm_segment create(const std::string& name, size_t size) {
+        int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd == -1)
+            throw_with_trace(std::system_error(errno, std::generic_category(), "shm_open " + name));
+        try {
+            _truncate(fd, size);
+        } catch (...) {
+            ::shm_unlink(name.c_str());
+            throw;
+        }
+        shm_segment s(fd, size, name);
+        s._init();
+        return s;
+    }
+    static shm_segment open(const std::string& name) {
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (fd == -1)
+            throw_with_trace(std::system_error(errno, std::generic_category(), "shm_open " + name));
+        shm_segment s(fd, _fd_size(fd), {});
+        s._check();
+        return s;
+    }
+    // without a name: reaches other processes by fork or by passing fd() (SCM_RIGHTS, /proc/<pid>/fd/<fd>)
+    static shm_segment anonymous(size_t size) {
+        int fd = ::memfd_create("allo-shm", MFD_CLOEXEC);
+        if (fd == -1)
+            throw_with_trace(std::system_error(errno, std::generic_category(), "memfd_create"));
+        _truncate(fd, size);
+        shm_segment s(fd, size, {});
+        s._init();
+        return s;
+    }
+    // Warm restart: the file holds the header, the pool (slots and bitmap) and the containers placed in it,
+    // open_file maps them back as they were, nothing is rebuilt. Not crash consistent: a process killed
+    // in the middle of an update leaves that update half done in the file.
+    static shm_segment create_file(const std::string& path, size_t size) {
+        int fd = ::open(path.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+        if (fd == -1)
+            throw_with_trace(std::system_error(errno, std::generic_category(), "open " + path));
+        try {
+            _truncate(fd, size);
+            shm_segment s(fd, size, {});
+            s._init();
+            return s;
+        } catch (...) {                 // the file was made here: no half made segment is left behind
+            ::unlink(path.c_str());
+            throw;
+        }
+    }
+    static shm_segment open_file(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd == -1)
+            throw_with_trace(std::system_error(errno, std::generic_category(), "open " + path));
+        shm_segment s(fd, _fd_size(fd), {});
+        s._check();
+        return s;
+    }
+    // another mapping of the segment behind fd (the descriptor is duplicated)
+    static shm_segment attach(int fd) {
+        int own = ::dup(fd);
+        if (own == -1)
+            throw_with_trace(std::system_error(errno, std::generic_category(), "dup"));
+        shm_segment s(own, _fd_size(own), {});
+        s._check();
+        return s;
+    }
+
+    shm_segment(shm_segment&& other) noexcept
+        : _header(std::exchange(other._header, nullptr)), _size(std::exchange(other._size, 0)),
+          _fd(std::exchange(other._fd, -1)), _name(std::move(other._name)) {
+        other._name.clear();
+    }
+    shm_segment& operator=(shm_segment&&) = delete;
+    shm_segment(const shm_segment&) = delete;
+    ~shm_segment() {
+        if (_header != nullptr)
+            ::munmap(_header, _size);
+        _close();
+    }
+
+    shm_header* header() const noexcept { return _header; }
+    void* data() const noexcept { return _header; }
+    size_t size() const noexcept { return _size; }
+    int fd() const noexcept { return _fd; }
+    // writes dirty pages of a file segment back now (the kernel does it on its own, also after the process died)
+    void sync() {
+        if (::msync(_header, _size, MS_SYNC) != 0)
+            throw_with_trace(std::system_error(errno, std::generic_category(), "msync"));
+    }
+
+    template <typename U, typename... Args>
+    U* construct(Args&&... args) { return _header->template construct<U>(std::forward<Args>(args)...); }
+    template <typename U>
+    U* root() const noexcept { return static_cast<U*>(_header->root.get()); }
+    void set_root(void* p) noexcept { _header->root = p; }
+};
+
+// Allocator of single slots (list / tree nodes) from one bpool<T, N> placed in a shm_segment. It, its
+// pointers and containers using it may live in the segment themselves: a list built by one process is
+// traversed and extended by another one that maps the segment, or by the next run mapping the same file.
+// The segment does not grow: std::bad_alloc past N slots. One slot type and N per segment (the first one
+// allocated, std::logic_error for another).
+template <class T, size_t N = OPTIMAL_BPOOL_SEGMENT_ELEMENTS_COUNT>
+struct shm_bpool_alloc {
+    using value_type = T;
+    using pointer = offset_ptr<T>;
+    using const_pointer = offset_ptr<const T>;
+    using void_pointer = offset_ptr<void>;
+    using const_void_pointer = offset_ptr<const void>;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+    using is_always_equal = std::false_type;
+
+    template <class U> struct rebind {
+        using other = shm_bpool_alloc<U, N>;
+    };
+
+    explicit shm_bpool_alloc(shm_segment& s) noexcept : _header(s.header()) {}
+    template <class U>
+    shm_bpool_alloc(shm_bpool_alloc<U, N> const& other) noexcept : _header(other._header) {}
+    template <class U, size_t M> friend struct shm_bpool_alloc;
+
+    pointer allocate(size_t n) {
+        T* p = _pool()->bpool<T, N>::allocate(n); // non-virtual: the vptr in the segment is the creator's
+        if (p == nullptr)
+            throw std::bad_alloc();
+        return p;
+    }
+    void deallocate(pointer p, size_t n) noexcept {
+        _placed_pool()->bpool<T, N>::deallocate(p.get(), n);
+    }
+
+    size_t free_count() { return _pool()->bpool<T, N>::free_count(); }
+
+    template <class U>
+    bool operator==(shm_bpool_alloc<U, N> const& other) const noexcept { return _header.get() == other._header.get(); }
+private:
+    offset_ptr<shm_header> _header;
+
+    bpool<T, N>* _pool() {
+        shm_header* h = _header.get();
+        if (h->pool == nullptr) {
+            // last: O(1) placement, a segment sized for the data is not churned much
+            h->pool = h->template construct<bpool<T, N>>(placement_policy::last);
+            h->pool_slot_size = sizeof(T);
+            h->pool_slot_count = N;
+        } else if (h->pool_slot_size != sizeof(T) || h->pool_slot_count != N) {
+            throw_with_trace(std::logic_error("shm_bpool_alloc: segment holds another pool layout"));
+        }
+        return static_cast<bpool<T, N>*>(h->pool.get());
+    }
+    // the pool p came from: allocate placed it and checked its layout, nothing to throw for
+    bpool<T, N>* _placed_pool() const noexcept {
+        const shm_header* h = _header.get();
+        assert(h->pool != nullptr && h->pool_slot_size == sizeof(T) && h->pool_slot_count == N);
+        return static_cast<bpool<T, N>*>(h->pool.get());
+    }
+};
+
+} // namespace alloc
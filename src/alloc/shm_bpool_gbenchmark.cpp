@@ -0,0 +1,231 @@
+#include <benchmark/benchmark.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "shm_bpool.hpp"
+#include "slist.hpp"
+
+/////////////////////////////////////////////////////////////////////////
+// Handing a list built by a worker process over to its parent, which reads it and appends to it.
+// shm: the worker maps the named segment itself (at its own address) and builds the list in it, the parent
+// uses that very list. pipe: the worker builds a private list and streams the values, the parent rebuilds it.
+// Both pay the fork and waitpid of the worker.
+constexpr static size_t shm_handoff_n = 1 << 21;
+using shm_handoff_alloc = alloc::shm_bpool_alloc<int, shm_handoff_n>;
+using shm_handoff_list = cont::slist<int, shm_handoff_alloc>;
+// nodes (16 bytes) and their bitmap, with room for the header and the list
+constexpr static size_t shm_handoff_size = shm_handoff_n * 16 + shm_handoff_n / 8 + (1 << 12);
+
+static void handoff_wait(benchmark::State& state, pid_t worker)
+{
+    int status = 0;
+    if (worker == -1 || ::waitpid(worker, &status, 0) != worker || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        state.SkipWithError("worker failed");
+}
+
+static void BM_handoff_shm(benchmark::State& state)
+{
+    const size_t count = state.range(0);
+    const std::string name = "/allo-bench-" + std::to_string(::getpid());
+    for(auto _: state)
+    {
+        auto seg = alloc::shm_segment::create(name, shm_handoff_size);
+        auto* list = seg.construct<shm_handoff_list>(shm_handoff_alloc(seg));
+        seg.set_root(list);
+        pid_t worker = ::fork();
+        if (worker == 0) {
+            auto mine = alloc::shm_segment::open(name);
+            auto* l = mine.root<shm_handoff_list>();
+            for (size_t i = 0; i < count; ++i)
+                l->push_back(static_cast<int>(i));
+            ::_exit(0);
+        }
+        handoff_wait(state, worker);
+        benchmark::DoNotOptimize(std::accumulate(list->begin(), list->end(), 0LL));
+        list->push_back(-1);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_handoff_shm)->Arg(1 << 14)->Arg(1 << 20)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_handoff_pipe(benchmark::State& state)
+{
+    const size_t count = state.range(0);
+    constexpr size_t chunk = 1 << 12;
+    for(auto _: state)
+    {
+        int fds[2];
+        if (::pipe(fds) != 0) {
+            state.SkipWithError("pipe");
+            break;
+        }
+        pid_t worker = ::fork();
+        if (worker == 0) {
+            ::close(fds[0]);
+            cont::slist<int> l;
+            for (size_t i = 0; i < count; ++i)
+                l.push_back(static_cast<int>(i));
+            std::vector<int> buffer;
+            buffer.reserve(chunk);
+            auto flush = [&]{
+                auto bytes = reinterpret_cast<const char*>(buffer.data());
+                for (size_t left = buffer.size() * sizeof(int); left > 0;) {
+                    auto w = ::write(fds[1], bytes, left);
+                    if (w <= 0)
+                        ::_exit(1);
+                    bytes += w;
+                    left -= static_cast<size_t>(w);
+                }
+                buffer.clear();
+            };
+            for (int v: l) {
+                buffer.push_back(v);
+                if (buffer.size() == chunk)
+                    flush();
+            }
+            flush();
+            ::_exit(0);
+        }
+        ::close(fds[1]);
+        cont::slist<int> list;
+        std::vector<int> buffer(chunk);
+        size_t pending = 0;                         // bytes of a value split between reads
+        for (ssize_t r; (r = ::read(fds[0], reinterpret_cast<char*>(buffer.data()) + pending, chunk * sizeof(int) - pending)) > 0;) {
+            size_t bytes = pending + static_cast<size_t>(r);
+            size_t values = bytes / sizeof(int);
+            for (size_t i = 0; i < values; ++i)
+                list.push_back(buffer[i]);
+            pending = bytes % sizeof(int);
+            std::memmove(buffer.data(), reinterpret_cast<char*>(buffer.data()) + values * sizeof(int), pending);
+        }
+        ::close(fds[0]);
+        handoff_wait(state, worker);
+        benchmark::DoNotOptimize(std::accumulate(list.begin(), list.end(), 0LL));
+        list.push_back(-1);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_handoff_pipe)->Arg(1 << 14)->Arg(1 << 20)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2, real time (the worker runs while the parent waits).
+The shm handoff costs the worker's list building plus page faults of the fresh segment, the parent reads
+the list in place; the pipe one adds the copy through the kernel and a second list build in the parent.
+--------------------------------------------------------------------------------------------
+Benchmark                                  Time             CPU   Iterations UserCounters...
+--------------------------------------------------------------------------------------------
+BM_handoff_shm/16384/real_time         0.732 ms        0.184 ms          752 items_per_second=22.3923M/s
+BM_handoff_shm/1048576/real_time        28.7 ms         6.72 ms           31 items_per_second=36.4934M/s
+BM_handoff_pipe/16384/real_time         1.35 ms        0.875 ms          517 items_per_second=12.1012M/s
+BM_handoff_pipe/1048576/real_time       99.4 ms         62.7 ms            7 items_per_second=10.5513M/s
+*/
+
+/////////////////////////////////////////////////////////////////////////
+// Warm restart of a process holding a 10M element list. rebuild: the state is saved as a flat array of values,
+// the new process reads it and builds the list again. remap: the list lives in a shm_segment file, the new
+// process maps it and uses the list where it is; remap_traverse also reads every node once (page faults of the
+// mapping). Both files are written once, before timing, and are served from the page cache afterwards.
+constexpr static size_t restart_n = 10'000'000;
+constexpr static size_t restart_slots = 1 << 24;
+using restart_alloc = alloc::shm_bpool_alloc<int, restart_slots>;
+using restart_list = cont::slist<int, restart_alloc>;
+constexpr static size_t restart_size = restart_slots * 16 + restart_slots / 8 + (1 << 12);
+
+struct restart_files {
+    std::filesystem::path flat, pool;
+
+    restart_files() {
+        auto dir = std::filesystem::temp_directory_path();
+        auto tag = std::to_string(::getpid());
+        flat = dir / ("allo-bench-" + tag + ".flat");
+        pool = dir / ("allo-bench-" + tag + ".pool");
+        std::vector<int> values(restart_n);
+        std::iota(values.begin(), values.end(), 0);
+        if (auto* f = std::fopen(flat.c_str(), "wb")) {
+            std::fwrite(values.data(), sizeof(int), values.size(), f);
+            std::fclose(f);
+        }
+        auto seg = alloc::shm_segment::create_file(pool, restart_size);
+        auto* list = seg.construct<restart_list>(restart_alloc(seg));
+        seg.set_root(list);
+        for (int v: values)
+            list->push_back(v);
+        seg.sync();
+    }
+    ~restart_files() {
+        std::filesystem::remove(flat);
+        std::filesystem::remove(pool);
+    }
+    static const restart_files& get() {
+        static restart_files files;
+        return files;
+    }
+};
+
+static void BM_restart_rebuild(benchmark::State& state)
+{
+    const auto& files = restart_files::get();
+    constexpr size_t chunk = 1 << 14;
+    std::vector<int> buffer(chunk);
+    for(auto _: state)
+    {
+        auto* list = new cont::slist<int>;
+        std::FILE* f = std::fopen(files.flat.c_str(), "rb");
+        for (size_t r; (r = std::fread(buffer.data(), sizeof(int), chunk, f)) > 0;)
+            for (size_t i = 0; i < r; ++i)
+                list->push_back(buffer[i]);
+        std::fclose(f);
+        benchmark::DoNotOptimize(list->front());
+        state.PauseTiming();                        // the old process does not free its list either
+        delete list;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * restart_n);
+}
+BENCHMARK(BM_restart_rebuild)->Unit(benchmark::kMillisecond);
+
+static void BM_restart_remap(benchmark::State& state)
+{
+    const auto& files = restart_files::get();
+    for(auto _: state)
+    {
+        auto seg = alloc::shm_segment::open_file(files.pool);
+        auto* list = seg.root<restart_list>();
+        benchmark::DoNotOptimize(list->front());
+        list->push_front(-1);                       // usable right away, allocator state included
+        list->pop_front();
+    }
+}
+BENCHMARK(BM_restart_remap)->Unit(benchmark::kMillisecond);
+
+static void BM_restart_remap_traverse(benchmark::State& state)
+{
+    const auto& files = restart_files::get();
+    for(auto _: state)
+    {
+        auto seg = alloc::shm_segment::open_file(files.pool);
+        auto* list = seg.root<restart_list>();
+        benchmark::DoNotOptimize(std::accumulate(list->begin(), list->end(), 0LL));
+    }
+    state.SetItemsProcessed(state.iterations() * restart_n);
+}
+BENCHMARK(BM_restart_remap_traverse)->Unit(benchmark::kMillisecond);
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2, both files in the page cache (after a reboot remap_traverse reads the
+268 MB pool file from disk, rebuild the 40 MB flat one).
+remap costs open + mmap + fstat whatever the list size; a full pass over the remapped list is still 8x
+cheaper than building it again.
+------------------------------------------------------------------------------------
+Benchmark                          Time             CPU   Iterations UserCounters...
+------------------------------------------------------------------------------------
+BM_restart_rebuild               280 ms          278 ms            2 items_per_second=35.9793M/s
+BM_restart_remap               0.036 ms        0.035 ms        19621
+BM_restart_remap_traverse       36.3 ms         36.0 ms           20 items_per_second=277.852M/s
+*/
@@ -0,0 +1,142 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <numeric>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "shm_bpool.hpp"
+#include "slist.hpp"
+
+using namespace alloc;
+
+namespace {
+
+constexpr size_t shm_test_n = 1 << 10;
+using shm_int_alloc = shm_bpool_alloc<int, shm_test_n>;
+using shm_list = cont::slist<int, shm_int_alloc>;
+using shm_node_alloc = shm_bpool_alloc<cont::slist_details::node<int, offset_ptr<void>>, shm_test_n>;
+struct too_big { char bytes[1 << 20]; };
+
+}
+
+TEST(alloc_unit_tests, offset_ptr){
+    struct pair { offset_ptr<int> p; int v = 7; };
+    pair a;
+    EXPECT_FALSE(a.p);
+    EXPECT_EQ(a.p, nullptr);
+    a.p = &a.v;
+    EXPECT_EQ(*a.p, 7);
+    pair b;
+    b.p = a.p;                                      // copy: same target, not the same offset
+    EXPECT_EQ(b.p.get(), &a.v);
+    offset_ptr<void> v = a.p;
+    EXPECT_EQ(static_cast<offset_ptr<int>>(v).get(), &a.v);
+    EXPECT_EQ(offset_ptr<int>::pointer_to(b.v).get(), &b.v);
+    EXPECT_EQ(std::to_address(offset_ptr<int>()), nullptr);
+}
+
+TEST(alloc_unit_tests, shm_bpool_two_mappings){
+    auto seg = shm_segment::anonymous(1 << 20);
+    auto* list = seg.construct<shm_list>(shm_int_alloc(seg));
+    seg.set_root(list);
+    for (int i = 0; i < 100; ++i)
+        list->push_back(i);
+
+    // the same memory at another address: everything is reached through offsets
+    auto other = shm_segment::attach(seg.fd());
+    ASSERT_NE(other.data(), seg.data());
+    auto* seen = other.root<shm_list>();
+    ASSERT_NE(seen, nullptr);
+    EXPECT_EQ(reinterpret_cast<char*>(seen) - static_cast<char*>(other.data()),
+              reinterpret_cast<char*>(list) - static_cast<char*>(seg.data()));
+    EXPECT_EQ(seen->size(), 100);
+    EXPECT_EQ(std::accumulate(seen->begin(), seen->end(), 0), 99 * 100 / 2);
+    seen->push_back(100);                           // appended through the second mapping
+    seen->erase(seen->begin());
+    EXPECT_EQ(list->size(), 100);
+    EXPECT_EQ(list->front(), 1);
+    EXPECT_EQ(std::accumulate(list->begin(), list->end(), 0), 100 * 101 / 2);
+
+    list->clear();
+    EXPECT_EQ(shm_node_alloc(seg).free_count(), shm_test_n);
+    EXPECT_THROW(shm_int_alloc(seg).allocate(1), std::logic_error); // node slots only
+}
+
+TEST(alloc_unit_tests, shm_bpool_exhausted){
+    auto seg = shm_segment::anonymous(1 << 20);
+    auto* list = seg.construct<shm_list>(shm_int_alloc(seg));
+    for (size_t i = 0; i < shm_test_n; ++i)
+        list->push_back(int(i));
+    EXPECT_THROW(list->push_back(0), std::bad_alloc);
+    EXPECT_EQ(list->size(), shm_test_n);
+    EXPECT_THROW(seg.construct<too_big>(), std::bad_alloc);
+}
+
+TEST(alloc_unit_tests, shm_bpool_two_processes){
+    const std::string name = "/allo-gtest-" + std::to_string(::getpid());
+    auto seg = shm_segment::create(name, 1 << 20);
+    auto* list = seg.construct<shm_list>(shm_int_alloc(seg));
+    seg.set_root(list);
+    list->push_back(1);
+
+    pid_t child = ::fork();
+    ASSERT_NE(child, -1);
+    if (child == 0) {
+        int code = 1;
+        try {
+            auto mine = shm_segment::open(name);    // a mapping of its own, at another address
+            auto* l = mine.root<shm_list>();
+            if (l->size() == 1 && l->front() == 1) {
+                for (int i = 2; i <= 10; ++i)
+                    l->push_back(i);
+                code = 0;
+            }
+        } catch (...) {
+        }
+        ::_exit(code);
+    }
+    int status = 0;
+    ASSERT_EQ(::waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_EQ(list->size(), 10);
+    EXPECT_EQ(std::accumulate(list->begin(), list->end(), 0), 55);
+    EXPECT_THROW(shm_segment::create(name, 1 << 20), std::system_error);
+}
+
+TEST(alloc_unit_tests, shm_bpool_file_restart){
+    const auto path = std::filesystem::temp_directory_path() / ("allo-gtest-" + std::to_string(::getpid()) + ".pool");
+    {
+        auto seg = shm_segment::create_file(path, 1 << 20);
+        auto* list = seg.construct<shm_list>(shm_int_alloc(seg));
+        seg.set_root(list);
+        for (int i = 0; i < 100; ++i)
+            list->push_back(i);
+        list->erase(list->begin());
+        seg.sync();
+    }                                               // unmapped: "process exit"
+    {
+        auto seg = shm_segment::open_file(path);
+        auto* list = seg.root<shm_list>();
+        ASSERT_NE(list, nullptr);
+        EXPECT_EQ(list->size(), 99);
+        EXPECT_EQ(list->front(), 1);
+        list->push_back(100);                       // the bitmap came back too: no slot is handed out twice
+        EXPECT_EQ(std::accumulate(list->begin(), list->end(), 0), 100 * 101 / 2);
+        EXPECT_EQ(shm_node_alloc(seg).free_count(), shm_test_n - 100);
+        EXPECT_THROW((shm_bpool_alloc<shm_node_alloc::value_type, 2 * shm_test_n>(seg).allocate(1)), std::logic_error);
+    }
+    {
+        auto seg = shm_segment::open_file(path);
+        ++seg.header()->layout;                     // written by a build of another layout
+    }
+    EXPECT_THROW(shm_segment::open_file(path), std::invalid_argument);
+    EXPECT_THROW(shm_segment::create_file(path, 1 << 20), std::system_error);
+    std::filesystem::remove(path);
+    EXPECT_THROW(shm_segment::open_file(path), std::system_error);
+
+    EXPECT_THROW(shm_segment::create_file(path, SIZE_MAX), std::system_error);   // ftruncate fails
+    EXPECT_FALSE(std::filesystem::exists(path));    // and the file it made is gone
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "utils/trace.hpp"
+#include "bpool.hpp"
+
+namespace alloc{
+
+// What one allocator tag did in a run (bpool_alloc constructed from the record): peak of the slots in use, peak
+// segment count, allocations by block size n (power of two buckets), frees and the blocks freed in bulk. With the last run's values loaded
+// (sizing_profile) it also gives the pool shape to start with: the segments of the peak made on the first extension
+// and the placement policy for the allocation pattern. Not synchronized: one allocator, or allocators of one thread,
+// per tag.
+struct sizing_record {
+    constexpr static size_t buckets = 32;   // n in [2^b, 2^(b+1)) counted in bucket b
+
+    size_t slot_size = 0;       // bytes of the slots (rebound allocators: the type actually allocated)
+    size_t peak_used = 0;
+    size_t peak_segments = 0;
+    size_t allocs = 0;
+    size_t frees = 0;
+    size_t released = 0;        // by release() (slist::clear): nothing left behind, not counted as churn
+    size_t n_counts[buckets] = {};
+
+    // the last run, from the profile: bytes to presize (0: nothing loaded) and its suggested_policy()
+    size_t presize_bytes = 0;
+    placement_policy policy = placement_policy::first;
+
+    void on_allocate(size_t n, size_t used, size_t segments, size_t slot) noexcept {
+        ++allocs;
+        ++n_counts[std::min<size_t>(std::bit_width(n) - 1, buckets - 1)];
+        peak_used = std::max(peak_used, used);
+        peak_segments = std::max(peak_segments, segments);
+        slot_size = slot;
+    }
+    // n single slots allocated as one run (bpool_alloc::try_allocate_slots), freed one by one
+    void on_allocate_slots(size_t n, size_t used, size_t segments, size_t slot) noexcept {
+        allocs += n;
+        n_counts[0] += n;
+        peak_used = std::max(peak_used, used);
+        peak_segments = std::max(peak_segments, segments);
+        slot_size = slot;
+    }
+    void on_free() noexcept { ++frees; }
+    void on_release(size_t blocks) noexcept { released += blocks; }
+
+    bool loaded() const noexcept { return presize_bytes != 0; }
+    // the loaded policy, or fallback if the tag was not in the profile
+    placement_policy policy_or(placement_policy fallback) const noexcept { return loaded() ? policy : fallback; }
+
+    // Policy for what was recorded: buddy if 1 in 20 allocations or more are blocks of 16 slots and up,
+    // last if less than 1 in 10 allocated blocks were freed one by one (the pool grows, bump allocation; blocks
+    // released in bulk leave no holes and are left out), adaptive otherwise (churn: bumps through the freed
+    // regions, scans when the run at the cursor ends).
+    placement_policy suggested_policy() const noexcept {
+        size_t large = 0;
+        for (size_t b = 4; b < buckets; ++b)
+            large += n_counts[b];
+        if (large * 20 >= allocs && large != 0)
+            return placement_policy::buddy;
+        if (frees * 10 < allocs)
+            return placement_policy::last;
+        return placement_policy::adaptive;
+    }
+};
+
+// Sizing profile of a process: a sizing_record per allocator tag, read from path when it exists, written back
+// with this run's records by save() or the destructor (at exit for a profile in main or a static one). A tag
+// recorded in this run replaces the loaded line, the lines of the others are kept as they were.
+// Text, a line per tag:  tag slot_size peak_used peak_segments allocs frees policy b:count,b:count... released
+// (released is missing from the lines of older profiles)
+class sizing_profile {
+public:
+    explicit sizing_profile(std::string path) : _path(std::move(path)) {
+        std::ifstream in(_path);
+        std::string line;
+        while (std::getline(in, line))
+            if (!line.empty() && line[0] != '#')
+                _parse(line);
+    }
+    ~sizing_profile() {
+        try {
+            save();
+        } catch (...) {     // nothing to do about it at exit
+        }
+    }
+    sizing_profile(const sizing_profile&) = delete;
+    sizing_profile &operator=(const sizing_profile&) = delete;
+
+    // the record of tag (a word, no spaces), with the last run's values if the profile had it
+    sizing_record &operator[](const std::string &tag) {
+        if (tag.empty() || tag.find_first_of(" \t\n") != std::string::npos)
+            throw_with_trace(std::invalid_argument("sizing_profile: bad tag '" + tag + "'"));
+        return _records[tag];
+    }
+    bool contains(const std::string &tag) const { return _records.contains(tag); }
+    const std::string &path() const noexcept { return _path; }
+
+    void save() const {
+        std::ofstream out(_path, std::ios::trunc);
+        if (!out)
+            throw_with_trace(std::runtime_error("sizing_profile: cannot write " + _path));
+        out << "# allo sizing profile: tag slot_size peak_used peak_segments allocs frees policy n_log2:count... released\n";
+        for (const auto &[tag, r] : _records) {
+            if (r.allocs == 0) {
+                if (auto it = _lines.find(tag); it != _lines.end())
+                    out << it->second << '\n';
+                continue;
+            }
+            out << tag << ' ' << r.slot_size << ' ' << r.peak_used << ' ' << r.peak_segments << ' ' << r.allocs << ' '
+                << r.frees << ' ' << _name(r.suggested_policy()) << ' ';
+            const char *sep = "";
+            for (size_t b = 0; b < sizing_record::buckets; ++b)
+                if (r.n_counts[b] != 0) {
+                    out << sep << b << ':' << r.n_counts[b];
+                    sep = ",";
+                }
+            out << (*sep == '\0' ? "-" : "") << ' ' << r.released << '\n';
+        }
+        if (!out)
+            throw_with_trace(std::runtime_error("sizing_profile: cannot write " + _path));
+    }
+private:
+    std::string _path;
+    std::map<std::string, sizing_record> _records;  // node based: records stay where allocators point to them
+    std::map<std::string, std::string> _lines;      // as loaded
+
+    static const char *_name(placement_policy pp) noexcept {
+        switch (pp) {
+            case placement_policy::last: return "last";
+            case placement_policy::first: return "first";
+            case placement_policy::buddy: return "buddy";
+            case placement_policy::adaptive: return "adaptive";
+        }
+        return "first";
+    }
+    static placement_policy _policy(const std::string &name) {
+        for (auto pp : {placement_policy::last, placement_policy::first, placement_policy::buddy, placement_policy::adaptive})
+            if (name == _name(pp))
+                return pp;
+        throw_with_trace(std::invalid_argument("sizing_profile: bad policy '" + name + "'"));
+        return placement_policy::first;
+    }
+    // a line of the file: the record gets what to start with, the counts of this run start from 0
+    void _parse(const std::string &line) {
+        std::istringstream is(line);
+        std::string tag, policy, counts;
+        sizing_record r;
+        if (!(is >> tag >> r.slot_size >> r.peak_used >> r.peak_segments >> r.allocs >> r.frees >> policy >> counts))
+            throw_with_trace(std::invalid_argument("sizing_profile: bad line '" + line + "' in " + _path));
+        std::istringstream cs(counts == "-" ? std::string() : counts);
+        size_t b = 0, count = 0;
+        char colon = 0, comma = 0;
+        while (cs >> b >> colon >> count) {     // checked only: the policy was picked from them
+            if (colon != ':' || b >= sizing_record::buckets)
+                throw_with_trace(std::invalid_argument("sizing_profile: bad counts '" + counts + "' in " + _path));
+            cs >> comma;
+        }
+        if (size_t released = 0; !(is >> released) && !is.eof())
+            throw_with_trace(std::invalid_argument("sizing_profile: bad line '" + line + "' in " + _path));
+        auto &loaded = _records[tag];
+        loaded.policy = _policy(policy);
+        loaded.presize_bytes = std::max<size_t>(r.peak_used * r.slot_size, 1);
+        _lines[tag] = line;
+    }
+};
+
+} // namespace alloc
@@ -0,0 +1,159 @@
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "bpool_alloc.hpp"
+#include "sizing_profile.hpp"
+#include "slist.hpp"
+
+using namespace alloc;
+
+namespace {
+
+constexpr size_t sizing_n = 64;
+using sizing_pool = bpool_alloc<int, sizing_n>;
+
+std::string profile_path(const char *name) {
+    return (std::filesystem::temp_directory_path() / (std::string(name) + "." + std::to_string(::getpid()))).string();
+}
+
+}
+
+TEST(alloc_unit_tests, sizing_profile_round_trip){
+    const auto path = profile_path("allo_sizing");
+    {
+        sizing_profile profile(path);               // no file yet: nothing loaded, policies as given
+        EXPECT_FALSE(profile["list"].loaded());
+        cont::slist<int, sizing_pool> list(sizing_pool(profile["list"], placement_policy::first));
+        for (int i = 0; i < 1000; ++i)              // monotonic: last
+            list.push_back(i);
+        sizing_pool churn(profile["churn"]);
+        std::vector<int*> v;
+        for (int round = 0; round < 10; ++round) {  // half freed every round: adaptive
+            for (int i = 0; i < 100; ++i)
+                v.push_back(churn.allocate(1));
+            for (int i = 0; i < 50; ++i) {
+                churn.deallocate(v.back(), 1);
+                v.pop_back();
+            }
+        }
+        sizing_pool arrays(profile["arrays"]);
+        v.push_back(arrays.allocate(32));           // blocks of 16 slots and up: buddy
+        arrays.deallocate(v.back(), 32);
+        v.pop_back();
+        sizing_pool unused(profile["unused"]);
+
+        EXPECT_EQ(profile["list"].peak_used, 1000);
+        EXPECT_EQ(profile["list"].slot_size, sizeof(cont::slist_details::node<int>));   // the rebound allocator's
+        EXPECT_EQ(profile["list"].peak_segments, 5);
+        EXPECT_EQ(profile["churn"].peak_used, 550);
+        EXPECT_EQ(profile["list"].suggested_policy(), placement_policy::last);
+        EXPECT_EQ(profile["churn"].suggested_policy(), placement_policy::adaptive);
+        EXPECT_EQ(profile["arrays"].suggested_policy(), placement_policy::buddy);
+        for (auto p: v)
+            churn.deallocate(p, 1);
+    }                                               // written at the end of the run
+
+    {
+        sizing_profile profile(path);
+        EXPECT_TRUE(profile.contains("list"));
+        EXPECT_FALSE(profile.contains("unused"));   // no allocation, no line
+        auto &rec = profile["list"];
+        EXPECT_TRUE(rec.loaded());
+        EXPECT_EQ(rec.policy, placement_policy::last);
+        EXPECT_EQ(rec.peak_used, 0);                // this run's counts start anew
+        EXPECT_EQ(profile["churn"].policy_or(placement_policy::first), placement_policy::adaptive);
+
+        cont::slist<int, sizing_pool> list(sizing_pool(rec, placement_policy::first));
+        list.push_back(1);                          // the first extension makes the peak's segments
+        EXPECT_EQ(rec.peak_segments, 5);
+        EXPECT_EQ(rec.peak_used, 1);
+    }                                               // list recorded anew (peak 1), churn and arrays kept
+
+    {
+        sizing_profile profile(path);
+        EXPECT_TRUE(profile.contains("churn"));
+        EXPECT_TRUE(profile.contains("arrays"));
+        EXPECT_EQ(profile["arrays"].policy, placement_policy::buddy);
+        EXPECT_THROW(profile["two words"], std::invalid_argument);
+    }
+    std::filesystem::remove(path);
+
+    std::ofstream(path) << "list 16 oops\n";
+    EXPECT_THROW(sizing_profile{path}, std::invalid_argument);
+    std::filesystem::remove(path);
+}
+
+TEST(alloc_unit_tests, sizing_profile_release){
+    const auto path = profile_path("allo_sizing_release");
+    {
+        sizing_profile profile(path);
+        auto &rec = profile["list"];
+        {
+            cont::slist<int, sizing_pool> list(sizing_pool(rec, placement_policy::first));
+            for (int i = 0; i < 10; ++i)
+                list.push_back(i);
+            list.pop_front();
+            EXPECT_EQ(rec.frees, 1);
+            list.clear();                           // release(): the other 9 in bulk
+            EXPECT_EQ(rec.frees, 1);
+            EXPECT_EQ(rec.released, 9);
+            for (int i = 0; i < 5; ++i)
+                list.push_back(i);
+        }                                           // and the destructor's
+        EXPECT_EQ(rec.allocs, 15);
+        EXPECT_EQ(rec.released, 14);
+        EXPECT_EQ(rec.suggested_policy(), placement_policy::last);    // bulk frees leave no holes
+    }
+    {
+        std::string line;
+        std::ifstream in(path);
+        std::getline(in, line);
+        std::getline(in, line);
+        EXPECT_EQ(line, "list 16 10 1 15 1 last 0:15 14");
+    }
+    std::ofstream(path) << "list 16 10 1 15 1 last 0:15\n";  // written before released was
+    EXPECT_EQ(sizing_profile(path)["list"].policy, placement_policy::last);
+    std::ofstream(path) << "list 16 10 1 15 1 last 0:15 many\n";
+    EXPECT_THROW(sizing_profile{path}, std::invalid_argument);
+    std::filesystem::remove(path);
+}
+
+TEST(alloc_unit_tests, sizing_profile_parallel_append){
+    constexpr size_t n = 100000;
+    using run_pool = bpool_alloc<int, 1 << 12>;
+    sizing_record rec;
+    {
+        cont::slist<int, run_pool> list(run_pool(rec, placement_policy::first));
+        list.parallel_append(n, [](size_t i) { return static_cast<int>(i); }, 4);
+        EXPECT_EQ(rec.allocs, n);                   // the runs of slots counted slot by slot
+        EXPECT_EQ(rec.n_counts[0], n);
+        EXPECT_EQ(rec.peak_used, n);
+        list.remove_if([](int x) { return x % 100 == 0; });
+        EXPECT_EQ(rec.frees, n / 100);
+    }                                               // the rest released by the destructor
+    EXPECT_EQ(rec.released, n - n / 100);
+    EXPECT_EQ(rec.suggested_policy(), placement_policy::last);    // not buddy: no large blocks
+}
+
+TEST(alloc_unit_tests, sizing_profile_reserve){
+    const auto path = profile_path("allo_sizing_reserve");
+    std::ofstream(path) << "pool 4 1000 5 1000 0 last 0:1000 0\n";
+    {
+        sizing_profile profile(path);
+        sizing_pool pool(profile["pool"]);
+        pool.reserve(1);                            // the first extension makes the peak's 5 segments
+        EXPECT_EQ(pool.get_bpools_size(), 5);
+        EXPECT_EQ(pool.total_count(), 31 * sizing_n);
+        EXPECT_NO_THROW(pool.reserve(31 * sizing_n));   // all there already
+        EXPECT_EQ(pool.get_bpools_size(), 5);
+        EXPECT_THROW(pool.reserve(31 * sizing_n + 1), std::bad_alloc);
+    }
+    std::filesystem::remove(path);
+}
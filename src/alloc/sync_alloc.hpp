@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace alloc{
+
+// test-and-test-and-set spin lock: allocator critical sections are a few dozens of instructions,
+// parking the thread (std::mutex) costs more than waiting them out
+struct spin_lock {
+  void lock() noexcept {
+    while (_flag.exchange(true, std::memory_order_acquire))
+      while (_flag.load(std::memory_order_relaxed))
+        std::this_thread::yield();
+  }
+  bool try_lock() noexcept {
+    return !_flag.load(std::memory_order_relaxed) && !_flag.exchange(true, std::memory_order_acquire);
+  }
+  void unlock() noexcept { _flag.store(false, std::memory_order_release); }
+private:
+  std::atomic<bool> _flag{false};
+};
+
+// Makes a stateful (single threaded) allocator like bpool_alloc shareable between threads:
+// every allocate/deallocate runs under a spin lock. Rebound copies get the inner allocator rebound from the other's
+// (bpool_alloc: own empty pools, the same placement policy, backend, budget and sizing record).
+template <class Alloc>
+struct sync_alloc {
+  using inner_allocator_type = Alloc;
+  using inner_traits = std::allocator_traits<Alloc>;
+  using value_type = typename inner_traits::value_type;
+  using pointer = typename inner_traits::pointer;
+  using const_pointer = typename inner_traits::const_pointer;
+  // one allocator may be used by several threads at once (slist::parallel_append shares it)
+  static constexpr bool concurrent = true;
+private:
+  Alloc _inner;
+  spin_lock _lock;
+public:
+  // the inner allocator's arguments; never a sync_alloc itself (copies are deleted, an lvalue would be forwarded in)
+  template <typename... Args>
+    requires std::constructible_from<Alloc, Args...> &&
+             (sizeof...(Args) != 1 || !(std::same_as<std::remove_cvref_t<Args>, sync_alloc> && ...))
+  sync_alloc(Args&&... args) : _inner(std::forward<Args>(args)...) {}
+  sync_alloc(const sync_alloc &) = delete;
+  sync_alloc(sync_alloc && other) noexcept : _inner(std::move(other._inner)) {}
+  sync_alloc &operator=(const sync_alloc &) = delete;
+
+  template <class U>
+  sync_alloc(sync_alloc<U> const& other) noexcept : _inner(other._inner) {}
+  template <class> friend struct sync_alloc;
+
+  template <class Up> struct rebind {
+    using other = sync_alloc<typename inner_traits::template rebind_alloc<Up>>;
+  };
+
+  pointer allocate(size_t n = 1) {
+    std::lock_guard guard(_lock);
+    return inner_traits::allocate(_inner, n);
+  }
+
+  pointer allocate(size_t n, const void *hint) {
+    std::lock_guard guard(_lock);
+    return inner_traits::allocate(_inner, n, hint);
+  }
+
+  void deallocate(pointer ptr, size_t n = 1) {
+    std::lock_guard guard(_lock);
+    inner_traits::deallocate(_inner, ptr, n);
+  }
+
+  // not synchronized: for inspection when no other thread uses the allocator
+  Alloc &inner() noexcept { return _inner; }
+};
+
+} // namespace alloc
@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "bpool_alloc.hpp"
+#include "memory_budget.hpp"
+#include "sync_alloc.hpp"
+
+using namespace alloc;
+
+// the forwarding constructor takes the inner allocator's arguments only, not a (copy deleted) sync_alloc lvalue
+static_assert(std::is_constructible_v<sync_alloc<bpool_alloc<size_t, 512>>, placement_policy>);
+static_assert(!std::is_constructible_v<sync_alloc<bpool_alloc<size_t, 512>>, sync_alloc<bpool_alloc<size_t, 512>>&>);
+
+TEST(alloc_unit_tests, sync_alloc_threads){
+    constexpr size_t threads = 4;
+    constexpr size_t per_thread = 1000;
+    sync_alloc<bpool_alloc<size_t, 512>> sa(placement_policy::last);
+
+    std::vector<std::vector<size_t*>> owned(threads);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t)
+        workers.emplace_back([&, t]{
+            for (size_t i = 0; i < per_thread; ++i) {
+                size_t* p = sa.allocate();
+                *p = t * per_thread + i;
+                owned[t].push_back(p);
+                if (i % 3 == 0) {           // churn: give every third slot back right away
+                    sa.deallocate(owned[t].back());
+                    owned[t].pop_back();
+                }
+            }
+        });
+    for (auto& w: workers)
+        w.join();
+
+    std::vector<size_t*> all;
+    for (size_t t = 0; t < threads; ++t) {
+        for (size_t* p: owned[t])
+            EXPECT_EQ(*p / per_thread, t);  // nobody else got the same slot
+        all.insert(all.end(), owned[t].begin(), owned[t].end());
+    }
+    std::sort(all.begin(), all.end());
+    EXPECT_EQ(std::adjacent_find(all.begin(), all.end()), all.end());
+    EXPECT_EQ(sa.inner().used_count(), all.size());
+
+    for (size_t* p: all)
+        sa.deallocate(p);
+    EXPECT_EQ(sa.inner().used_count(), 0);
+}
+
+TEST(alloc_unit_tests, sync_alloc_rebind){
+    memory_budget budget(1 << 20);
+    sync_alloc<bpool_alloc<size_t, 512>> sa(placement_policy::buddy, segment_backend::heap, &budget);
+    sync_alloc<bpool_alloc<int, 512>> rebound(sa);  // as slist and mpsc_queue convert the one given them
+    EXPECT_FALSE(rebound.inner().allocates_slots());    // still buddy
+    EXPECT_EQ(rebound.inner().budget(), &budget);
+    EXPECT_EQ(rebound.inner().used_count(), 0);         // pools of its own
+    int *p = rebound.allocate(1);
+    EXPECT_EQ(budget.used(), 512 * sizeof(int));        // its segment charged to the shared budget
+    rebound.deallocate(p, 1);
+}
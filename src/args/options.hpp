@@ -1,5 +1,6 @@
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 
@@ -8,6 +9,8 @@
 
 #include <info/version.h>
 
+#include "bench/workload.hpp"
+
 namespace args {
 
 namespace opt = boost::program_options;
@@ -26,12 +29,29 @@ inline auto parse(int argc, char const *argv[]) {
     ("logs",              opt::value<std::string>(), "Logging output file name [default:clog]")
 #endif
   ;
+  opt::options_description bench_desc("Bench (allo bench [options]): synthetic allocator workload, latency percentiles");
+  bench_desc.add_options()
+    ("allocator,a", opt::value<std::string>()->default_value("bpool-first"), "std | bpool-first | bpool-last | bpool-buddy | bpool-adaptive")
+    ("size,s",      opt::value<size_t>()->default_value(64), "Element size in bytes, a power of two in 8..4096")
+    ("mix,m",       opt::value<std::string>()->default_value("alloc=50,free=50"), "Operation weights: alloc (one element), array (2..array-max elements), free")
+    ("array-max",   opt::value<size_t>()->default_value(16), "Largest array block in elements")
+    ("live,n",      opt::value<size_t>()->default_value(10000), "Live set: blocks allocated before timing, per thread")
+    ("threads,t",   opt::value<unsigned>()->default_value(1), "Threads, each with its own allocator")
+    ("duration,d",  opt::value<double>()->default_value(1.0), "Timed part in seconds")
+    ("sizing-profile", opt::value<std::string>(), "bpool allocators: start with the pool shape recorded in this file, write this run's at exit")
+  ;
+  opt::options_description hidden;
+  hidden.add_options()
+    ("command",     opt::value<std::string>()->default_value("demo"), "demo | bench")
+  ;
   // clang-format on
-  // opt::positional_options_description pos_desc;
-  // pos_desc.add("input", -1);
+  desc.add(bench_desc);
+  opt::options_description all;
+  all.add(desc).add(hidden);
+  opt::positional_options_description pos_desc;
+  pos_desc.add("command", 1);
   opt::variables_map vm;
-  // opt::store(opt::command_line_parser(argc, argv).options(desc).positional(pos_desc).run(), vm);
-  opt::store(opt::command_line_parser(argc, argv).options(desc).run(), vm);
+  opt::store(opt::command_line_parser(argc, argv).options(all).positional(pos_desc).run(), vm);
   opt::notify(vm);
   return std::make_tuple(std::move(desc), std::move(vm));
 }
@@ -52,4 +72,36 @@ inline bool info_requested(const opt::variables_map &vm, const opt::options_desc
   return false;
 }
 
+inline bench::config bench_config(const opt::variables_map &vm) {
+  bench::config cfg;
+  const auto &allocator = vm["allocator"].as<std::string>();
+  if (allocator == "std")
+    cfg.allocator = bench::allocator_kind::std;
+  else if (allocator == "bpool-first")
+    cfg.allocator = bench::allocator_kind::bpool_first;
+  else if (allocator == "bpool-last")
+    cfg.allocator = bench::allocator_kind::bpool_last;
+  else if (allocator == "bpool-buddy")
+    cfg.allocator = bench::allocator_kind::bpool_buddy;
+  else if (allocator == "bpool-adaptive")
+    cfg.allocator = bench::allocator_kind::bpool_adaptive;
+  else
+    throw opt::invalid_option_value(allocator);
+  cfg.element_size = vm["size"].as<size_t>();
+  if (cfg.element_size < 8 || cfg.element_size > 4096 || (cfg.element_size & (cfg.element_size - 1)) != 0)
+    throw opt::invalid_option_value(std::to_string(cfg.element_size));
+  try {
+    bench::parse_mix(vm["mix"].as<std::string>(), cfg.mix);
+  } catch (const std::exception &) {
+    throw opt::invalid_option_value(vm["mix"].as<std::string>());
+  }
+  cfg.array_max = vm["array-max"].as<size_t>();
+  cfg.live = vm["live"].as<size_t>();
+  cfg.threads = vm["threads"].as<unsigned>();
+  cfg.duration = std::chrono::duration<double>(vm["duration"].as<double>());
+  if (cfg.threads == 0 || cfg.duration.count() <= 0)
+    throw opt::invalid_option_value(cfg.threads == 0 ? "threads=0" : "duration<=0");
+  return cfg;
+}
+
 } // namespace args
@@ -0,0 +1,251 @@
+#pragma once
+
+// Synthetic allocator workload of `allo bench`: every thread keeps its own allocator and a live set of
+// blocks, and runs a random mix of operations on them for a fixed time. Each operation is timed alone
+// (steady_clock around the allocator call, so latencies include ~20 ns of clock reads) into a histogram.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "alloc/bpool_alloc.hpp"
+#include "utils/histogram.hpp"
+
+namespace bench {
+
+enum class allocator_kind { std, bpool_first, bpool_last, bpool_buddy, bpool_adaptive };
+enum op { op_alloc, op_array, op_free, op_count };
+inline constexpr const char *op_names[op_count] = {"alloc", "array", "free"};
+
+struct config {
+  allocator_kind allocator = allocator_kind::bpool_first;
+  size_t element_size = 64;
+  unsigned mix[op_count] = {50, 0, 50}; // relative weights
+  size_t array_max = 16;                // op_array blocks are 2..array_max elements
+  size_t live = 10000;                  // blocks allocated before timing, the live set wanders in [0, 2 * live]
+  unsigned threads = 1;
+  std::chrono::duration<double> duration{1.0};
+  // bpool allocators: profile guided (a tag per element size and thread), their policy is the fallback
+  alloc::sizing_profile *sizing = nullptr;
+};
+
+struct report {
+  utils::histogram latency[op_count]; // ns
+  utils::histogram failed;            // ns, alloc / array that found the pool exhausted (std::bad_alloc), not in latency
+  std::chrono::duration<double> elapsed{};
+};
+
+// bpool_alloc segments: the first one holds 64K slots, all five 2M (bad_alloc past them)
+inline constexpr size_t bpool_segment_elements = 1 << 16;
+
+// "alloc=45,array=5,free=50": weights of the named operations, the others get 0
+inline void parse_mix(const std::string &text, unsigned (&mix)[op_count]) {
+  unsigned parsed[op_count] = {};
+  size_t pos = 0;
+  while (pos < text.size()) {
+    auto end = std::min(text.find(',', pos), text.size());
+    auto item = text.substr(pos, end - pos);
+    auto eq = item.find('=');
+    auto found = std::find_if(std::begin(op_names), std::end(op_names),
+                              [&](const char *n) { return item.compare(0, eq, n) == 0; });
+    if (eq == std::string::npos || found == std::end(op_names))
+      throw std::invalid_argument("bad operation in mix: " + item);
+    parsed[found - std::begin(op_names)] = static_cast<unsigned>(std::stoul(item.substr(eq + 1)));
+    pos = end + 1;
+  }
+  if (parsed[op_free] == 0 || parsed[op_alloc] + parsed[op_array] == 0)
+    throw std::invalid_argument("mix needs an allocating operation and free");
+  std::copy(std::begin(parsed), std::end(parsed), mix);
+}
+
+namespace details {
+
+template <size_t S>
+struct payload {
+  std::byte bytes[S];
+};
+
+using clock = std::chrono::steady_clock;
+
+inline uint64_t ns_since(clock::time_point start, clock::time_point end) noexcept {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+template <typename Alloc>
+void run_thread(const config &cfg, unsigned index, Alloc &alloc, std::atomic<unsigned> &ready,
+                std::atomic<bool> &go, report &out) {
+  using T = typename Alloc::value_type;
+  struct block {
+    T *p;
+    size_t n;
+  };
+  std::mt19937_64 rng(index + 1);
+  std::discrete_distribution<int> pick(std::begin(cfg.mix), std::end(cfg.mix));
+  std::uniform_int_distribution<size_t> array_n(2, std::max<size_t>(cfg.array_max, 2));
+  std::vector<block> live;
+  live.reserve(2 * cfg.live + 1);
+  for (size_t i = 0; i < cfg.live; ++i)
+    live.push_back({alloc.allocate(1), 1});
+
+  ++ready;
+  while (!go.load(std::memory_order_acquire))
+    std::this_thread::yield();
+  const auto start = clock::now();
+  const auto stop = start + std::chrono::duration_cast<clock::duration>(cfg.duration);
+  auto now = start;
+  while (now < stop) {
+    int o = pick(rng);
+    if (o != op_free && live.size() >= 2 * cfg.live + 1)
+      o = op_free;
+    else if (o == op_free && live.empty())
+      o = op_alloc;
+    if (o == op_free) {
+      auto i = std::uniform_int_distribution<size_t>(0, live.size() - 1)(rng);
+      auto b = live[i];
+      live[i] = live.back();
+      live.pop_back();
+      auto t0 = clock::now();
+      alloc.deallocate(b.p, b.n);
+      now = clock::now();
+      out.latency[o].record(ns_since(t0, now));
+    } else {
+      size_t n = o == op_array ? array_n(rng) : 1;
+      T *p = nullptr;
+      auto t0 = clock::now();
+      try {
+        p = alloc.allocate(n);
+      } catch (const std::bad_alloc &) { // e.g. bpool-last: random frees seldom move the cursor back
+      }
+      now = clock::now();
+      if (p == nullptr) {
+        out.failed.record(ns_since(t0, now));
+        continue;
+      }
+      out.latency[o].record(ns_since(t0, now));
+      reinterpret_cast<volatile std::byte &>(p->bytes[0]) = std::byte{1}; // the caller touches what it got
+      live.push_back({p, n});
+    }
+  }
+  out.elapsed = now - start;
+  for (auto b : live)
+    alloc.deallocate(b.p, b.n);
+}
+
+template <typename Alloc, typename Make>
+std::vector<report> run_threads(const config &cfg, Make make) {
+  std::vector<report> reports(cfg.threads);
+  std::vector<std::exception_ptr> errors(cfg.threads);
+  std::atomic<bool> go{false};
+  std::atomic<unsigned> ready{0};
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < cfg.threads; ++t)
+    threads.emplace_back([&, t] {
+      try {
+        Alloc alloc = make(t);
+        run_thread(cfg, t, alloc, ready, go, reports[t]);
+      } catch (...) {
+        errors[t] = std::current_exception();
+        ++ready; // may count twice: only makes the start earlier
+      }
+    });
+  while (ready.load() < cfg.threads) // every live set is in place: the timed part starts together
+    std::this_thread::yield();
+  go.store(true, std::memory_order_release);
+  for (auto &th : threads)
+    th.join();
+  for (auto &e : errors)
+    if (e)
+      std::rethrow_exception(e);
+  return reports;
+}
+
+template <size_t S>
+std::vector<report> run_sized(const config &cfg) {
+  using T = payload<S>;
+  switch (cfg.allocator) {
+  case allocator_kind::std:
+    return run_threads<std::allocator<T>>(cfg, [](unsigned) { return std::allocator<T>(); });
+  case allocator_kind::bpool_first:
+  case allocator_kind::bpool_last:
+  case allocator_kind::bpool_buddy:
+  case allocator_kind::bpool_adaptive: {
+    auto policy = cfg.allocator == allocator_kind::bpool_first   ? alloc::placement_policy::first
+                  : cfg.allocator == allocator_kind::bpool_last  ? alloc::placement_policy::last
+                  : cfg.allocator == allocator_kind::bpool_buddy ? alloc::placement_policy::buddy
+                                                                 : alloc::placement_policy::adaptive;
+    using A = alloc::bpool_alloc<T, bpool_segment_elements>;
+    if (cfg.sizing != nullptr) {
+      std::vector<alloc::sizing_record *> records; // looked up here: the profile's map is not synchronized
+      for (unsigned t = 0; t < cfg.threads; ++t)
+        records.push_back(&(*cfg.sizing)[std::format("bench-{}-{}", S, t)]);
+      return run_threads<A>(cfg, [&records, policy](unsigned t) { return A(*records[t], policy); });
+    }
+    return run_threads<A>(cfg, [policy](unsigned) { return A(policy); });
+  }
+  }
+  throw std::invalid_argument("unknown allocator");
+}
+
+} // namespace details
+
+// element sizes: powers of two 8..4096 (the payload types are compiled in)
+inline std::vector<report> run(const config &cfg) {
+  switch (cfg.element_size) {
+  case 8: return details::run_sized<8>(cfg);
+  case 16: return details::run_sized<16>(cfg);
+  case 32: return details::run_sized<32>(cfg);
+  case 64: return details::run_sized<64>(cfg);
+  case 128: return details::run_sized<128>(cfg);
+  case 256: return details::run_sized<256>(cfg);
+  case 512: return details::run_sized<512>(cfg);
+  case 1024: return details::run_sized<1024>(cfg);
+  case 2048: return details::run_sized<2048>(cfg);
+  case 4096: return details::run_sized<4096>(cfg);
+  default: throw std::invalid_argument(std::format("element size {} is not a power of two in 8..4096", cfg.element_size));
+  }
+}
+
+// per operation over all threads: count, throughput, p50 / p99 / p99.9 / max in ns, and the failed allocations
+// (left out of the total) if there were any
+inline void print(std::ostream &os, const std::vector<report> &reports) {
+  report total;
+  for (auto &r : reports) {
+    for (int o = 0; o < op_count; ++o)
+      total.latency[o].merge(r.latency[o]);
+    total.failed.merge(r.failed);
+    total.elapsed = std::max(total.elapsed, r.elapsed);
+  }
+  const double seconds = total.elapsed.count();
+  uint64_t all = 0;
+  os << std::format("{:<6} {:>12} {:>10} {:>8} {:>8} {:>8} {:>8} {:>10}\n", "op", "count", "Mops/s", "mean", "p50", "p99",
+                    "p99.9", "max");
+  auto row = [&](const char *name, const utils::histogram &h) {
+    os << std::format("{:<6} {:>12} {:>10.3f} {:>8.1f} {:>8} {:>8} {:>8} {:>10}\n", name, h.count(),
+                      h.count() / seconds / 1e6, h.mean(), h.percentile(50), h.percentile(99), h.percentile(99.9), h.max());
+  };
+  for (int o = 0; o < op_count; ++o) {
+    const auto &h = total.latency[o];
+    if (h.count() == 0)
+      continue;
+    all += h.count();
+    row(op_names[o], h);
+  }
+  if (total.failed.count() != 0)
+    row("failed", total.failed);
+  os << std::format("{:<6} {:>12} {:>10.3f}   (latencies in ns, {} thread(s), {:.2f} s)\n", "total", all,
+                    all / seconds / 1e6, reports.size(), seconds);
+}
+
+} // namespace bench
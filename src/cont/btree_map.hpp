@@ -0,0 +1,756 @@
+//-----------------------------------------------------------------------------
+//
+// ordered map on a B+ tree: values live in wide leaves chained for iteration,
+// internal nodes only hold separator keys. One node per ~dozen entries instead of
+// std::map's node per entry, so lookups and iteration touch far fewer cache lines.
+//
+// Interface follows std::map for lookup, insert, erase and ordered iteration.
+// Differences: any insert or erase invalidates all iterators (elements move between
+// nodes), Key and T must be nothrow movable and Key copyable (separators are copies).
+//
+//----------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace cont {
+namespace btree_map_details {
+
+// ~4 cache lines per node, but never less than 4 entries
+constexpr size_t node_bytes = 256;
+
+template <typename K, typename V>
+constexpr size_t default_leaf_capacity() {
+  return std::max<size_t>(4, (node_bytes - 3 * sizeof(void *)) / sizeof(std::pair<K, V>));
+}
+
+template <typename K>
+constexpr size_t default_internal_capacity() {
+  return std::max<size_t>(4, (node_bytes - 2 * sizeof(void *)) / (sizeof(K) + sizeof(void *)));
+}
+
+struct node_base {
+  uint16_t count_; // values in a leaf, keys in an internal node
+  bool leaf_;
+  node_base(bool leaf) : count_(0), leaf_(leaf) {}
+};
+
+// slots are stored as mutable pairs so they can be shifted by move assignment,
+// iterators expose them as pair<const K, V> (same layout, the usual B-tree map trick)
+template <typename K, typename V, size_t L>
+struct leaf : node_base {
+  leaf *prev_;
+  leaf *next_;
+  union {
+    std::pair<K, V> slots_[L];
+  };
+  leaf() : node_base(true), prev_(nullptr), next_(nullptr) {}
+  ~leaf() {}
+};
+
+// children_[i] holds keys < keys_[i] <= keys of children_[i + 1]
+template <typename K, size_t I>
+struct internal : node_base {
+  union {
+    K keys_[I];
+  };
+  node_base *children_[I + 1];
+  internal() : node_base(false) {}
+  ~internal() {}
+};
+
+// shifting inside a node: a[0, count) are alive, a[count] is raw storage
+template <typename U, typename... Args>
+void insert_slot(U *a, size_t count, size_t pos, Args &&...args) {
+  if (pos == count) {
+    ::new (static_cast<void *>(a + count)) U(std::forward<Args>(args)...);
+    return;
+  }
+  U tmp(std::forward<Args>(args)...);
+  ::new (static_cast<void *>(a + count)) U(std::move(a[count - 1]));
+  std::move_backward(a + pos, a + count - 1, a + count);
+  a[pos] = std::move(tmp);
+}
+
+template <typename U>
+void erase_slot(U *a, size_t count, size_t pos) noexcept {
+  std::move(a + pos + 1, a + count, a + pos);
+  a[count - 1].~U();
+}
+
+template <typename K, typename V, size_t L, bool Const>
+struct iterator {
+  using value_type = std::pair<const K, V>;
+  using reference = std::conditional_t<Const, value_type const &, value_type &>;
+  using pointer = std::conditional_t<Const, value_type const *, value_type *>;
+  using difference_type = ptrdiff_t;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using leaf_type = leaf<K, V, L>;
+
+  reference operator*() const { return *operator->(); }
+  pointer operator->() const { return std::launder(reinterpret_cast<value_type *>(&leaf_->slots_[idx_])); }
+
+  // end() is one past the last slot of the rightmost leaf
+  iterator &operator++() {
+    if (++idx_ == leaf_->count_ && leaf_->next_ != nullptr) {
+      leaf_ = leaf_->next_;
+      idx_ = 0;
+    }
+    return *this;
+  }
+  iterator operator++(int) {
+    iterator tmp(*this);
+    ++*this;
+    return tmp;
+  }
+  iterator &operator--() {
+    if (idx_ == 0) {
+      leaf_ = leaf_->prev_;
+      idx_ = leaf_->count_;
+    }
+    --idx_;
+    return *this;
+  }
+  iterator operator--(int) {
+    iterator tmp(*this);
+    --*this;
+    return tmp;
+  }
+
+  bool operator==(const iterator &other) const { return leaf_ == other.leaf_ && idx_ == other.idx_; }
+  bool operator!=(const iterator &other) const { return !operator==(other); }
+
+  iterator() = default;
+  iterator(leaf_type *l, size_t idx) : leaf_(l), idx_(idx) {}
+  template <bool C = Const>
+    requires C
+  iterator(const iterator<K, V, L, false> &other) : leaf_(other.leaf_), idx_(other.idx_) {}
+
+  leaf_type *leaf_ = nullptr;
+  size_t idx_ = 0;
+};
+
+} // namespace btree_map_details
+
+template <typename Key, typename T,
+          typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+struct btree_map {
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using key_compare = Compare;
+  using reference = value_type &;
+  using const_reference = value_type const &;
+  using difference_type = ptrdiff_t;
+  using size_type = size_t;
+  using allocator_type = Allocator;
+  using alloc_traits = std::allocator_traits<allocator_type>;
+
+  constexpr static size_t leaf_capacity = btree_map_details::default_leaf_capacity<Key, T>();
+  constexpr static size_t internal_capacity = btree_map_details::default_internal_capacity<Key>();
+
+  using iterator = btree_map_details::iterator<Key, T, leaf_capacity, false>;
+  using const_iterator = btree_map_details::iterator<Key, T, leaf_capacity, true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  static_assert(std::is_nothrow_move_constructible_v<Key> && std::is_nothrow_move_assignable_v<Key> &&
+                std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>,
+                "btree_map shifts entries between nodes, Key and T must be nothrow movable");
+
+private:
+  using leaf = btree_map_details::leaf<Key, T, leaf_capacity>;
+  using internal = btree_map_details::internal<Key, internal_capacity>;
+  using node_base = btree_map_details::node_base;
+  using leaf_allocator_type = typename alloc_traits::template rebind_alloc<leaf>;
+  using internal_allocator_type = typename alloc_traits::template rebind_alloc<internal>;
+  using leaf_alloc_traits = std::allocator_traits<leaf_allocator_type>;
+  using internal_alloc_traits = std::allocator_traits<internal_allocator_type>;
+
+  constexpr static size_t min_leaf = leaf_capacity / 2;
+  constexpr static size_t min_internal = internal_capacity / 2;
+  // fan-out is at least 3, 40 levels are far beyond any addressable size
+  constexpr static size_t max_depth = 40;
+
+  // internal nodes visited from the root and the child taken in each
+  struct path {
+    std::array<std::pair<internal *, size_t>, max_depth> e;
+    size_t depth = 0;
+  };
+
+  node_base *root_;
+  leaf *leftmost_;
+  leaf *rightmost_;
+  size_t size_;
+  [[no_unique_address]] Compare comp_;
+  leaf_allocator_type leaf_alloc_;
+  internal_allocator_type internal_alloc_;
+
+  leaf *new_leaf_() {
+    leaf *l = leaf_alloc_traits::allocate(leaf_alloc_, 1);
+    return ::new (static_cast<void *>(l)) leaf();
+  }
+  internal *new_internal_() {
+    internal *n = internal_alloc_traits::allocate(internal_alloc_, 1);
+    return ::new (static_cast<void *>(n)) internal();
+  }
+  void free_leaf_(leaf *l) {
+    l->~leaf();
+    leaf_alloc_traits::deallocate(leaf_alloc_, l, 1);
+  }
+  void free_internal_(internal *n) {
+    n->~internal();
+    internal_alloc_traits::deallocate(internal_alloc_, n, 1);
+  }
+  void free_subtree_(node_base *n);
+
+  size_t lower_bound_(const leaf *l, const Key &key) const {
+    size_t lo = 0, hi = l->count_;
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if (comp_(l->slots_[mid].first, key))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+  size_t child_index_(const internal *n, const Key &key) const {
+    size_t lo = 0, hi = n->count_;
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if (comp_(key, n->keys_[mid]))
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    return lo;
+  }
+  // leaf that holds key, or where it would be inserted; root_ must not be null
+  leaf *descend_(const Key &key, path *p) const {
+    node_base *n = root_;
+    while (!n->leaf_) {
+      internal *in = static_cast<internal *>(n);
+      size_t ci = child_index_(in, key);
+      if (p != nullptr)
+        p->e[p->depth++] = {in, ci};
+      n = in->children_[ci];
+    }
+    return static_cast<leaf *>(n);
+  }
+  // position idx == count of a non rightmost leaf is the first slot of the next one
+  static iterator make_iter_(leaf *l, size_t idx) noexcept {
+    if (idx == l->count_ && l->next_ != nullptr)
+      return iterator(l->next_, 0);
+    return iterator(l, idx);
+  }
+
+  void unlink_leaf_(leaf *l) noexcept {
+    (l->prev_ != nullptr ? l->prev_->next_ : leftmost_) = l->next_;
+    (l->next_ != nullptr ? l->next_->prev_ : rightmost_) = l->prev_;
+  }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace_(K &&key, Args &&...args);
+  template <typename K, typename... Args>
+  iterator insert_at_(path &p, leaf *l, size_t idx, K &&key, Args &&...args);
+  void insert_child_(path &p, Key sep, node_base *right, internal **spare);
+  iterator erase_at_(path &p, leaf *l, size_t idx);
+  void rebalance_internal_(path &p, size_t d);
+
+public:
+  btree_map() : btree_map(Compare()) {}
+  explicit btree_map(const Compare &comp, const Allocator &a = Allocator())
+      : root_(nullptr), leftmost_(nullptr), rightmost_(nullptr), size_(0), comp_(comp),
+        leaf_alloc_(a), internal_alloc_(a) {}
+  template <std::input_iterator It>
+  btree_map(It first, It last, const Compare &comp = Compare()) : btree_map(comp) {
+    insert(first, last);
+  }
+  btree_map(std::initializer_list<value_type> il, const Compare &comp = Compare()) : btree_map(comp) {
+    insert(il);
+  }
+  btree_map(const btree_map &other) : btree_map(other.comp_) {
+    operator=(other);
+  }
+  btree_map(btree_map &&other) noexcept
+      : root_(other.root_), leftmost_(other.leftmost_), rightmost_(other.rightmost_), size_(other.size_),
+        comp_(other.comp_), leaf_alloc_(std::move(other.leaf_alloc_)), internal_alloc_(std::move(other.internal_alloc_)) {
+    other.root_ = nullptr;
+    other.leftmost_ = other.rightmost_ = nullptr;
+    other.size_ = 0;
+  }
+  ~btree_map() { clear(); }
+
+  btree_map &operator=(const btree_map &other);
+  btree_map &operator=(btree_map &&other);
+  void swap(btree_map &other) noexcept;
+
+  size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return 0 == size_; }
+  key_compare key_comp() const { return comp_; }
+
+  iterator begin() noexcept { return iterator(leftmost_, 0); }
+  iterator end() noexcept { return rightmost_ ? iterator(rightmost_, rightmost_->count_) : iterator(); }
+  const_iterator begin() const noexcept { return const_cast<btree_map *>(this)->begin(); }
+  const_iterator end() const noexcept { return const_cast<btree_map *>(this)->end(); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+  // lookup
+  iterator lower_bound(const Key &key) {
+    if (root_ == nullptr)
+      return end();
+    leaf *l = descend_(key, nullptr);
+    return make_iter_(l, lower_bound_(l, key));
+  }
+  iterator upper_bound(const Key &key) {
+    iterator it = lower_bound(key);
+    if (it != end() && !comp_(key, it->first))
+      ++it;
+    return it;
+  }
+  iterator find(const Key &key) {
+    iterator it = lower_bound(key);
+    return (it != end() && !comp_(key, it->first)) ? it : end();
+  }
+  std::pair<iterator, iterator> equal_range(const Key &key) {
+    iterator lo = lower_bound(key);
+    iterator hi = lo;
+    if (hi != end() && !comp_(key, hi->first))
+      ++hi;
+    return {lo, hi};
+  }
+  const_iterator lower_bound(const Key &key) const { return const_cast<btree_map *>(this)->lower_bound(key); }
+  const_iterator upper_bound(const Key &key) const { return const_cast<btree_map *>(this)->upper_bound(key); }
+  const_iterator find(const Key &key) const { return const_cast<btree_map *>(this)->find(key); }
+  std::pair<const_iterator, const_iterator> equal_range(const Key &key) const {
+    return const_cast<btree_map *>(this)->equal_range(key);
+  }
+  bool contains(const Key &key) const { return find(key) != end(); }
+  size_t count(const Key &key) const { return contains(key) ? 1 : 0; }
+
+  T &at(const Key &key) {
+    iterator it = find(key);
+    if (it == end())
+      throw std::out_of_range("btree_map::at");
+    return it->second;
+  }
+  T const &at(const Key &key) const { return const_cast<btree_map *>(this)->at(key); }
+  T &operator[](const Key &key) { return try_emplace_(key).first->second; }
+  T &operator[](Key &&key) { return try_emplace_(std::move(key)).first->second; }
+
+  // insert
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const Key &key, Args &&...args) {
+    return try_emplace_(key, std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(Key &&key, Args &&...args) {
+    return try_emplace_(std::move(key), std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&...args) {
+    std::pair<Key, T> v(std::forward<Args>(args)...);
+    return try_emplace_(std::move(v.first), std::move(v.second));
+  }
+  // the hint is not used: a descent from the root is a handful of node visits
+  template <typename... Args>
+  iterator emplace_hint(const_iterator, Args &&...args) {
+    return emplace(std::forward<Args>(args)...).first;
+  }
+  std::pair<iterator, bool> insert(const value_type &v) { return try_emplace_(v.first, v.second); }
+  template <typename P>
+    requires std::is_constructible_v<value_type, P &&>
+  std::pair<iterator, bool> insert(P &&v) {
+    return emplace(std::forward<P>(v));
+  }
+  iterator insert(const_iterator hint, const value_type &v) { return emplace_hint(hint, v); }
+  template <std::input_iterator It>
+  void insert(It first, It last) {
+    for (; first != last; ++first)
+      emplace(*first);
+  }
+  void insert(std::initializer_list<value_type> il) { insert(il.begin(), il.end()); }
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const Key &key, M &&obj) {
+    auto res = try_emplace_(key, std::forward<M>(obj));
+    if (!res.second)
+      res.first->second = std::forward<M>(obj);
+    return res;
+  }
+
+  // erase
+  size_t erase(const Key &key) {
+    if (root_ == nullptr)
+      return 0;
+    path p;
+    leaf *l = descend_(key, &p);
+    size_t idx = lower_bound_(l, key);
+    if (idx == l->count_ || comp_(key, l->slots_[idx].first))
+      return 0;
+    erase_at_(p, l, idx);
+    return 1;
+  }
+  // returns the successor of the erased element (previously obtained iterators are invalid)
+  iterator erase(const_iterator it) {
+    path p;
+    leaf *l = descend_(it.leaf_->slots_[it.idx_].first, &p);
+    assert(l == it.leaf_);
+    return erase_at_(p, l, it.idx_);
+  }
+  iterator erase(iterator it) { return erase(const_iterator(it)); }
+  iterator erase(const_iterator first, const_iterator last);
+
+  void clear() {
+    if (root_ != nullptr)
+      free_subtree_(root_);
+    root_ = nullptr;
+    leftmost_ = rightmost_ = nullptr;
+    size_ = 0;
+  }
+
+  leaf_allocator_type &get_leaf_allocator() & { return leaf_alloc_; }
+  internal_allocator_type &get_internal_allocator() & { return internal_alloc_; }
+};
+
+template <typename K, typename T, typename C, typename A>
+bool operator==(const btree_map<K, T, C, A> &a, const btree_map<K, T, C, A> &b) {
+  return (a.size() == b.size()) && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename K, typename T, typename C, typename A>
+bool operator!=(const btree_map<K, T, C, A> &a, const btree_map<K, T, C, A> &b) {
+  return !(a == b);
+}
+
+template <typename K, typename T, typename C, typename A>
+btree_map<K, T, C, A> &btree_map<K, T, C, A>::operator=(const btree_map &other) {
+  if (&other == this)
+    return *this;
+  clear();
+  comp_ = other.comp_;
+  for (const value_type &v : other)
+    try_emplace_(v.first, v.second);
+  return *this;
+}
+
+template <typename K, typename T, typename C, typename A>
+btree_map<K, T, C, A> &btree_map<K, T, C, A>::operator=(btree_map &&other) {
+  if (&other == this)
+    return *this;
+  clear();
+  if constexpr (leaf_alloc_traits::is_always_equal::value && internal_alloc_traits::is_always_equal::value) {
+    swap(other);
+  } else {
+    comp_ = other.comp_;
+    for (value_type &v : other)
+      try_emplace_(v.first, std::move(v.second));
+    other.clear();
+  }
+  return *this;
+}
+
+template <typename K, typename T, typename C, typename A>
+void btree_map<K, T, C, A>::swap(btree_map &other) noexcept {
+  using std::swap;
+  swap(root_, other.root_);
+  swap(leftmost_, other.leftmost_);
+  swap(rightmost_, other.rightmost_);
+  swap(size_, other.size_);
+  swap(comp_, other.comp_);
+  if constexpr (leaf_alloc_traits::propagate_on_container_swap::value) {
+    swap(leaf_alloc_, other.leaf_alloc_);
+    swap(internal_alloc_, other.internal_alloc_);
+  }
+}
+
+template <typename K, typename T, typename C, typename A>
+void btree_map<K, T, C, A>::free_subtree_(node_base *n) {
+  if (n->leaf_) {
+    leaf *l = static_cast<leaf *>(n);
+    std::destroy_n(l->slots_, l->count_);
+    free_leaf_(l);
+    return;
+  }
+  internal *in = static_cast<internal *>(n);
+  for (size_t i = 0; i <= in->count_; ++i)
+    free_subtree_(in->children_[i]);
+  std::destroy_n(in->keys_, in->count_);
+  free_internal_(in);
+}
+
+template <typename K, typename T, typename C, typename A>
+template <typename KK, typename... Args>
+std::pair<typename btree_map<K, T, C, A>::iterator, bool> btree_map<K, T, C, A>::try_emplace_(KK &&key, Args &&...args) {
+  if (root_ == nullptr)
+    root_ = leftmost_ = rightmost_ = new_leaf_();
+  path p;
+  leaf *l = descend_(key, &p);
+  size_t idx = lower_bound_(l, key);
+  if (idx < l->count_ && !comp_(key, l->slots_[idx].first))
+    return {iterator(l, idx), false};
+  return {insert_at_(p, l, idx, std::forward<KK>(key), std::forward<Args>(args)...), true};
+}
+
+// Splits a full leaf first. Every node the split cascade needs is allocated and the separator
+// copied before anything moves, so a throwing allocator or key copy leaves the tree untouched.
+template <typename K, typename T, typename C, typename A>
+template <typename KK, typename... Args>
+typename btree_map<K, T, C, A>::iterator btree_map<K, T, C, A>::insert_at_(path &p, leaf *l, size_t idx, KK &&key, Args &&...args) {
+  if (l->count_ == leaf_capacity) {
+    size_t d = p.depth;
+    while (d > 0 && p.e[d - 1].first->count_ == internal_capacity)
+      --d;
+    // one internal node per full ancestor, plus a new root if all of them are full
+    size_t needed = p.depth - d + (d == 0 ? 1 : 0);
+    internal *spare[max_depth + 1];
+    size_t allocated = 0;
+    leaf *r = nullptr;
+    try {
+      for (; allocated < needed; ++allocated)
+        spare[allocated] = new_internal_();
+      r = new_leaf_();
+    } catch (...) {
+      while (allocated)
+        free_internal_(spare[--allocated]);
+      throw;
+    }
+    // appending to the rightmost leaf (ascending fill) starts a new leaf instead of halving a full one
+    bool append = idx == leaf_capacity && l->next_ == nullptr;
+    size_t keep = append ? leaf_capacity : leaf_capacity / 2;
+    try {
+      key_type sep(append ? key_type(key) : l->slots_[keep].first);
+      if (append) {
+        ::new (static_cast<void *>(&r->slots_[0])) std::pair<K, T>(std::piecewise_construct,
+            std::forward_as_tuple(std::forward<KK>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+        r->count_ = 1;
+      } else {
+        for (size_t i = keep; i < leaf_capacity; ++i) {
+          ::new (static_cast<void *>(&r->slots_[i - keep])) std::pair<K, T>(std::move(l->slots_[i]));
+          std::destroy_at(&l->slots_[i]);
+        }
+        r->count_ = static_cast<uint16_t>(leaf_capacity - keep);
+        l->count_ = static_cast<uint16_t>(keep);
+      }
+      r->prev_ = l;
+      r->next_ = l->next_;
+      (l->next_ != nullptr ? l->next_->prev_ : rightmost_) = r;
+      l->next_ = r;
+      insert_child_(p, std::move(sep), r, spare + needed);
+    } catch (...) {
+      free_leaf_(r);
+      while (allocated)
+        free_internal_(spare[--allocated]);
+      throw;
+    }
+    if (append) {
+      ++size_;
+      return iterator(r, 0);
+    }
+    if (idx > keep) {
+      idx -= keep;
+      l = r;
+    }
+  }
+  if (idx == l->count_)
+    ::new (static_cast<void *>(&l->slots_[idx])) std::pair<K, T>(std::piecewise_construct,
+        std::forward_as_tuple(std::forward<KK>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+  else
+    btree_map_details::insert_slot(l->slots_, l->count_, idx, std::piecewise_construct,
+        std::forward_as_tuple(std::forward<KK>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+  ++l->count_;
+  ++size_;
+  return iterator(l, idx);
+}
+
+// Hangs right after the child taken at the bottom of path p, splitting full ancestors
+// with the preallocated nodes below spare (taken top down).
+template <typename K, typename T, typename C, typename A>
+void btree_map<K, T, C, A>::insert_child_(path &p, key_type sep, node_base *right, internal **spare) {
+  for (size_t d = p.depth;; --d) {
+    if (d == 0) {
+      internal *root = *--spare;
+      ::new (static_cast<void *>(&root->keys_[0])) key_type(std::move(sep));
+      root->children_[0] = root_;
+      root->children_[1] = right;
+      root->count_ = 1;
+      root_ = root;
+      return;
+    }
+    auto [in, ci] = p.e[d - 1];
+    if (in->count_ < internal_capacity) {
+      btree_map_details::insert_slot(in->keys_, in->count_, ci, std::move(sep));
+      std::copy_backward(in->children_ + ci + 1, in->children_ + in->count_ + 1, in->children_ + in->count_ + 2);
+      in->children_[ci + 1] = right;
+      ++in->count_;
+      return;
+    }
+    // left keeps keys [0, mid), keys_[mid] moves up, right takes (mid, capacity)
+    constexpr size_t mid = internal_capacity / 2;
+    internal *rn = *--spare;
+    key_type up(std::move(in->keys_[mid]));
+    for (size_t i = mid + 1; i < internal_capacity; ++i)
+      ::new (static_cast<void *>(&rn->keys_[i - mid - 1])) key_type(std::move(in->keys_[i]));
+    std::destroy(in->keys_ + mid, in->keys_ + internal_capacity);
+    std::copy(in->children_ + mid + 1, in->children_ + internal_capacity + 1, rn->children_);
+    in->count_ = mid;
+    rn->count_ = internal_capacity - mid - 1;
+    internal *target = ci <= mid ? in : rn;
+    size_t pos = ci <= mid ? ci : ci - mid - 1;
+    btree_map_details::insert_slot(target->keys_, target->count_, pos, std::move(sep));
+    std::copy_backward(target->children_ + pos + 1, target->children_ + target->count_ + 1, target->children_ + target->count_ + 2);
+    target->children_[pos + 1] = right;
+    ++target->count_;
+    sep = std::move(up);
+    right = rn;
+  }
+}
+
+// Underfull leaves borrow from a sibling with spare entries or merge into one,
+// the successor position is carried through the moves. A borrow copies the new separator
+// first: if that copy throws, the tree is only left with an underfull leaf.
+template <typename K, typename T, typename C, typename A>
+typename btree_map<K, T, C, A>::iterator btree_map<K, T, C, A>::erase_at_(path &p, leaf *l, size_t idx) {
+  btree_map_details::erase_slot(l->slots_, l->count_, idx);
+  --l->count_;
+  --size_;
+  if (p.depth == 0) {
+    if (l->count_ == 0) {
+      free_leaf_(l);
+      root_ = nullptr;
+      leftmost_ = rightmost_ = nullptr;
+      return end();
+    }
+    return make_iter_(l, idx);
+  }
+  if (l->count_ >= min_leaf)
+    return make_iter_(l, idx);
+
+  auto [parent, ci] = p.e[p.depth - 1];
+  leaf *left = ci > 0 ? static_cast<leaf *>(parent->children_[ci - 1]) : nullptr;
+  leaf *right = ci < parent->count_ ? static_cast<leaf *>(parent->children_[ci + 1]) : nullptr;
+  if (left != nullptr && left->count_ > min_leaf) {
+    key_type sep(left->slots_[left->count_ - 1].first);
+    btree_map_details::insert_slot(l->slots_, l->count_, 0, std::move(left->slots_[left->count_ - 1]));
+    std::destroy_at(&left->slots_[--left->count_]);
+    ++l->count_;
+    parent->keys_[ci - 1] = std::move(sep);
+    return make_iter_(l, idx + 1);
+  }
+  if (right != nullptr && right->count_ > min_leaf) {
+    key_type sep(right->slots_[1].first);
+    ::new (static_cast<void *>(&l->slots_[l->count_])) std::pair<K, T>(std::move(right->slots_[0]));
+    ++l->count_;
+    btree_map_details::erase_slot(right->slots_, right->count_, 0);
+    --right->count_;
+    parent->keys_[ci] = std::move(sep);
+    return make_iter_(l, idx);
+  }
+  // merge the right one of (left, l) or (l, right) into the left one
+  leaf *dst = left != nullptr ? left : l;
+  leaf *src = left != nullptr ? l : right;
+  size_t key_idx = left != nullptr ? ci - 1 : ci;
+  size_t base = dst->count_;
+  for (size_t i = 0; i < src->count_; ++i) {
+    ::new (static_cast<void *>(&dst->slots_[base + i])) std::pair<K, T>(std::move(src->slots_[i]));
+    std::destroy_at(&src->slots_[i]);
+  }
+  dst->count_ += src->count_;
+  src->count_ = 0;
+  unlink_leaf_(src);
+  free_leaf_(src);
+  btree_map_details::erase_slot(parent->keys_, parent->count_, key_idx);
+  std::copy(parent->children_ + key_idx + 2, parent->children_ + parent->count_ + 1, parent->children_ + key_idx + 1);
+  --parent->count_;
+  iterator succ = make_iter_(dst, dst == l ? idx : base + idx);
+  rebalance_internal_(p, p.depth - 1);
+  return succ;
+}
+
+template <typename K, typename T, typename C, typename A>
+void btree_map<K, T, C, A>::rebalance_internal_(path &p, size_t d) {
+  for (;; --d) {
+    internal *in = p.e[d].first;
+    if (d == 0) {
+      if (in->count_ == 0) {
+        root_ = in->children_[0];
+        free_internal_(in);
+      }
+      return;
+    }
+    if (in->count_ >= min_internal)
+      return;
+    auto [parent, ci] = p.e[d - 1];
+    internal *left = ci > 0 ? static_cast<internal *>(parent->children_[ci - 1]) : nullptr;
+    internal *right = ci < parent->count_ ? static_cast<internal *>(parent->children_[ci + 1]) : nullptr;
+    if (left != nullptr && left->count_ > min_internal) {
+      // rotate right through the parent separator
+      btree_map_details::insert_slot(in->keys_, in->count_, 0, std::move(parent->keys_[ci - 1]));
+      std::copy_backward(in->children_, in->children_ + in->count_ + 1, in->children_ + in->count_ + 2);
+      in->children_[0] = left->children_[left->count_];
+      ++in->count_;
+      parent->keys_[ci - 1] = std::move(left->keys_[left->count_ - 1]);
+      std::destroy_at(&left->keys_[--left->count_]);
+      return;
+    }
+    if (right != nullptr && right->count_ > min_internal) {
+      // rotate left through the parent separator
+      ::new (static_cast<void *>(&in->keys_[in->count_])) key_type(std::move(parent->keys_[ci]));
+      in->children_[in->count_ + 1] = right->children_[0];
+      ++in->count_;
+      parent->keys_[ci] = std::move(right->keys_[0]);
+      btree_map_details::erase_slot(right->keys_, right->count_, 0);
+      std::copy(right->children_ + 1, right->children_ + right->count_ + 1, right->children_);
+      --right->count_;
+      return;
+    }
+    internal *dst = left != nullptr ? left : in;
+    internal *src = left != nullptr ? in : right;
+    size_t key_idx = left != nullptr ? ci - 1 : ci;
+    size_t base = dst->count_;
+    ::new (static_cast<void *>(&dst->keys_[base])) key_type(std::move(parent->keys_[key_idx]));
+    for (size_t i = 0; i < src->count_; ++i)
+      ::new (static_cast<void *>(&dst->keys_[base + 1 + i])) key_type(std::move(src->keys_[i]));
+    std::copy(src->children_, src->children_ + src->count_ + 1, dst->children_ + base + 1);
+    dst->count_ += src->count_ + 1;
+    std::destroy_n(src->keys_, src->count_);
+    free_internal_(src);
+    btree_map_details::erase_slot(parent->keys_, parent->count_, key_idx);
+    std::copy(parent->children_ + key_idx + 2, parent->children_ + parent->count_ + 1, parent->children_ + key_idx + 1);
+    --parent->count_;
+  }
+}
+
+template <typename K, typename T, typename C, typename A>
+typename btree_map<K, T, C, A>::iterator btree_map<K, T, C, A>::erase(const_iterator first, const_iterator last) {
+  if (first == cbegin() && last == cend()) {
+    clear();
+    return end();
+  }
+  // positions shift while erasing, so count first and erase one by one from the moving front
+  auto n = std::distance(first, last);
+  iterator it(first.leaf_, first.idx_);
+  while (n-- > 0)
+    it = erase(it);
+  return it;
+}
+
+} // namespace cont
@@ -0,0 +1,138 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "alloc/bpool_alloc.hpp"
+#include "btree_map.hpp"
+
+/////////////////////////////////////////////////////////////////////////
+// std::map (std and bpool allocators) vs btree_map with random keys, 1K..10M entries
+using map_key = std::uint64_t;
+using map_value = std::pair<const map_key, map_key>;
+constexpr static size_t map_rb_bpool_n = 1 << 19;    // 31 * N rb-tree nodes hold 10M entries
+constexpr static size_t map_btree_bpool_n = 1 << 16; // leaves hold a dozen entries each
+
+// bpool with the last policy: a monotonic fill is O(1) per node there, first would rescan the
+// occupied prefix on every allocation
+template <class T, size_t N>
+using bpool_alloc_last = alloc::policy_bpool_alloc<T, N, alloc::placement_policy::last>;
+
+using map_std = std::map<map_key, map_key>;
+using map_bpool = std::map<map_key, map_key, std::less<map_key>, bpool_alloc_last<map_value, map_rb_bpool_n>>;
+using btree_std = cont::btree_map<map_key, map_key>;
+using btree_bpool = cont::btree_map<map_key, map_key, std::less<map_key>, bpool_alloc_last<map_value, map_btree_bpool_n>>;
+
+static std::vector<map_key> shuffled_keys(size_t n)
+{
+    std::vector<map_key> keys(n);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(42));
+    return keys;
+}
+
+template <typename Map>
+static void BM_map_insert(benchmark::State& state)
+{
+    auto keys = shuffled_keys(state.range(0));
+    for(auto _: state)
+    {
+        Map m;
+        auto start = std::chrono::steady_clock::now();
+        for (auto k: keys)
+            m.emplace(k, k);
+        state.SetIterationTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        benchmark::DoNotOptimize(m.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Map>
+static void BM_map_find(benchmark::State& state)
+{
+    auto keys = shuffled_keys(state.range(0));
+    Map m;
+    for (auto k: keys)
+        m.emplace(k, k);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(7));
+    for(auto _: state)
+    {
+        map_key sum = 0;
+        for (auto k: keys)
+            sum += m.find(k)->second;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Map>
+static void BM_map_iterate(benchmark::State& state)
+{
+    auto keys = shuffled_keys(state.range(0));
+    Map m;
+    for (auto k: keys)
+        m.emplace(k, k);
+    for(auto _: state)
+    {
+        map_key sum = 0;
+        for (auto const& [k, v]: m)
+            sum += v;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Map>
+static void BM_map_erase(benchmark::State& state)
+{
+    auto keys = shuffled_keys(state.range(0));
+    for(auto _: state)
+    {
+        Map m;
+        for (auto k: keys)
+            m.emplace(k, k);
+        auto start = std::chrono::steady_clock::now();
+        for (auto k: keys)
+            m.erase(k);
+        state.SetIterationTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        benchmark::DoNotOptimize(m.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+#define MAP_BENCHMARKS(Map) \
+    BENCHMARK(BM_map_insert<Map>)->RangeMultiplier(10)->Range(1000, 10000000)->UseManualTime()->Iterations(3); \
+    BENCHMARK(BM_map_find<Map>)->RangeMultiplier(10)->Range(1000, 10000000)->Iterations(3); \
+    BENCHMARK(BM_map_iterate<Map>)->RangeMultiplier(10)->Range(1000, 10000000)->Iterations(3); \
+    BENCHMARK(BM_map_erase<Map>)->RangeMultiplier(10)->Range(1000, 10000000)->UseManualTime()->Iterations(3)
+
+MAP_BENCHMARKS(map_std);
+MAP_BENCHMARKS(map_bpool);
+MAP_BENCHMARKS(btree_std);
+MAP_BENCHMARKS(btree_bpool);
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2, random uint64 keys, items_per_second:
+                    1K        1M      10M
+insert  map_std     8.5M      0.90M   0.33M
+        map_bpool   14.0M     2.24M   0.99M
+        btree_std   11.3M     2.65M   1.39M
+        btree_bpool 11.6M     2.71M   1.35M
+find    map_std     13.1M     0.85M   0.49M
+        map_bpool   18.8M     1.33M   0.61M
+        btree_std   16.3M     2.61M   1.29M
+        btree_bpool 13.7M     2.42M   1.24M
+iterate map_std     89M       7.0M    4.9M
+        map_bpool   130M      7.1M    5.8M
+        btree_std   409M      121M    57M
+        btree_bpool 440M      112M    56M
+erase   map_std     8.0M      1.17M   0.59M
+        map_bpool   11.1M     1.56M   0.60M
+        btree_std   10.3M     2.14M   1.14M
+        btree_bpool 10.3M     2.48M   1.06M
+Past cache sizes btree_map wins 2-3x on point operations and ~10x on iteration; with a dozen
+entries per node the allocator barely matters for it, bpool mostly helps the node-per-key std::map.
+*/
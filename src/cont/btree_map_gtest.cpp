@@ -0,0 +1,137 @@
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "alloc/bpool_alloc.hpp"
+#include "btree_map.hpp"
+
+using namespace cont;
+
+namespace {
+
+template <typename Map, typename Ref>
+void expect_same(const Map &m, const Ref &ref) {
+  ASSERT_EQ(m.size(), ref.size());
+  EXPECT_TRUE(std::equal(m.begin(), m.end(), ref.begin(), ref.end()));
+  EXPECT_TRUE(std::equal(m.rbegin(), m.rend(), ref.rbegin(), ref.rend()));
+}
+
+}
+
+TEST(cont_unit_tests, btree_map_hw3) {
+  btree_map<int, int, std::less<int>, alloc::bpool_alloc<std::pair<const int, int>, 10>> m;
+  for (int i = 0; i < 10; ++i)
+    m[i] = i * i;
+  std::stringstream ss;
+  for (auto const &[key, val] : m)
+    ss << key << ":" << val << " ";
+  EXPECT_EQ(ss.str(), "0:0 1:1 2:4 3:9 4:16 5:25 6:36 7:49 8:64 9:81 ");
+  EXPECT_EQ(m.at(3), 9);
+  EXPECT_THROW(m.at(10), std::out_of_range);
+}
+
+TEST(cont_unit_tests, btree_map_random_vs_std_map) {
+  // deep tree: thousands of keys in a narrow range, so inserts and erases keep splitting and merging
+  btree_map<int, int> m;
+  std::map<int, int> ref;
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<int> key(0, 5000);
+  for (int step = 0; step < 200000; ++step) {
+    int k = key(gen);
+    switch (gen() % 4) {
+      case 0:
+      case 1: {
+        auto [it, inserted] = m.try_emplace(k, step);
+        auto [rit, rinserted] = ref.try_emplace(k, step);
+        ASSERT_EQ(inserted, rinserted);
+        ASSERT_EQ(*it, *rit);
+        break;
+      }
+      case 2:
+        ASSERT_EQ(m.erase(k), ref.erase(k));
+        break;
+      default: {
+        auto it = m.lower_bound(k);
+        auto rit = ref.lower_bound(k);
+        ASSERT_EQ(it == m.end(), rit == ref.end());
+        if (rit != ref.end()) {
+          ASSERT_EQ(*it, *rit);
+          // erase by iterator returns the successor
+          auto next = m.erase(it);
+          auto rnext = ref.erase(rit);
+          ASSERT_EQ(next == m.end(), rnext == ref.end());
+          if (rnext != ref.end()) {
+            ASSERT_EQ(*next, *rnext);
+          }
+        }
+      }
+    }
+    if (step % 10000 == 0)
+      expect_same(m, ref);
+  }
+  expect_same(m, ref);
+  for (int k = -1; k < 5002; k += 3) {
+    EXPECT_EQ(m.contains(k), ref.contains(k));
+    auto ub = m.upper_bound(k);
+    auto rub = ref.upper_bound(k);
+    ASSERT_EQ(ub == m.end(), rub == ref.end());
+    if (rub != ref.end()) {
+      EXPECT_EQ(ub->first, rub->first);
+    }
+  }
+  // drain completely, the tree shrinks back to nothing
+  for (int k = 0; k <= 5000; ++k)
+    m.erase(k);
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(m.begin(), m.end());
+}
+
+TEST(cont_unit_tests, btree_map_strings_copy_move) {
+  btree_map<std::string, std::string> m{{"b", "2"}, {"a", "1"}};
+  std::map<std::string, std::string> ref{{"b", "2"}, {"a", "1"}};
+  for (int i = 0; i < 3000; ++i) {
+    m.insert_or_assign(std::to_string(i * 7 % 3001), std::to_string(i));
+    ref.insert_or_assign(std::to_string(i * 7 % 3001), std::to_string(i));
+  }
+  m.emplace("a", "ignored");
+  expect_same(m, ref);
+
+  auto copy = m;
+  expect_same(copy, ref);
+  auto moved = std::move(copy);
+  expect_same(moved, ref);
+  EXPECT_TRUE(copy.empty());
+  EXPECT_TRUE(moved == m);
+
+  // range erase from the middle
+  auto first = m.find("100");
+  auto last = m.find("200");
+  ASSERT_NE(first, m.end());
+  ASSERT_NE(last, m.end());
+  auto it = m.erase(first, last);
+  ref.erase(ref.find("100"), ref.find("200"));
+  EXPECT_EQ(it->first, "200");
+  expect_same(m, ref);
+  m.erase(m.begin(), m.end());
+  EXPECT_TRUE(m.empty());
+}
+
+TEST(cont_unit_tests, btree_map_bpool_nodes) {
+  using map = btree_map<int, int, std::less<int>, alloc::bpool_alloc<std::pair<const int, int>, 64>>;
+  map m(std::less<int>(), alloc::bpool_alloc<std::pair<const int, int>, 64>(alloc::placement_policy::last));
+  for (int i = 0; i < 10000; ++i)
+    m.emplace(i, -i);
+  // ascending fill keeps leaves full: size / capacity leaves instead of one node per key
+  EXPECT_EQ(m.get_leaf_allocator().used_count(), (10000 + map::leaf_capacity - 1) / map::leaf_capacity);
+  EXPECT_GT(m.get_internal_allocator().used_count(), 0);
+  for (int i = 0; i < 10000; i += 2)
+    m.erase(i);
+  EXPECT_EQ(m.size(), 5000);
+  EXPECT_EQ(m.begin()->first, 1);
+  m.clear();
+  EXPECT_EQ(m.get_leaf_allocator().used_count(), 0);
+  EXPECT_EQ(m.get_internal_allocator().used_count(), 0);
+}
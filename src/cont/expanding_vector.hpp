@@ -0,0 +1,195 @@
+//-----------------------------------------------------------------------------
+//
+// vector that grows in place when the allocator can: on a full buffer it asks
+// try_expand(data, capacity, 2 * capacity) first and only reallocates (and moves
+// the elements) when that fails; new buffers come from allocate_at_least, so
+// whatever the allocator hands out on top becomes capacity
+//
+//----------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <utility>
+
+namespace cont {
+
+template <typename T, typename Allocator = std::allocator<std::remove_cv_t<T>>>
+struct expanding_vector {
+  using value_type = T;
+  using reference = value_type &;
+  using const_reference = value_type const &;
+  using difference_type = ptrdiff_t;
+  using size_type = size_t;
+  using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+  using alloc_traits = std::allocator_traits<allocator_type>;
+  using iterator = value_type *;
+  using const_iterator = value_type const *;
+
+private:
+  T *data_;
+  size_t size_;
+  size_t capacity_;
+  allocator_type alloc_;
+
+  // optional allocator extensions (bpool_alloc), plain allocate / no expansion otherwise
+  std::pair<T *, size_t> allocate_(size_t n) {
+    if constexpr (requires { alloc_.allocate_at_least(n); }) {
+      auto r = alloc_.allocate_at_least(n);
+      return {r.ptr, r.count};
+    } else {
+      return {alloc_traits::allocate(alloc_, n), n};
+    }
+  }
+  bool try_expand_(size_t n) noexcept {
+    if constexpr (requires { alloc_.try_expand(data_, capacity_, n); })
+      return data_ != nullptr && alloc_.try_expand(data_, capacity_, n);
+    else
+      return false;
+  }
+  void free_() {
+    if (data_ != nullptr)
+      alloc_traits::deallocate(alloc_, data_, capacity_);
+  }
+  void grow_(size_t min_capacity);
+
+public:
+  expanding_vector(allocator_type &&a = {}) : data_(nullptr), size_(0), capacity_(0), alloc_(std::forward<allocator_type>(a)) {}
+  expanding_vector(const expanding_vector &other) : expanding_vector() {
+    operator=(other);
+  }
+  expanding_vector(expanding_vector &&other) noexcept
+      : data_(other.data_), size_(other.size_), capacity_(other.capacity_), alloc_(std::move(other.alloc_)) {
+    other.data_ = nullptr;
+    other.size_ = other.capacity_ = 0;
+  }
+  expanding_vector(size_t size) : expanding_vector() {
+    reserve(size);
+    while (size--)
+      emplace_back();
+  }
+  ~expanding_vector() {
+    clear();
+    free_();
+  }
+
+  expanding_vector &operator=(const expanding_vector &other);
+  expanding_vector &operator=(expanding_vector &&other);
+  void swap(expanding_vector &other) noexcept;
+
+  size_t size() const noexcept { return size_; }
+  size_t capacity() const noexcept { return capacity_; }
+  bool empty() const noexcept { return 0 == size_; }
+
+  T *data() noexcept { return data_; }
+  T const *data() const noexcept { return data_; }
+  T &operator[](size_t i) { return data_[i]; }
+  T const &operator[](size_t i) const { return data_[i]; }
+  T &front() { return data_[0]; }
+  T const &front() const { return data_[0]; }
+  T &back() { return data_[size_ - 1]; }
+  T const &back() const { return data_[size_ - 1]; }
+
+  iterator begin() noexcept { return data_; }
+  iterator end() noexcept { return data_ + size_; }
+  const_iterator begin() const noexcept { return data_; }
+  const_iterator end() const noexcept { return data_ + size_; }
+  const_iterator cbegin() const noexcept { return data_; }
+  const_iterator cend() const noexcept { return data_ + size_; }
+
+  void reserve(size_t n) {
+    if (n > capacity_)
+      grow_(n);
+  }
+
+  template <typename... Args> T &emplace_back(Args &&... args) {
+    if (size_ == capacity_) {
+      // construct first: args may refer to an element of the buffer being moved
+      T value(std::forward<Args>(args)...);
+      grow_(size_ + 1);
+      return *std::construct_at(data_ + size_++, std::move(value));
+    }
+    return *std::construct_at(data_ + size_++, std::forward<Args>(args)...);
+  }
+  void push_back(const T &v) { emplace_back(v); }
+  void push_back(T &&v) { emplace_back(std::move(v)); }
+  void pop_back() {
+    assert(size_ > 0);
+    std::destroy_at(data_ + --size_);
+  }
+  void clear() noexcept {
+    std::destroy(data_, data_ + size_);
+    size_ = 0;
+  }
+
+  allocator_type &get_allocator() & { return alloc_; }
+};
+
+template <typename T, typename A, typename TT, typename AA>
+bool operator==(const expanding_vector<T, A> &a, const expanding_vector<TT, AA> &b) {
+  return std::equal(a.begin(), a.end(), b.begin(), b.end());
+}
+
+template <typename T, typename A, typename TT, typename AA>
+bool operator!=(const expanding_vector<T, A> &a, const expanding_vector<TT, AA> &b) {
+  return !(a == b);
+}
+
+template <typename T, typename A>
+expanding_vector<T, A> &expanding_vector<T, A>::operator=(const expanding_vector &other) {
+  if (&other == this)
+    return *this;
+  clear();
+  reserve(other.size());
+  for (const T &v : other)
+    emplace_back(v);
+  return *this;
+}
+
+template <typename T, typename A>
+expanding_vector<T, A> &expanding_vector<T, A>::operator=(expanding_vector &&other) {
+  if (&other == this)
+    return *this;
+  if constexpr (alloc_traits::is_always_equal::value) {
+    clear();
+    swap(other);
+  } else {
+    clear();
+    reserve(other.size());
+    for (T &v : other)
+      emplace_back(std::move(v));
+    other.clear();
+  }
+  return *this;
+}
+
+template <typename T, typename A>
+void expanding_vector<T, A>::swap(expanding_vector &other) noexcept {
+  using std::swap;
+  swap(data_, other.data_);
+  swap(size_, other.size_);
+  swap(capacity_, other.capacity_);
+  if constexpr (alloc_traits::propagate_on_container_swap::value)
+    swap(alloc_, other.alloc_);
+}
+
+template <typename T, typename A>
+void expanding_vector<T, A>::grow_(size_t min_capacity) {
+  static_assert(std::is_nothrow_move_constructible_v<T>, "elements are moved to the new buffer");
+  size_t capacity = std::max(min_capacity, 2 * capacity_);
+  if (try_expand_(capacity)) {
+    capacity_ = capacity;
+    return;
+  }
+  auto [data, count] = allocate_(capacity);
+  std::uninitialized_move(data_, data_ + size_, data);
+  std::destroy(data_, data_ + size_);
+  // the new buffer in place before the old one is freed: a throwing deallocate leaves the vector whole
+  std::swap(data_, data);
+  std::swap(capacity_, count);
+  if (data != nullptr)
+    alloc_traits::deallocate(alloc_, data, count);
+}
+
+} // namespace cont
@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "alloc/bpool_alloc.hpp"
+#include "expanding_vector.hpp"
+
+/////////////////////////////////////////////////////////////////////////
+// push_back growth: how many elements are moved to new buffers on the way to count elements.
+// noise:1 takes a single slot from the same allocator every 64 push_backs, a neighbour in the way of
+// the next in place expansion (std::vector gets the same malloc traffic).
+constexpr static size_t expanding_bpool_n = 1 << 14; // largest segment 16 N: in place up to 2^18 elements
+constexpr static size_t noise_every = 64;
+
+using vector_std = std::vector<int>;
+using expanding_vector_std = cont::expanding_vector<int>;
+template <alloc::placement_policy P>
+using expanding_vector_bpool = cont::expanding_vector<int, alloc::policy_bpool_alloc<int, expanding_bpool_n, P>>;
+
+template <typename Cont>
+static void BM_grow(benchmark::State& state)
+{
+    const size_t count = state.range(0);
+    const bool noise = state.range(1) != 0;
+    size_t moved = 0;
+    for(auto _: state)
+    {
+        Cont c;
+        auto&& a = c.get_allocator();   // a copy for std::vector, fine for std::allocator
+        std::vector<int*> neighbours;
+        neighbours.reserve(count / noise_every + 1);
+        const int* data = nullptr;
+        for (size_t i = 0; i < count; ++i) {
+            c.push_back(static_cast<int>(i));
+            if (c.data() != data) {
+                if (data != nullptr)
+                    moved += i;
+                data = c.data();
+            }
+            if (noise && i % noise_every == 0)
+                neighbours.push_back(a.allocate(1));
+        }
+        benchmark::DoNotOptimize(c.data());
+        for (auto p: neighbours)
+            a.deallocate(p, 1);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.counters["moved"] = double(moved) / double(state.iterations());
+}
+
+static void grow_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"count", "noise"});
+    for (int64_t count: {1 << 10, 1 << 16})
+        for (int64_t noise: {0, 1})
+            b->Args({count, noise});
+}
+BENCHMARK(BM_grow<vector_std>)->Apply(grow_args);
+BENCHMARK(BM_grow<expanding_vector_std>)->Apply(grow_args);
+BENCHMARK(BM_grow<expanding_vector_bpool<alloc::placement_policy::first>>)->Apply(grow_args);
+BENCHMARK(BM_grow<expanding_vector_bpool<alloc::placement_policy::last>>)->Apply(grow_args);
+BENCHMARK(BM_grow<expanding_vector_bpool<alloc::placement_policy::buddy>>)->Apply(grow_args);
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2, moved = elements moved to a new buffer per container.
+Within a segment bpool grows in place (1K: 0 moved, std: 1023), noise forces some moves; past a segment
+it has to move to the next, bigger one (64K: 16K + 32K moved). The bitmap segments pay for the bit by bit
+range scans of try_expand, buddy blocks expand by order and stay at std::vector speed.
+----------------------------------------------------------------------------------------------------------------------------------------------
+Benchmark                                                                                    Time             CPU   Iterations UserCounters...
+----------------------------------------------------------------------------------------------------------------------------------------------
+BM_grow<vector_std>/count:1024/noise:0                                                    1647 ns         1635 ns       388995 items_per_second=626.318M/s moved=1023
+BM_grow<vector_std>/count:1024/noise:1                                                    2276 ns         2257 ns       379041 items_per_second=453.651M/s moved=1023
+BM_grow<vector_std>/count:65536/noise:0                                                 330344 ns       324588 ns         2667 items_per_second=201.905M/s moved=65.535k
+BM_grow<vector_std>/count:65536/noise:1                                                 336439 ns       333158 ns         1951 items_per_second=196.711M/s moved=65.535k
+BM_grow<expanding_vector_std>/count:1024/noise:0                                          1659 ns         1619 ns       517089 items_per_second=632.39M/s moved=1023
+BM_grow<expanding_vector_std>/count:1024/noise:1                                          2600 ns         2565 ns       296959 items_per_second=399.29M/s moved=1023
+BM_grow<expanding_vector_std>/count:65536/noise:0                                       238585 ns       235505 ns         2771 items_per_second=278.278M/s moved=65.535k
+BM_grow<expanding_vector_std>/count:65536/noise:1                                       302338 ns       299160 ns         2987 items_per_second=219.067M/s moved=65.535k
+BM_grow<expanding_vector_bpool<alloc::placement_policy::first>>/count:1024/noise:0       11653 ns        11538 ns        64075 items_per_second=88.754M/s moved=0
+BM_grow<expanding_vector_bpool<alloc::placement_policy::first>>/count:1024/noise:1       13636 ns        13479 ns        51624 items_per_second=75.9716M/s moved=258
+BM_grow<expanding_vector_bpool<alloc::placement_policy::first>>/count:65536/noise:0    1017354 ns      1010008 ns          546 items_per_second=64.8866M/s moved=49.152k
+BM_grow<expanding_vector_bpool<alloc::placement_policy::first>>/count:65536/noise:1    1350375 ns      1342685 ns          567 items_per_second=48.8097M/s moved=41.218k
+BM_grow<expanding_vector_bpool<alloc::placement_policy::last>>/count:1024/noise:0         8476 ns         8420 ns        91144 items_per_second=121.622M/s moved=0
+BM_grow<expanding_vector_bpool<alloc::placement_policy::last>>/count:1024/noise:1        18269 ns        18097 ns        41461 items_per_second=56.5845M/s moved=642
+BM_grow<expanding_vector_bpool<alloc::placement_policy::last>>/count:65536/noise:0      948140 ns       925021 ns          867 items_per_second=70.8481M/s moved=49.152k
+BM_grow<expanding_vector_bpool<alloc::placement_policy::last>>/count:65536/noise:1      782517 ns       773804 ns          815 items_per_second=84.6933M/s moved=43.65k
+BM_grow<expanding_vector_bpool<alloc::placement_policy::buddy>>/count:1024/noise:0        1997 ns         1989 ns       297649 items_per_second=514.903M/s moved=1
+BM_grow<expanding_vector_bpool<alloc::placement_policy::buddy>>/count:1024/noise:1        2283 ns         2273 ns       313934 items_per_second=450.47M/s moved=1
+BM_grow<expanding_vector_bpool<alloc::placement_policy::buddy>>/count:65536/noise:0     300144 ns       298015 ns         3265 items_per_second=219.908M/s moved=49.153k
+BM_grow<expanding_vector_bpool<alloc::placement_policy::buddy>>/count:65536/noise:1     220141 ns       218359 ns         2774 items_per_second=300.13M/s moved=49.153k
+*/
@@ -0,0 +1,56 @@
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "alloc/bpool_alloc.hpp"
+#include "expanding_vector.hpp"
+
+using namespace cont;
+
+TEST(cont_unit_tests, expanding_vector_push) {
+  expanding_vector<std::string> v;
+  std::vector<std::string> ref;
+  for (int i = 0; i < 100; ++i) {
+    v.push_back(std::to_string(i));
+    ref.push_back(std::to_string(i));
+  }
+  v.emplace_back(v[0]);                                 // refers into the buffer it grows from
+  ref.emplace_back(ref[0]);
+  EXPECT_TRUE(std::equal(ref.begin(), ref.end(), v.begin(), v.end()));
+  v.pop_back();
+  EXPECT_EQ(v.size(), 100);
+  EXPECT_EQ(v.back(), "99");
+
+  expanding_vector<std::string> copy(v);
+  EXPECT_EQ(copy, v);
+  expanding_vector<std::string> moved(std::move(copy));
+  EXPECT_EQ(moved, v);
+  EXPECT_TRUE(copy.empty());
+}
+
+TEST(cont_unit_tests, expanding_vector_bpool_in_place) {
+  expanding_vector<int, alloc::bpool_alloc<int, 1024>> v;    // first placement, nothing after the block
+  v.push_back(0);
+  const int *data = v.data();
+  for (int i = 1; i < 1024; ++i)
+    v.push_back(i);
+  EXPECT_EQ(v.data(), data);                            // every doubling was a try_expand
+  EXPECT_EQ(v.capacity(), 1024);
+  EXPECT_EQ(v.get_allocator().used_count(), 1024);
+  v.push_back(1024);                                    // the segment is full: moved to the next one
+  EXPECT_NE(v.data(), data);
+  EXPECT_EQ(v.capacity(), 2048);
+  for (int i = 0; i <= 1024; ++i)
+    EXPECT_EQ(v[i], i);
+
+  // a neighbour in the way: reallocated, allocate_at_least capacity
+  expanding_vector<int, alloc::bpool_alloc<int, 64>> w;
+  w.reserve(3);
+  EXPECT_EQ(w.capacity(), 6);
+  int *neighbour = w.get_allocator().allocate();
+  for (int i = 0; i < 7; ++i)
+    w.push_back(i);
+  EXPECT_EQ(w.capacity(), 24);                          // 12 asked for, the free run of 2 n handed out
+  EXPECT_EQ(w[6], 6);
+  w.get_allocator().deallocate(neighbour);
+}
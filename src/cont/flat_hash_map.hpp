@@ -0,0 +1,539 @@
+//-----------------------------------------------------------------------------
+//
+// open addressing hash map with SwissTable style metadata: one control byte per slot
+// (empty, deleted, or 7 bits of the hash), probed a whole group at a time (16 bytes
+// with SSE2, 8 bytes of SWAR otherwise). Values sit in one flat slot array, so the map
+// makes one allocation per rehash instead of one per element.
+//
+// Storage comes from the rebound Allocator as two arrays (control bytes, slots): any
+// std allocator, std::pmr::polymorphic_allocator or bpool_alloc with segments larger
+// than the table. Any insert may rehash and invalidate iterators, erase does not.
+//
+//----------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace cont {
+namespace flat_hash_map_details {
+
+using ctrl_t = int8_t;
+constexpr ctrl_t ctrl_empty = -128;  // 0b10000000
+constexpr ctrl_t ctrl_deleted = -2;  // 0b11111110
+// full slots keep h2 (the low 7 bits of the hash), so the sign bit tells full from free
+
+inline bool is_full(ctrl_t c) noexcept { return c >= 0; }
+
+// set bits of a group match, Shift converts a bit number into a slot offset
+template <typename Int, int Shift>
+struct bitmask {
+  Int bits_;
+  explicit operator bool() const noexcept { return bits_ != 0; }
+  size_t lowest() const noexcept { return static_cast<size_t>(std::countr_zero(bits_)) >> Shift; }
+  void drop_lowest() noexcept { bits_ &= bits_ - 1; }
+};
+
+#if defined(__SSE2__)
+struct group {
+  constexpr static size_t width = 16;
+  using mask = bitmask<uint32_t, 0>;
+  __m128i ctrl_;
+  explicit group(const ctrl_t *p) noexcept : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))) {}
+  mask match(ctrl_t h2) const noexcept {
+    return {static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)))};
+  }
+  mask match_empty() const noexcept { return match(ctrl_empty); }
+  mask match_free() const noexcept { return {static_cast<uint32_t>(_mm_movemask_epi8(ctrl_))}; }
+  mask match_full() const noexcept { return {~static_cast<uint32_t>(_mm_movemask_epi8(ctrl_)) & 0xffffu}; }
+};
+#else
+struct group {
+  constexpr static size_t width = 8;
+  using mask = bitmask<uint64_t, 3>;
+  constexpr static uint64_t lsbs = 0x0101010101010101ull;
+  constexpr static uint64_t msbs = 0x8080808080808080ull;
+  uint64_t ctrl_;
+  explicit group(const ctrl_t *p) noexcept { std::memcpy(&ctrl_, p, sizeof(ctrl_)); }
+  // may report a false positive next to a real match, callers compare keys anyway
+  mask match(ctrl_t h2) const noexcept {
+    uint64_t x = ctrl_ ^ (lsbs * static_cast<uint8_t>(h2));
+    return {(x - lsbs) & ~x & msbs};
+  }
+  // empty is the only free value with bit 1 clear
+  mask match_empty() const noexcept { return {ctrl_ & ~(ctrl_ << 6) & msbs}; }
+  mask match_free() const noexcept { return {ctrl_ & msbs}; }
+  mask match_full() const noexcept { return {~ctrl_ & msbs}; }
+};
+#endif
+
+// std::hash of integers is the identity, spread the bits before splitting into h1/h2
+inline size_t mix(size_t h) noexcept {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  return h;
+}
+
+template <typename K, typename V, bool Const>
+struct iterator {
+  using value_type = std::pair<const K, V>;
+  using reference = std::conditional_t<Const, value_type const &, value_type &>;
+  using pointer = std::conditional_t<Const, value_type const *, value_type *>;
+  using difference_type = ptrdiff_t;
+  using iterator_category = std::forward_iterator_tag;
+  using slot_type = std::pair<K, V>;
+
+  reference operator*() const { return *operator->(); }
+  pointer operator->() const { return std::launder(reinterpret_cast<value_type *>(slot_)); }
+
+  iterator &operator++() {
+    ++ctrl_;
+    ++slot_;
+    skip_free_();
+    return *this;
+  }
+  iterator operator++(int) {
+    iterator tmp(*this);
+    ++*this;
+    return tmp;
+  }
+
+  bool operator==(const iterator &other) const { return ctrl_ == other.ctrl_; }
+  bool operator!=(const iterator &other) const { return !operator==(other); }
+
+  iterator() = default;
+  iterator(const ctrl_t *ctrl, slot_type *slot, const ctrl_t *ctrl_end) : ctrl_(ctrl), slot_(slot), ctrl_end_(ctrl_end) {}
+  template <bool C = Const>
+    requires C
+  iterator(const iterator<K, V, false> &other) : ctrl_(other.ctrl_), slot_(other.slot_), ctrl_end_(other.ctrl_end_) {}
+
+  void skip_free_() {
+    // the table size is a multiple of the group width: whole groups can be skipped
+    while (ctrl_ != ctrl_end_) {
+      if ((ctrl_end_ - ctrl_) % group::width == 0) {
+        if (auto full = group(ctrl_).match_full()) {
+          size_t i = full.lowest();
+          ctrl_ += i;
+          slot_ += i;
+          return;
+        }
+        ctrl_ += group::width;
+        slot_ += group::width;
+      } else if (is_full(*ctrl_)) {
+        return;
+      } else {
+        ++ctrl_;
+        ++slot_;
+      }
+    }
+  }
+
+  const ctrl_t *ctrl_ = nullptr;
+  slot_type *slot_ = nullptr;
+  const ctrl_t *ctrl_end_ = nullptr;
+};
+
+} // namespace flat_hash_map_details
+
+template <typename Key, typename T,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+struct flat_hash_map {
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using reference = value_type &;
+  using const_reference = value_type const &;
+  using difference_type = ptrdiff_t;
+  using size_type = size_t;
+  using allocator_type = Allocator;
+  using alloc_traits = std::allocator_traits<allocator_type>;
+  using iterator = flat_hash_map_details::iterator<Key, T, false>;
+  using const_iterator = flat_hash_map_details::iterator<Key, T, true>;
+
+  static_assert(std::is_nothrow_move_constructible_v<Key> && std::is_nothrow_move_constructible_v<T>,
+                "flat_hash_map moves entries on rehash, Key and T must be nothrow movable");
+
+private:
+  using ctrl_t = flat_hash_map_details::ctrl_t;
+  using group = flat_hash_map_details::group;
+  // stored mutable (same layout as value_type), exposed as pair<const K, V> by the iterators
+  using slot_type = std::pair<Key, T>;
+  using slot_allocator_type = typename alloc_traits::template rebind_alloc<slot_type>;
+  using ctrl_allocator_type = typename alloc_traits::template rebind_alloc<ctrl_t>;
+  using slot_alloc_traits = std::allocator_traits<slot_allocator_type>;
+  using ctrl_alloc_traits = std::allocator_traits<ctrl_allocator_type>;
+
+  constexpr static size_t min_capacity = 16; // power of two, multiple of any group width
+  // probe visitor results besides a slot index
+  constexpr static size_t probe_next = static_cast<size_t>(-1);
+  constexpr static size_t not_found = probe_next - 1;
+
+  ctrl_t *ctrl_;
+  slot_type *slots_;
+  size_t capacity_;    // 0 or a power of two
+  size_t size_;
+  size_t growth_left_; // empty slots that may still be filled before a rehash (load factor 7/8)
+  [[no_unique_address]] Hash hash_;
+  [[no_unique_address]] KeyEqual eq_;
+  slot_allocator_type slot_alloc_;
+  ctrl_allocator_type ctrl_alloc_;
+
+  static size_t max_load_(size_t capacity) noexcept { return capacity - capacity / 8; }
+  static size_t h1_(size_t h) noexcept { return h >> 7; }
+  static ctrl_t h2_(size_t h) noexcept { return static_cast<ctrl_t>(h & 0x7f); }
+  size_t hash_of_(const Key &key) const { return flat_hash_map_details::mix(hash_(key)); }
+
+  // groups are probed at aligned offsets, quadratically: every group is visited once per cycle
+  template <typename F>
+  size_t probe_(size_t h, F &&visit) const {
+    size_t mask = capacity_ - 1;
+    size_t pos = h1_(h) & mask & ~(group::width - 1);
+    for (size_t step = group::width;; step += group::width) {
+      if (size_t found = visit(pos, group(ctrl_ + pos)); found != probe_next)
+        return found;
+      pos = (pos + step) & mask;
+    }
+  }
+  size_t find_index_(const Key &key, size_t h) const {
+    if (capacity_ == 0)
+      return not_found;
+    return probe_(h, [&](size_t pos, group g) {
+      for (auto m = g.match(h2_(h)); m; m.drop_lowest())
+        if (size_t i = pos + m.lowest(); eq_(slots_[i].first, key))
+          return i;
+      // an empty slot ends the chain: the key would have been placed there
+      return g.match_empty() ? not_found : probe_next;
+    });
+  }
+  // first empty or deleted slot of the probe sequence of h
+  size_t find_free_(size_t h) const {
+    return probe_(h, [](size_t pos, group g) {
+      auto m = g.match_free();
+      return m ? pos + m.lowest() : probe_next;
+    });
+  }
+
+  void rehash_(size_t new_capacity);
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace_(K &&key, Args &&...args);
+  void erase_at_(size_t i) noexcept;
+  void free_storage_();
+
+  iterator iter_at_(size_t i) noexcept { return iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_); }
+
+public:
+  flat_hash_map() : flat_hash_map(0) {}
+  explicit flat_hash_map(size_t bucket_count, const Hash &hash = Hash(), const KeyEqual &eq = KeyEqual(),
+                         const Allocator &a = Allocator())
+      : ctrl_(nullptr), slots_(nullptr), capacity_(0), size_(0), growth_left_(0), hash_(hash), eq_(eq),
+        slot_alloc_(a), ctrl_alloc_(a) {
+    if (bucket_count != 0)
+      reserve(bucket_count);
+  }
+  explicit flat_hash_map(const Allocator &a) : flat_hash_map(0, Hash(), KeyEqual(), a) {}
+  template <std::input_iterator It>
+  flat_hash_map(It first, It last) : flat_hash_map() {
+    insert(first, last);
+  }
+  flat_hash_map(std::initializer_list<value_type> il) : flat_hash_map() { insert(il); }
+  flat_hash_map(const flat_hash_map &other) : flat_hash_map(other.size_, other.hash_, other.eq_) {
+    for (const value_type &v : other)
+      try_emplace_(v.first, v.second);
+  }
+  flat_hash_map(flat_hash_map &&other) noexcept
+      : ctrl_(other.ctrl_), slots_(other.slots_), capacity_(other.capacity_), size_(other.size_),
+        growth_left_(other.growth_left_), hash_(std::move(other.hash_)), eq_(std::move(other.eq_)),
+        slot_alloc_(std::move(other.slot_alloc_)), ctrl_alloc_(std::move(other.ctrl_alloc_)) {
+    other.ctrl_ = nullptr;
+    other.slots_ = nullptr;
+    other.capacity_ = other.size_ = other.growth_left_ = 0;
+  }
+  ~flat_hash_map() {
+    clear();
+    free_storage_();
+  }
+
+  flat_hash_map &operator=(const flat_hash_map &other);
+  flat_hash_map &operator=(flat_hash_map &&other);
+  void swap(flat_hash_map &other) noexcept;
+
+  size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return 0 == size_; }
+  size_t capacity() const noexcept { return capacity_; }
+  float load_factor() const noexcept { return capacity_ ? static_cast<float>(size_) / capacity_ : 0.0f; }
+  hasher hash_function() const { return hash_; }
+  key_equal key_eq() const { return eq_; }
+
+  iterator begin() noexcept {
+    iterator it = iter_at_(0);
+    it.skip_free_();
+    return it;
+  }
+  iterator end() noexcept { return iter_at_(capacity_); }
+  const_iterator begin() const noexcept { return const_cast<flat_hash_map *>(this)->begin(); }
+  const_iterator end() const noexcept { return const_cast<flat_hash_map *>(this)->end(); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+  // lookup
+  iterator find(const Key &key) {
+    size_t i = find_index_(key, hash_of_(key));
+    return i < capacity_ ? iter_at_(i) : end();
+  }
+  const_iterator find(const Key &key) const { return const_cast<flat_hash_map *>(this)->find(key); }
+  bool contains(const Key &key) const { return find_index_(key, hash_of_(key)) < capacity_; }
+  size_t count(const Key &key) const { return contains(key) ? 1 : 0; }
+  T &at(const Key &key) {
+    iterator it = find(key);
+    if (it == end())
+      throw std::out_of_range("flat_hash_map::at");
+    return it->second;
+  }
+  T const &at(const Key &key) const { return const_cast<flat_hash_map *>(this)->at(key); }
+  T &operator[](const Key &key) { return try_emplace_(key).first->second; }
+  T &operator[](Key &&key) { return try_emplace_(std::move(key)).first->second; }
+
+  // insert
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const Key &key, Args &&...args) {
+    return try_emplace_(key, std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(Key &&key, Args &&...args) {
+    return try_emplace_(std::move(key), std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&...args) {
+    slot_type v(std::forward<Args>(args)...);
+    return try_emplace_(std::move(v.first), std::move(v.second));
+  }
+  std::pair<iterator, bool> insert(const value_type &v) { return try_emplace_(v.first, v.second); }
+  template <typename P>
+    requires std::is_constructible_v<value_type, P &&>
+  std::pair<iterator, bool> insert(P &&v) {
+    return emplace(std::forward<P>(v));
+  }
+  template <std::input_iterator It>
+  void insert(It first, It last) {
+    for (; first != last; ++first)
+      emplace(*first);
+  }
+  void insert(std::initializer_list<value_type> il) { insert(il.begin(), il.end()); }
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const Key &key, M &&obj) {
+    auto res = try_emplace_(key, std::forward<M>(obj));
+    if (!res.second)
+      res.first->second = std::forward<M>(obj);
+    return res;
+  }
+
+  // erase: never moves other entries, iterators stay valid
+  size_t erase(const Key &key) {
+    size_t i = find_index_(key, hash_of_(key));
+    if (i >= capacity_)
+      return 0;
+    erase_at_(i);
+    return 1;
+  }
+  iterator erase(const_iterator it) {
+    size_t i = static_cast<size_t>(it.ctrl_ - ctrl_);
+    erase_at_(i);
+    iterator next = iter_at_(i);
+    next.skip_free_();
+    return next;
+  }
+  iterator erase(iterator it) { return erase(const_iterator(it)); }
+
+  void clear();
+  // room for count elements without a rehash
+  void reserve(size_t count) {
+    size_t cap = min_capacity;
+    while (max_load_(cap) < count)
+      cap *= 2;
+    if (cap > capacity_)
+      rehash_(cap);
+  }
+
+  slot_allocator_type &get_slot_allocator() & { return slot_alloc_; }
+  ctrl_allocator_type &get_ctrl_allocator() & { return ctrl_alloc_; }
+};
+
+template <typename K, typename T, typename H, typename E, typename A>
+bool operator==(const flat_hash_map<K, T, H, E, A> &a, const flat_hash_map<K, T, H, E, A> &b) {
+  if (a.size() != b.size())
+    return false;
+  for (const auto &[key, val] : a)
+    if (auto it = b.find(key); it == b.end() || !(it->second == val))
+      return false;
+  return true;
+}
+
+template <typename K, typename T, typename H, typename E, typename A>
+bool operator!=(const flat_hash_map<K, T, H, E, A> &a, const flat_hash_map<K, T, H, E, A> &b) {
+  return !(a == b);
+}
+
+template <typename K, typename T, typename H, typename E, typename A>
+flat_hash_map<K, T, H, E, A> &flat_hash_map<K, T, H, E, A>::operator=(const flat_hash_map &other) {
+  if (&other == this)
+    return *this;
+  clear();
+  hash_ = other.hash_;
+  eq_ = other.eq_;
+  reserve(other.size_);
+  for (const value_type &v : other)
+    try_emplace_(v.first, v.second);
+  return *this;
+}
+
+template <typename K, typename T, typename H, typename E, typename A>
+flat_hash_map<K, T, H, E, A> &flat_hash_map<K, T, H, E, A>::operator=(flat_hash_map &&other) {
+  if (&other == this)
+    return *this;
+  if constexpr (slot_alloc_traits::is_always_equal::value && ctrl_alloc_traits::is_always_equal::value) {
+    clear();
+    swap(other);
+  } else {
+    clear();
+    hash_ = other.hash_;
+    eq_ = other.eq_;
+    reserve(other.size_);
+    for (value_type &v : other)
+      try_emplace_(v.first, std::move(v.second));
+    other.clear();
+  }
+  return *this;
+}
+
+template <typename K, typename T, typename H, typename E, typename A>
+void flat_hash_map<K, T, H, E, A>::swap(flat_hash_map &other) noexcept {
+  using std::swap;
+  swap(ctrl_, other.ctrl_);
+  swap(slots_, other.slots_);
+  swap(capacity_, other.capacity_);
+  swap(size_, other.size_);
+  swap(growth_left_, other.growth_left_);
+  swap(hash_, other.hash_);
+  swap(eq_, other.eq_);
+  if constexpr (slot_alloc_traits::propagate_on_container_swap::value) {
+    swap(slot_alloc_, other.slot_alloc_);
+    swap(ctrl_alloc_, other.ctrl_alloc_);
+  }
+}
+
+template <typename K, typename T, typename H, typename E, typename A>
+void flat_hash_map<K, T, H, E, A>::free_storage_() {
+  if (capacity_ == 0)
+    return;
+  // the map is empty before the arrays go back: a throwing deallocate leaves nothing to free twice
+  ctrl_t *ctrl = std::exchange(ctrl_, nullptr);
+  slot_type *slots = std::exchange(slots_, nullptr);
+  size_t capacity = std::exchange(capacity_, 0);
+  growth_left_ = 0;
+  slot_alloc_traits::deallocate(slot_alloc_, slots, capacity);
+  ctrl_alloc_traits::deallocate(ctrl_alloc_, ctrl, capacity);
+}
+
+template <typename K, typename T, typename H, typename E, typename A>
+void flat_hash_map<K, T, H, E, A>::clear() {
+  for (size_t i = 0; i < capacity_; ++i)
+    if (flat_hash_map_details::is_full(ctrl_[i]))
+      std::destroy_at(&slots_[i]);
+  if (capacity_ != 0)
+    std::memset(ctrl_, flat_hash_map_details::ctrl_empty, capacity_);
+  size_ = 0;
+  growth_left_ = max_load_(capacity_);
+}
+
+// moves every entry into fresh arrays, which also drops all tombstones
+template <typename K, typename T, typename H, typename E, typename A>
+void flat_hash_map<K, T, H, E, A>::rehash_(size_t new_capacity) {
+  ctrl_t *new_ctrl = ctrl_alloc_traits::allocate(ctrl_alloc_, new_capacity);
+  slot_type *new_slots;
+  try {
+    new_slots = slot_alloc_traits::allocate(slot_alloc_, new_capacity);
+  } catch (...) {
+    ctrl_alloc_traits::deallocate(ctrl_alloc_, new_ctrl, new_capacity);
+    throw;
+  }
+  std::memset(new_ctrl, flat_hash_map_details::ctrl_empty, new_capacity);
+
+  ctrl_t *old_ctrl = ctrl_;
+  slot_type *old_slots = slots_;
+  size_t old_capacity = capacity_;
+  ctrl_ = new_ctrl;
+  slots_ = new_slots;
+  capacity_ = new_capacity;
+  for (size_t i = 0; i < old_capacity; ++i)
+    if (flat_hash_map_details::is_full(old_ctrl[i])) {
+      size_t h = hash_of_(old_slots[i].first);
+      size_t j = find_free_(h);
+      new_ctrl[j] = h2_(h);
+      ::new (static_cast<void *>(&slots_[j])) slot_type(std::move(old_slots[i]));
+      std::destroy_at(&old_slots[i]);
+    }
+  growth_left_ = max_load_(capacity_) - size_;
+  if (old_capacity != 0) {
+    slot_alloc_traits::deallocate(slot_alloc_, old_slots, old_capacity);
+    ctrl_alloc_traits::deallocate(ctrl_alloc_, old_ctrl, old_capacity);
+  }
+}
+
+template <typename K, typename T, typename H, typename E, typename A>
+template <typename KK, typename... Args>
+std::pair<typename flat_hash_map<K, T, H, E, A>::iterator, bool> flat_hash_map<K, T, H, E, A>::try_emplace_(KK &&key, Args &&...args) {
+  size_t h = hash_of_(key);
+  if (size_t i = find_index_(key, h); i < capacity_)
+    return {iter_at_(i), false};
+  if (capacity_ == 0)
+    rehash_(min_capacity);
+  size_t i = find_free_(h);
+  if (growth_left_ == 0 && ctrl_[i] == flat_hash_map_details::ctrl_empty) {
+    // mostly tombstones: rehash in place, otherwise grow
+    rehash_(size_ + 1 > max_load_(capacity_) / 2 ? capacity_ * 2 : capacity_);
+    i = find_free_(h);
+  }
+  ::new (static_cast<void *>(&slots_[i])) slot_type(std::piecewise_construct,
+      std::forward_as_tuple(std::forward<KK>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+  if (ctrl_[i] == flat_hash_map_details::ctrl_empty)
+    --growth_left_;
+  ctrl_[i] = h2_(h);
+  ++size_;
+  return {iter_at_(i), true};
+}
+
+// A slot whose (aligned) group still has an empty byte can become empty again: probes stop
+// at that group anyway. Otherwise it becomes a tombstone so probes keep going past it.
+template <typename K, typename T, typename H, typename E, typename A>
+void flat_hash_map<K, T, H, E, A>::erase_at_(size_t i) noexcept {
+  std::destroy_at(&slots_[i]);
+  --size_;
+  if (group(ctrl_ + (i & ~(group::width - 1))).match_empty()) {
+    ctrl_[i] = flat_hash_map_details::ctrl_empty;
+    ++growth_left_;
+  } else {
+    ctrl_[i] = flat_hash_map_details::ctrl_deleted;
+  }
+}
+
+} // namespace cont
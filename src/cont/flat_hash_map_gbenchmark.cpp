@@ -0,0 +1,149 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "alloc/bpool_alloc.hpp"
+#include "flat_hash_map.hpp"
+
+/////////////////////////////////////////////////////////////////////////
+// std::unordered_map (std and bpool allocators) vs flat_hash_map (std and pmr allocators):
+// insert, lookup hit, lookup miss and erase of random keys, 1K..1M entries
+using hash_key = std::uint64_t;
+using hash_value = std::pair<const hash_key, hash_key>;
+constexpr static size_t hash_bpool_n = 1 << 20; // one segment holds the 1M nodes
+
+using umap_std = std::unordered_map<hash_key, hash_key>;
+// libstdc++ allocates the bucket array through a temporary copy of the node allocator rebound to
+// pointers; a rebound bpool_alloc owns fresh pools, so the buckets would die with that temporary.
+// Nodes come from bpool, bucket arrays (arrays of node pointers) from std::allocator.
+template <class T>
+struct umap_node_alloc : alloc::policy_bpool_alloc<T, hash_bpool_n, alloc::placement_policy::last> {
+    umap_node_alloc() noexcept = default;
+    template <class U>
+    umap_node_alloc(umap_node_alloc<U> const&) noexcept {}
+    template <class U>
+    operator std::allocator<U>() const noexcept { return {}; }
+
+    template <class Up> struct rebind {
+        using other = std::conditional_t<std::is_pointer_v<Up>, std::allocator<Up>, umap_node_alloc<Up>>;
+    };
+};
+
+using umap_bpool = std::unordered_map<hash_key, hash_key, std::hash<hash_key>, std::equal_to<hash_key>,
+    umap_node_alloc<hash_value>>;
+using flat_std = cont::flat_hash_map<hash_key, hash_key>;
+using flat_pmr = cont::flat_hash_map<hash_key, hash_key, std::hash<hash_key>, std::equal_to<hash_key>,
+    std::pmr::polymorphic_allocator<hash_value>>;
+
+// pmr maps draw from a pool resource owned by the benchmark
+template <typename Map>
+struct map_holder {
+    Map m;
+};
+template <>
+struct map_holder<flat_pmr> {
+    std::pmr::unsynchronized_pool_resource pool;
+    flat_pmr m{&pool};
+};
+
+static std::vector<hash_key> random_keys(size_t n, size_t seed)
+{
+    std::vector<hash_key> keys(n);
+    std::mt19937_64 gen(seed);
+    for (auto& k: keys)
+        k = gen();
+    return keys;
+}
+
+template <typename Map>
+static void BM_hash_insert(benchmark::State& state)
+{
+    auto keys = random_keys(state.range(0), 1);
+    for(auto _: state)
+    {
+        map_holder<Map> h;
+        auto start = std::chrono::steady_clock::now();
+        for (auto k: keys)
+            h.m.emplace(k, k);
+        state.SetIterationTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        benchmark::DoNotOptimize(h.m.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// hit looks up inserted keys, miss keys from another random stream
+template <typename Map, bool Hit>
+static void BM_hash_find(benchmark::State& state)
+{
+    auto keys = random_keys(state.range(0), 1);
+    map_holder<Map> h;
+    for (auto k: keys)
+        h.m.emplace(k, k);
+    if (!Hit)
+        keys = random_keys(state.range(0), 2);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(3));
+    for(auto _: state)
+    {
+        size_t found = 0;
+        for (auto k: keys)
+            found += h.m.find(k) != h.m.end();
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Map>
+static void BM_hash_erase(benchmark::State& state)
+{
+    auto keys = random_keys(state.range(0), 1);
+    for(auto _: state)
+    {
+        map_holder<Map> h;
+        for (auto k: keys)
+            h.m.emplace(k, k);
+        auto start = std::chrono::steady_clock::now();
+        for (auto k: keys)
+            h.m.erase(k);
+        state.SetIterationTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        benchmark::DoNotOptimize(h.m.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+#define HASH_BENCHMARKS(Map) \
+    BENCHMARK(BM_hash_insert<Map>)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)->UseManualTime()->Iterations(5); \
+    BENCHMARK(BM_hash_find<Map, true>)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)->Iterations(5); \
+    BENCHMARK(BM_hash_find<Map, false>)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)->Iterations(5); \
+    BENCHMARK(BM_hash_erase<Map>)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)->UseManualTime()->Iterations(5)
+
+HASH_BENCHMARKS(umap_std);
+HASH_BENCHMARKS(umap_bpool);
+HASH_BENCHMARKS(flat_std);
+HASH_BENCHMARKS(flat_pmr);
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2, SSE2 groups, random uint64 keys, items_per_second:
+                   1K       32K      1M
+insert umap_std    17.6M    14.8M    4.6M
+       umap_bpool  12.6M    15.3M    5.4M
+       flat_std    32.6M    18.9M    13.9M
+       flat_pmr    19.9M    26.0M    12.0M
+hit    umap_std    118M     64M      24M
+       umap_bpool  107M     64M      28M
+       flat_std    262M     185M     51M
+       flat_pmr    172M     104M     35M
+miss   umap_std    85M      43M      23M
+       umap_bpool  88M      45M      23M
+       flat_std    297M     253M     104M
+       flat_pmr    190M     162M     63M
+erase  umap_std    45M      33M      6.7M
+       umap_bpool  43M      39M      8.8M
+       flat_std    233M     173M     32M
+       flat_pmr    139M     88M      23M
+Pooling nodes gains unordered_map 10-30% at 1M; dropping nodes altogether gains 2-5x,
+misses are cheapest: one control byte group usually ends the probe.
+*/
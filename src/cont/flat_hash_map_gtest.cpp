@@ -0,0 +1,116 @@
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <gtest/gtest.h>
+
+#include "alloc/bpool_alloc.hpp"
+#include "flat_hash_map.hpp"
+
+using namespace cont;
+
+namespace {
+
+template <typename Map, typename Ref>
+void expect_same(const Map &m, const Ref &ref) {
+  ASSERT_EQ(m.size(), ref.size());
+  size_t visited = 0;
+  for (auto const &[key, val] : m) {
+    auto it = ref.find(key);
+    ASSERT_NE(it, ref.end());
+    EXPECT_EQ(it->second, val);
+    ++visited;
+  }
+  EXPECT_EQ(visited, ref.size());
+}
+
+}
+
+TEST(cont_unit_tests, flat_hash_map_basic) {
+  flat_hash_map<std::string, int> m{{"one", 1}, {"two", 2}};
+  EXPECT_EQ(m.size(), 2);
+  EXPECT_EQ(m.at("one"), 1);
+  EXPECT_THROW(m.at("three"), std::out_of_range);
+  m["three"] = 3;
+  EXPECT_FALSE(m.emplace("one", 10).second);
+  EXPECT_EQ(m.insert_or_assign("one", 11).first->second, 11);
+  EXPECT_TRUE(m.contains("three"));
+  EXPECT_EQ(m.erase("two"), 1);
+  EXPECT_EQ(m.erase("two"), 0);
+  EXPECT_EQ(m.count("two"), 0);
+  EXPECT_EQ(m.find("two"), m.end());
+
+  auto copy = m;
+  EXPECT_TRUE(copy == m);
+  auto moved = std::move(copy);
+  EXPECT_TRUE(moved == m);
+  EXPECT_TRUE(copy.empty());
+  m.clear();
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(m.begin(), m.end());
+}
+
+TEST(cont_unit_tests, flat_hash_map_random_vs_unordered_map) {
+  flat_hash_map<int, int> m;
+  std::unordered_map<int, int> ref;
+  std::mt19937 gen(11);
+  std::uniform_int_distribution<int> key(0, 20000);
+  for (int step = 0; step < 300000; ++step) {
+    int k = key(gen);
+    if (gen() % 3 != 0) {
+      auto [it, inserted] = m.try_emplace(k, step);
+      ASSERT_EQ(inserted, ref.try_emplace(k, step).second);
+      ASSERT_EQ(it->first, k);
+    } else {
+      ASSERT_EQ(m.erase(k), ref.erase(k));
+    }
+    if (step % 50000 == 0)
+      expect_same(m, ref);
+  }
+  expect_same(m, ref);
+  for (int k = 20001; k < 21000; ++k)
+    EXPECT_FALSE(m.contains(k));
+
+  // erase while iterating: the returned iterator continues the walk
+  for (auto it = m.begin(); it != m.end();)
+    it = (it->first % 2) ? m.erase(it) : std::next(it);
+  std::erase_if(ref, [](auto const &kv) { return kv.first % 2; });
+  expect_same(m, ref);
+}
+
+TEST(cont_unit_tests, flat_hash_map_tombstones) {
+  // insert/erase churn with a small live set: tombstones get recycled, the table stops growing
+  flat_hash_map<int, int> m;
+  for (int i = 0; i < 100; ++i)
+    m.emplace(i, i);
+  size_t capacity = 0;
+  for (int i = 100; i < 100000; ++i) {
+    m.erase(i - 100);
+    m.emplace(i, i);
+    if (i == 10000)
+      capacity = m.capacity();
+  }
+  EXPECT_EQ(m.size(), 100);
+  EXPECT_EQ(m.capacity(), capacity);
+  EXPECT_LE(capacity, 256);
+  for (int i = 99900; i < 100000; ++i)
+    EXPECT_EQ(m.at(i), i);
+}
+
+TEST(cont_unit_tests, flat_hash_map_allocators) {
+  using value = std::pair<const int, int>;
+  flat_hash_map<int, int, std::hash<int>, std::equal_to<int>, alloc::bpool_alloc<value, 1024>> mb;
+  for (int i = 0; i < 500; ++i)
+    mb[i] = -i;
+  EXPECT_EQ(mb.at(499), -499);
+  // only the live table arrays are held: control bytes and slots
+  EXPECT_EQ(mb.get_slot_allocator().used_count(), mb.capacity());
+  EXPECT_EQ(mb.get_ctrl_allocator().used_count(), mb.capacity());
+
+  std::pmr::monotonic_buffer_resource arena;
+  flat_hash_map<int, int, std::hash<int>, std::equal_to<int>, std::pmr::polymorphic_allocator<value>> mp(&arena);
+  for (int i = 0; i < 500; ++i)
+    mp[i] = i;
+  EXPECT_EQ(mp.size(), 500);
+  EXPECT_EQ(mp.at(250), 250);
+}
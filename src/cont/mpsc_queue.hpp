@@ -0,0 +1,143 @@
+//-----------------------------------------------------------------------------
+//
+// multi-producer single-consumer queue (D. Vyukov's non-intrusive MPSC node queue):
+// push is one atomic exchange plus one release store, try_pop touches no shared atomics
+// except the next_ link it reads. Only the consumer frees nodes, so no hazard pointers
+// or epochs are needed: a node is never freed while a producer can still reach it.
+//
+// Nodes come from the rebound Allocator, which must tolerate allocate() from many
+// threads and deallocate() from the consumer at the same time: std::allocator or
+// alloc::sync_alloc<alloc::bpool_alloc<...>>.
+//
+//----------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+namespace cont {
+namespace mpsc_queue_details {
+
+template <typename Tp>
+struct node {
+  std::atomic<node *> next_;
+  union {
+    Tp value_;
+  };
+  node() : next_(nullptr) {}
+  ~node() {}
+};
+
+// keeps producers (head_) and the consumer (tail_) from false sharing
+constexpr size_t cache_line = 64;
+
+} // namespace mpsc_queue_details
+
+template <typename T, typename Allocator = std::allocator<T>>
+struct mpsc_queue {
+  using value_type = T;
+  using size_type = size_t;
+  using allocator_type = Allocator;
+  using alloc_traits = std::allocator_traits<allocator_type>;
+
+private:
+  using node = mpsc_queue_details::node<T>;
+  using node_allocator_type = typename alloc_traits::template rebind_alloc<node>;
+  using node_alloc_traits = std::allocator_traits<node_allocator_type>;
+
+  // producers swap themselves in here, points to the last pushed node
+  alignas(mpsc_queue_details::cache_line) std::atomic<node *> head_;
+  // consumer side: a stub whose value was already taken (or never existed), its next_ is the front
+  alignas(mpsc_queue_details::cache_line) node *tail_;
+  node_allocator_type node_alloc_;
+
+  node *make_node_() {
+    node *n = node_alloc_traits::allocate(node_alloc_, 1);
+    ::new (static_cast<void *>(n)) node();
+    return n;
+  }
+  void free_node_(node *n) {
+    n->~node();
+    node_alloc_traits::deallocate(node_alloc_, n, 1);
+  }
+
+public:
+  mpsc_queue(node_allocator_type&& a = {}) : node_alloc_(std::forward<node_allocator_type>(a)) {
+    node *stub = make_node_();
+    head_.store(stub, std::memory_order_relaxed);
+    tail_ = stub;
+  }
+  mpsc_queue(const mpsc_queue &) = delete;
+  mpsc_queue &operator=(const mpsc_queue &) = delete;
+
+  // no concurrent users may be left: undelivered values are destroyed, nodes returned
+  ~mpsc_queue() {
+    while (try_pop_discard_())
+      ;
+    free_node_(tail_);
+  }
+
+  // wait-free apart from the allocator
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    node *n = make_node_();
+    try {
+      ::new (static_cast<void *>(std::addressof(n->value_))) T(std::forward<Args>(args)...);
+    } catch (...) {
+      free_node_(n);
+      throw;
+    }
+    node *prev = head_.exchange(n, std::memory_order_acq_rel);
+    // between the exchange and this store the consumer sees the queue as ending at prev
+    prev->next_.store(n, std::memory_order_release);
+  }
+  void push(const T &value) { emplace(value); }
+  void push(T &&value) { emplace(std::move(value)); }
+
+  // consumer only. May report false while a producer is between its exchange and link,
+  // the element shows up on a later call
+  bool try_pop(T &out) {
+    node *next = tail_->next_.load(std::memory_order_acquire);
+    if (next == nullptr)
+      return false;
+    out = std::move(next->value_);
+    advance_(next);
+    return true;
+  }
+
+  std::optional<T> try_pop() {
+    node *next = tail_->next_.load(std::memory_order_acquire);
+    if (next == nullptr)
+      return std::nullopt;
+    std::optional<T> out(std::move(next->value_));
+    advance_(next);
+    return out;
+  }
+
+  // consumer only, same relaxed meaning as try_pop
+  bool empty() const noexcept { return tail_->next_.load(std::memory_order_acquire) == nullptr; }
+
+  node_allocator_type& get_node_allocator() & { return node_alloc_; }
+
+private:
+  // next becomes the new stub, the old stub goes back to the allocator
+  void advance_(node *next) {
+    next->value_.~T();
+    node *old = tail_;
+    tail_ = next;
+    free_node_(old);
+  }
+
+  bool try_pop_discard_() {
+    node *next = tail_->next_.load(std::memory_order_acquire);
+    if (next == nullptr)
+      return false;
+    advance_(next);
+    return true;
+  }
+};
+
+} // namespace cont
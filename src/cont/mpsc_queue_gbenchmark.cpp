@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "alloc/bpool_alloc.hpp"
+#include "alloc/sync_alloc.hpp"
+#include "mpsc_queue.hpp"
+
+/////////////////////////////////////////////////////////////////////////
+// P producers push timestamps, the benchmark thread consumes them all:
+// throughput is items_per_second, latency is push -> pop time of every item
+constexpr static size_t mpsc_items = 1 << 18;
+constexpr static size_t mpsc_bpool_n = 1 << 14; // 31 * N slots hold all items if the consumer starves
+
+using clock_type = std::chrono::steady_clock;
+using stamp = clock_type::time_point;
+
+// baseline: what the queue replaces
+struct locked_queue {
+  std::mutex m_;
+  std::queue<stamp> q_;
+  void push(stamp v) {
+    std::lock_guard guard(m_);
+    q_.push(v);
+  }
+  bool try_pop(stamp &out) {
+    std::lock_guard guard(m_);
+    if (q_.empty())
+      return false;
+    out = q_.front();
+    q_.pop();
+    return true;
+  }
+};
+
+using mpsc_std = cont::mpsc_queue<stamp>;
+using mpsc_bpool = cont::mpsc_queue<stamp, alloc::sync_alloc<alloc::bpool_alloc<stamp, mpsc_bpool_n>>>;
+
+template <typename Queue>
+static void BM_mpsc(benchmark::State& state)
+{
+    const size_t producers = state.range(0);
+    const size_t per_producer = mpsc_items / producers;
+    double latency_sum = 0;
+    double latency_max = 0;
+    size_t received_total = 0;
+    for(auto _: state)
+    {
+        Queue q;
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p)
+            threads.emplace_back([&] {
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                for (size_t i = 0; i < per_producer; ++i)
+                    q.push(clock_type::now());
+            });
+        auto start = clock_type::now();
+        go.store(true, std::memory_order_release);
+        stamp v;
+        for (size_t received = 0; received < producers * per_producer;) {
+            if (q.try_pop(v)) {
+                double ns = std::chrono::duration<double, std::nano>(clock_type::now() - v).count();
+                latency_sum += ns;
+                latency_max = std::max(latency_max, ns);
+                ++received;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        auto stop = clock_type::now();
+        for (auto& t: threads)
+            t.join();
+        received_total += producers * per_producer;
+        state.SetIterationTime(std::chrono::duration<double>(stop - start).count());
+    }
+    state.SetItemsProcessed(received_total);
+    state.counters["lat_avg_ns"] = latency_sum / received_total;
+    state.counters["lat_max_ns"] = latency_max;
+}
+
+static void producer_args(benchmark::internal::Benchmark* b)
+{
+    const int hw = std::max(2u, std::thread::hardware_concurrency());
+    for (int p = 1; p <= hw; p *= 2)
+        b->Arg(p);
+}
+
+BENCHMARK(BM_mpsc<locked_queue>)->Apply(producer_args)->UseManualTime()->Iterations(10);
+BENCHMARK(BM_mpsc<mpsc_std>)->Apply(producer_args)->UseManualTime()->Iterations(10);
+BENCHMARK(BM_mpsc<mpsc_bpool>)->Apply(producer_args)->UseManualTime()->Iterations(10);
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2, 2^18 items. With one core producers and consumer take turns per
+time slice, so latency is scheduler bound; the queues only show their scaling on multi core hosts.
+mpsc_bpool pays for bpool_alloc walking its (up to 5) segments on allocate and deallocate while the
+starved consumer lets the live set grow.
+------------------------------------------------------------------------------------------------------------
+Benchmark                                                  Time             CPU   Iterations UserCounters...
+------------------------------------------------------------------------------------------------------------
+BM_mpsc<locked_queue>/1/iterations:10/manual_time   28069146 ns     14024013 ns           10 items_per_second=9.33922M/s lat_avg_ns=3.22631M lat_max_ns=11.1879M
+BM_mpsc<locked_queue>/2/iterations:10/manual_time   28692923 ns     13868222 ns           10 items_per_second=9.13619M/s lat_avg_ns=8.17952M lat_max_ns=15.687M
+BM_mpsc<mpsc_std>/1/iterations:10/manual_time       29627720 ns     12699485 ns           10 items_per_second=8.84793M/s lat_avg_ns=2.05965M lat_max_ns=5.36584M
+BM_mpsc<mpsc_std>/2/iterations:10/manual_time       29306830 ns     12518346 ns           10 items_per_second=8.94481M/s lat_avg_ns=7.18223M lat_max_ns=21.0593M
+BM_mpsc<mpsc_bpool>/1/iterations:10/manual_time    120041398 ns     14251811 ns           10 items_per_second=2.18378M/s lat_avg_ns=27.9355M lat_max_ns=133.747M
+BM_mpsc<mpsc_bpool>/2/iterations:10/manual_time    108343316 ns     12298731 ns           10 items_per_second=2.41957M/s lat_avg_ns=44.7613M lat_max_ns=121.651M
+*/
@@ -0,0 +1,60 @@
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "alloc/bpool_alloc.hpp"
+#include "alloc/sync_alloc.hpp"
+#include "mpsc_queue.hpp"
+
+using namespace cont;
+
+TEST(cont_unit_tests, mpsc_queue_fifo) {
+  mpsc_queue<std::string> q;
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.try_pop().has_value());
+  for (int i = 0; i < 10; ++i)
+    q.push(std::to_string(i));
+  EXPECT_FALSE(q.empty());
+  std::string s;
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(q.try_pop(s));
+    EXPECT_EQ(s, std::to_string(i));
+  }
+  EXPECT_FALSE(q.try_pop(s));
+  q.emplace(3, 'x');
+  EXPECT_EQ(q.try_pop(), "xxx");
+  q.push("left for the destructor");
+}
+
+TEST(cont_unit_tests, mpsc_queue_bpool_producers) {
+  using queue = mpsc_queue<size_t, alloc::sync_alloc<alloc::bpool_alloc<size_t, 4096>>>; // 31 * N slots hold every value even if the consumer lags
+  constexpr size_t producers = 4;
+  constexpr size_t per_producer = 20000;
+  queue q;
+
+  std::vector<std::thread> threads;
+  for (size_t p = 0; p < producers; ++p)
+    threads.emplace_back([&q, p] {
+      for (size_t i = 0; i < per_producer; ++i)
+        q.push(p * per_producer + i);
+    });
+
+  // every producer's values must arrive complete and in its own push order
+  std::vector<size_t> next(producers, 0);
+  for (size_t received = 0; received < producers * per_producer;) {
+    if (auto v = q.try_pop()) {
+      size_t p = *v / per_producer;
+      ASSERT_LT(p, producers);
+      EXPECT_EQ(*v % per_producer, next[p]);
+      ++next[p];
+      ++received;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  for (auto& t: threads)
+    t.join();
+  EXPECT_TRUE(q.empty());
+  EXPECT_EQ(q.get_node_allocator().inner().used_count(), 1); // the stub
+}
@@ -1,335 +1,935 @@
-//-----------------------------------------------------------------------------
-//
-// based on Pablo Halpern slist realization in "Allocators: the Good Parts" CppCon 2017
-// + MIPT masters course on C++
-// 
-//----------------------------------------------------------------------------
-#pragma once
-
-#include <algorithm>
-#include <iterator>
-#include <utility>
-#include <memory>
-
-#include <boost/type_index.hpp>
-#include "utils/logging.hpp"
-
-using std::addressof;
-using std::allocator_traits;
-using std::equal;
-using std::forward;
-using std::forward_iterator_tag;
-using std::move;
-using std::ptrdiff_t;
-using std::swap;
-
-namespace cont {
-namespace slist_details {
-
-template <typename Tp> 
-struct node;
-
-template <typename Tp> 
-struct node_base {
-  node<Tp> *next_;
-
-  node_base() : next_(nullptr) { 
-    // TRACE(__PRETTY_FUNCTION__); 
-  }
-  node_base(node_base &&rhs) : next_(rhs.next_) { 
-    // TRACE(__PRETTY_FUNCTION__);
-    rhs.next_ = nullptr; 
-  }
-  node_base &operator=(node_base &&rhs) {
-    // TRACE(__PRETTY_FUNCTION__);
-    if (&rhs == this)
-      return *this;
-    next_ = rhs.next_;
-    rhs.next_ = nullptr;
-    return *this;
-  }
-  node_base(const node_base &) = delete;
-  node_base &operator=(const node_base &) = delete;
-};
-
-template <typename Tp> struct node : node_base<Tp> {
-  union {
-    Tp value_;
-  };
-};
-
-template <typename Tp> struct const_iterator {
-  using value_type = Tp;
-  using pointer = Tp const *;
-  using reference = Tp const &;
-  using difference_type = ptrdiff_t;
-  using iterator_category = forward_iterator_tag;
-
-  reference operator*() const {
-    // TRACE(__PRETTY_FUNCTION__);
-    return prev_->next_->value_; 
-  }
-  pointer operator->() const {
-    // TRACE(__PRETTY_FUNCTION__);
-    return addressof(prev_->next_->value_); 
-  }
-
-  const_iterator &operator++() {
-    prev_ = prev_->next_;
-    return *this;
-  }
-  const_iterator operator++(int) {
-    const_iterator tmp(*this);
-    ++*this;
-    return tmp;
-  }
-
-  bool operator==(const_iterator other) const { return prev_ == other.prev_; }
-  bool operator!=(const_iterator other) const { return !operator==(other); }
-
-  node_base<Tp> *prev_;
-
-  explicit const_iterator(const node_base<Tp> *prev)
-      : prev_(const_cast<node_base<Tp> *>(prev)) {
-    // TRACE(__PRETTY_FUNCTION__);
-  }
-};
-
-template <typename Tp> struct iterator : public const_iterator<Tp> {
-  using Base = const_iterator<Tp>;
-
-  using pointer = Tp *;
-  using reference = Tp &;
-
-  reference operator*() const { return this->prev_->next_->value_; }
-  pointer operator->() const { return addressof(this->prev_->next_->value_); }
-
-  iterator &operator++() {
-    Base::operator++();
-    return *this;
-  }
-  iterator operator++(int) {
-    iterator tmp(*this);
-    ++*this;
-    return tmp;
-  }
-
-  explicit iterator(node_base<Tp> *prev) : const_iterator<Tp>(prev) {
-    // TRACE(__PRETTY_FUNCTION__);    
-  }
-};
-
-} // namespace slist_details
-
-template <typename T, typename Allocator = std::allocator<std::remove_cv_t<T>>>
-struct slist {
-  using value_type = T;
-  using reference = value_type &;
-  using const_reference = value_type const &;
-  using difference_type = ptrdiff_t;
-  using size_type = size_t;
-  using allocator_type = Allocator;
-  using iterator = slist_details::iterator<value_type>;
-  using const_iterator = slist_details::const_iterator<value_type>;
-  using alloc_traits = allocator_traits<allocator_type>;
-private:
-  using node_base = slist_details::node_base<value_type>;
-  using node = slist_details::node<value_type>;
-  using node_allocator_type = typename alloc_traits::template rebind_alloc<node>; // depracated in std20 -> rebind_alloc
-  using node_alloc_traits = allocator_traits<node_allocator_type>;
-
-  node_base head_;
-  node_base *ptail_;
-  size_t size_;
-  node_allocator_type node_alloc_;
-
-public:
-  slist(node_allocator_type&& a = {}) : head_(), ptail_(&head_), size_(0), node_alloc_(std::forward<node_allocator_type>(a)) {
-    // TRACE("call [%s] with a as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(a));
-  }
-  slist(allocator_type&& a) : slist(node_alloc_type(std::forward<allocator_type>(a))) {
-    // TRACE("call [%s] with a as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(a));  
-  }
-// todo: try to apply ALL standard requirements...  
-// https://en.cppreference.com/w/cpp/named_req/AllocatorAwareContainer
-// Copy constructors of AllocatorAwareContainers obtain their instances of the allocator 
-// by calling std::allocator_traits<allocator_type>::select_on_container_copy_construction 
-// on the allocator of the container being copied.
-// https://en.cppreference.com/w/cpp/memory/allocator_traits/select_on_container_copy_construction
-  slist(const slist &other): slist(other.get_allocator()) {
-    // TRACE("call [%s] with other as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(other));    
-    operator=(other);
-  }
-  slist(const slist &other, allocator_type a): slist(a) {
-    // TRACE("call [%s] with other as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(other));      
-    operator=(other);
-  }
-// Move constructors obtain their instances of allocators by move-constructing from the allocator belonging to the old container.
-  slist(slist &&other) noexcept : slist(other.get_allocator()) {
-    // TRACE("call [%s] with other as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(other));   
-    head_ = move(other.head_);
-    ptail_ = move(other.ptail_);
-  }
-  slist(slist &&other, allocator_type a): slist(a) {
-    // TRACE("call [%s] with other as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(other));    
-    operator=(move(other));
-  }
-  slist(size_t size): slist(){
-    // TRACE(__PRETTY_FUNCTION__);       
-    while(size--)
-      push_front(T{});
-  }
-  ~slist() {
-    // TRACE(__PRETTY_FUNCTION__);
-    erase(begin(), end()); 
-  }
-
-  slist &operator=(const slist &other);
-  slist &operator=(slist &&other);
-// Swap will replace the allocator only if std::allocator_traits<allocator_type>::propagate_on_container_swap::value is true. 
-// Specifically, it will exchange the allocator instances through an unqualified call to the non-member function swap, see Swappable.  
-  void swap(slist &other) noexcept;
-
-  size_t size() const noexcept { return size_; }
-  bool empty() const noexcept { return 0 == size_; }
-
-  iterator begin() { return iterator(&head_); }
-  iterator end() { return iterator(ptail_); }
-  const_iterator begin() const { return const_iterator(&head_); }
-  const_iterator end() const { return const_iterator(ptail_); }
-  const_iterator cbegin() const { return const_iterator(&head_); }
-  const_iterator cend() const { return const_iterator(ptail_); }
-
-  T &front() { return head_.next_->value_; }
-  T const &front() const { return head_.next_->value_; }
-
-  template <typename... Args> iterator emplace(iterator i, Args &&... args);
-  template <typename... Args> void emplace_front(Args &&... args) {
-    emplace(begin(), forward<Args>(args)...);
-  }
-  template <typename... Args> void emplace_back(Args &&... args) {
-    emplace(end(), forward<Args>(args)...);
-  }
-
-  iterator insert(iterator i, const T &v) { return emplace(i, v); }
-  void push_front(const T &v) { emplace(begin(), v); }
-  void push_back(const T &v) { emplace(end(), v); }
-
-  // Note: erasing elements invalidates iterators to the node following the element being erased.
-  iterator erase(iterator b, iterator e);
-  iterator erase(iterator i) {
-    iterator e = i;
-    return erase(i, ++e);
-  }
-  void pop_front() { erase(begin()); }
-
-  // The accessor get_allocator() obtains a copy of the allocator that was used to construct the container or installed by the most recent allocator replacement operation.
-  allocator_type get_allocator() && {
-    // WARNING(__PRETTY_FUNCTION__);      
-    return allocator_type{}; 
-  }
-  node_allocator_type& get_node_allocator() & { 
-    // WARNING(__PRETTY_FUNCTION__);
-    return node_alloc_; 
-  }
-
-};
-template <typename T, typename A, typename TT, typename AA>
-bool operator==(const slist<T, A> &a, const slist<TT, AA> &b) {
-  // TRACE("call [%s] with a as [%s] and b as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(a), boost::typeindex::type_id_runtime(b));  
-  return (a.size() == b.size()) && equal(a.begin(), a.end(), b.begin());
-}
-
-template <typename T, typename A, typename TT, typename AA>
-bool operator!=(const slist<T, A> &a, const slist<TT, AA> &b) {
-  return !(a == b);
-}
-
-template <typename T, typename A> 
-slist<T, A> &slist<T, A>::operator=(const slist &other) {
-  if (&other == this)
-    return *this;
-  erase(begin(), end());
-  for (const T &v : other)
-    push_back(v);
-  return *this;
-}
-
-template <typename T, typename A> 
-slist<T, A> &slist<T, A>::operator=(slist &&other) {
-  if (&other == this)
-    return *this;
-  if (node_alloc_ == other.node_alloc_) {
-    erase(begin(), end());
-    swap(other);
-  } else
-    operator=(other); // Copy assign
-  return *this;
-}
-
-template <typename T, typename A> 
-void slist<T, A>::swap(slist &other) noexcept {
-  assert(node_alloc_ == other.node_alloc_);
-  node_base *new_tail = other.empty() ? &head_ : other.ptail_;
-  node_base *new_other_tail = empty() ? &other.head_ : ptail_;
-  swap(head_.next_, other.head_.next_);
-  swap(size_, other.size_);
-  ptail_ = new_tail;
-  other.ptail_ = new_other_tail;
-}
-
-template <typename T, typename A>
-template <typename... Args>
-typename slist<T, A>::iterator slist<T, A>::emplace(iterator it, Args &&... args) {
-  // TRACE(__PRETTY_FUNCTION__);    
-  // node *new_node = node_alloc_.allocate(); // static_cast<node *>(...)
-  node *new_node = node_alloc_traits::allocate(node_alloc_, 1);
-  try {
-/* 
-  Allocator-aware containers always call std::allocator_traits<A>::construct(m, p, args) 
-  to construct an object of type T at p using args, with m == get_allocator(). 
-  The default construct in std::allocator calls ::new((void*)p) T(args) (until C++20) 
-  std::allocator has no construct member and std::construct_at(p, args) is called when constructing elements (since C++20), 
-  but specialized allocators may choose a different definition
-*/
-    // node_alloc_traits::construct(node_alloc_, addressof(new_node->value_), forward<Args>(args)...);
-    std::construct_at(addressof(new_node->value_), forward<Args>(args)...);
-  } catch (...) {
-    // Recover resources if exception on constructor call.
-    // node_alloc_.deallocate(new_node);
-    node_alloc_traits::deallocate(node_alloc_, new_node, 1);
-    // node_alloc_.deallocate(new_node, 1);  
-    throw;
-  }
-  new_node->next_ = it.prev_->next_;
-  it.prev_->next_ = new_node;
-  if (it.prev_ == ptail_)
-    ptail_ = new_node; // Added at end
-  ++size_;
-  return it;
-}
-
-template <typename T, typename A>
-typename slist<T, A>::iterator slist<T, A>::erase(iterator b, iterator e) {
-  // TRACE(__PRETTY_FUNCTION__);  
-  node *erase_next = b.prev_->next_;
-  node *erase_past = e.prev_->next_; // one past last erasure
-  if (nullptr == erase_past)
-    ptail_ = b.prev_;          // Erasing at tail
-  b.prev_->next_ = erase_past; // splice out sublist
-  while (erase_next != erase_past) {
-    node *old_node = erase_next;
-    erase_next = erase_next->next_;
-    --size_;
-    // node_alloc_traits::destroy(node_alloc_, addressof(old_node->value_));
-		if constexpr (not std::is_fundamental_v<T>)
-		{
-      addressof(old_node->value_)->~T();
-		}    
-    node_alloc_traits::deallocate(node_alloc_, old_node, 1);
-    // node_alloc_.deallocate(old_node, 1);    
-  }
-  return b;
-}
-
-} // namespace cont
+//-----------------------------------------------------------------------------
+//
+// based on Pablo Halpern slist realization in "Allocators: the Good Parts" CppCon 2017
+// + MIPT masters course on C++
+// 
+//----------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <memory>
+#include <vector>
+
+#include <boost/type_index.hpp>
+#include "utils/logging.hpp"
+#include "utils/probes.hpp"
+
+using std::addressof;
+using std::allocator_traits;
+using std::equal;
+using std::forward;
+using std::forward_iterator_tag;
+using std::move;
+using std::ptrdiff_t;
+using std::swap;
+
+namespace cont {
+namespace slist_details {
+
+// VoidPtr is the allocator's void_pointer: links stored in nodes (and the list) are of its pointer kind,
+// e.g. offset pointers for nodes in shared memory. Iterators and locals work with raw pointers (to_address).
+template <typename Tp, typename VoidPtr = void *>
+struct node;
+
+template <typename Tp, typename VoidPtr = void *>
+struct node_base {
+  using node_pointer = typename std::pointer_traits<VoidPtr>::template rebind<node<Tp, VoidPtr>>;
+  node_pointer next_;
+
+  node_base() : next_(nullptr) { 
+    // TRACE(__PRETTY_FUNCTION__); 
+  }
+  node_base(node_base &&rhs) : next_(rhs.next_) { 
+    // TRACE(__PRETTY_FUNCTION__);
+    rhs.next_ = nullptr; 
+  }
+  node_base &operator=(node_base &&rhs) {
+    // TRACE(__PRETTY_FUNCTION__);
+    if (&rhs == this)
+      return *this;
+    next_ = rhs.next_;
+    rhs.next_ = nullptr;
+    return *this;
+  }
+  node_base(const node_base &) = delete;
+  node_base &operator=(const node_base &) = delete;
+};
+
+template <typename Tp, typename VoidPtr> struct node : node_base<Tp, VoidPtr> {
+  union {
+    Tp value_;
+  };
+};
+
+// raw pointer of a (possibly fancy) link
+template <typename P> auto raw(const P &p) noexcept { return std::to_address(p); }
+
+// links that only reach the allocator's pool (alloc::index_ptr): the list keeps its tail, which may be its own
+// head_, in a raw pointer
+template <typename VoidPtr>
+concept pool_only_pointer = requires { requires VoidPtr::pool_only; };
+
+// node allocators that may allocate on several threads at once: std::allocator (malloc, arenas per thread) and
+// those saying so (alloc::sync_alloc, under its lock)
+template <typename A>
+concept concurrent_allocator =
+    std::same_as<A, std::allocator<typename A::value_type>> || requires { requires A::concurrent; };
+
+// elements a thread gets at least in the parallel operations (slist::parallel_append, slist_parallel.hpp):
+// on fewer, starting the thread costs more than it saves
+constexpr size_t parallel_min_chunk = 1 << 14;
+// slots slist::parallel_append asks a pool for at once (halved while no segment has them in a row, doubled back
+// after a run it got)
+constexpr size_t parallel_run_slots = 1 << 12;
+
+// threads for n elements, no more than threads (0: one per core)
+inline unsigned parallel_threads(size_t n, unsigned threads) noexcept {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  return static_cast<unsigned>(std::clamp<size_t>(n / parallel_min_chunk, 1, threads));
+}
+
+// f(0) .. f(k - 1): f(0) on the calling thread, the others on threads of their own; the first exception, by j, is
+// rethrown once all have returned. Serial fallback: once std::thread fails with std::system_error (no more threads
+// to be had), the calling thread runs the rest itself. Anything else (bad_alloc) propagates after the threads started
+// are joined, the rest is not run
+template <typename F>
+void run_parallel(unsigned k, F &&f) {
+  std::vector<std::exception_ptr> errors(k);
+  auto run = [&](unsigned j) {
+    try {
+      f(j);
+    } catch (...) {
+      errors[j] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(k);
+  unsigned j = 1;
+  try {
+    for (; j < k; ++j)
+      workers.emplace_back(run, j);
+  } catch (const std::system_error &) {
+  } catch (...) {
+    for (auto &w : workers)
+      w.join();
+    throw;
+  }
+  for (unsigned r = j; r < k; ++r)
+    run(r);
+  if (k != 0)
+    run(0);
+  for (auto &w : workers)
+    w.join();
+  for (auto &e : errors)
+    if (e)
+      std::rethrow_exception(e);
+}
+
+template <typename Tp, typename VoidPtr = void *> struct const_iterator {
+  using value_type = Tp;
+  using pointer = Tp const *;
+  using reference = Tp const &;
+  using difference_type = ptrdiff_t;
+  using iterator_category = forward_iterator_tag;
+
+  reference operator*() const {
+    // TRACE(__PRETTY_FUNCTION__);
+    return prev_->next_->value_; 
+  }
+  pointer operator->() const {
+    // TRACE(__PRETTY_FUNCTION__);
+    return addressof(prev_->next_->value_); 
+  }
+
+  const_iterator &operator++() {
+    prev_ = raw(prev_->next_);
+    return *this;
+  }
+  const_iterator operator++(int) {
+    const_iterator tmp(*this);
+    ++*this;
+    return tmp;
+  }
+
+  bool operator==(const_iterator other) const { return prev_ == other.prev_; }
+  bool operator!=(const_iterator other) const { return !operator==(other); }
+
+  node_base<Tp, VoidPtr> *prev_;
+
+  explicit const_iterator(const node_base<Tp, VoidPtr> *prev)
+      : prev_(const_cast<node_base<Tp, VoidPtr> *>(prev)) {
+    // TRACE(__PRETTY_FUNCTION__);
+  }
+};
+
+template <typename Tp, typename VoidPtr = void *> struct iterator : public const_iterator<Tp, VoidPtr> {
+  using Base = const_iterator<Tp, VoidPtr>;
+
+  using pointer = Tp *;
+  using reference = Tp &;
+
+  reference operator*() const { return this->prev_->next_->value_; }
+  pointer operator->() const { return addressof(this->prev_->next_->value_); }
+
+  iterator &operator++() {
+    Base::operator++();
+    return *this;
+  }
+  iterator operator++(int) {
+    iterator tmp(*this);
+    ++*this;
+    return tmp;
+  }
+
+  explicit iterator(node_base<Tp, VoidPtr> *prev) : const_iterator<Tp, VoidPtr>(prev) {
+    // TRACE(__PRETTY_FUNCTION__);    
+  }
+};
+
+} // namespace slist_details
+
+template <typename T, typename Allocator = std::allocator<std::remove_cv_t<T>>>
+struct slist {
+  using value_type = T;
+  using reference = value_type &;
+  using const_reference = value_type const &;
+  using difference_type = ptrdiff_t;
+  using size_type = size_t;
+  using allocator_type = Allocator;
+  using alloc_traits = allocator_traits<allocator_type>;
+  using void_pointer = typename alloc_traits::void_pointer;
+  using iterator = slist_details::iterator<value_type, void_pointer>;
+  using const_iterator = slist_details::const_iterator<value_type, void_pointer>;
+private:
+  using node_base = slist_details::node_base<value_type, void_pointer>;
+  using node = slist_details::node<value_type, void_pointer>;
+  using node_allocator_type = typename alloc_traits::template rebind_alloc<node>; // depracated in std20 -> rebind_alloc
+  using node_alloc_traits = allocator_traits<node_allocator_type>;
+  using node_pointer = typename node_alloc_traits::pointer;
+  using base_pointer = std::conditional_t<slist_details::pool_only_pointer<void_pointer>, node_base *,
+                                         typename std::pointer_traits<void_pointer>::template rebind<node_base>>;
+
+  node_base head_;
+  base_pointer ptail_;
+  size_t size_;
+  node_allocator_type node_alloc_;
+
+  // allocation hint for a node to be linked after prev: allocators with a hinted allocate place it close to prev
+  const void *hint_(const node_base *prev) const noexcept {
+    return prev == &head_ ? nullptr : static_cast<const node *>(prev);
+  }
+  void compact_release_(node_base &released);
+  node *allocate_node_(const node_base *prev) {
+    return slist_details::raw(node_alloc_traits::allocate(node_alloc_, 1, hint_(prev)));
+  }
+  void deallocate_node_(node *n) {
+    node_alloc_traits::deallocate(node_alloc_, std::pointer_traits<node_pointer>::pointer_to(*n), 1);
+  }
+  node_base *tail_() const noexcept { return slist_details::raw(ptail_); }
+  // node allocators with a reserve (bpool_alloc) get all n nodes' room up front instead of growing per allocation
+  void reserve_(size_t n) {
+    if constexpr (requires { node_alloc_.reserve(n); })
+      node_alloc_.reserve(size_ + n);
+  }
+  // nodes are moved between lists only if they can be released by the other allocator
+  bool can_relink_(const slist &other) const noexcept {
+    if constexpr (node_alloc_traits::is_always_equal::value)
+      return true;
+    else if constexpr (std::equality_comparable<node_allocator_type>)
+      return node_alloc_ == other.node_alloc_;
+    else
+      return &other == this;
+  }
+  // n is the length of [first, last) when other is not this list
+  void splice_(iterator pos, slist &other, iterator first, iterator last, size_t n);
+  // stable merge of two sorted (null terminated) chains, returns the head
+  template <typename Compare>
+  static node *merge_chains_(node *a, node *b, Compare &comp);
+
+public:
+  slist(node_allocator_type&& a = {}) : head_(), ptail_(&head_), size_(0), node_alloc_(std::forward<node_allocator_type>(a)) {
+    // TRACE("call [%s] with a as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(a));
+  }
+  slist(allocator_type&& a) : slist(node_allocator_type(std::forward<allocator_type>(a))) {
+    // TRACE("call [%s] with a as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(a));  
+  }
+// todo: try to apply ALL standard requirements...  
+// https://en.cppreference.com/w/cpp/named_req/AllocatorAwareContainer
+// Copy constructors of AllocatorAwareContainers obtain their instances of the allocator 
+// by calling std::allocator_traits<allocator_type>::select_on_container_copy_construction 
+// on the allocator of the container being copied.
+// https://en.cppreference.com/w/cpp/memory/allocator_traits/select_on_container_copy_construction
+  slist(const slist &other): slist(other.get_allocator()) {
+    // TRACE("call [%s] with other as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(other));    
+    operator=(other);
+  }
+  slist(const slist &other, allocator_type a): slist(a) {
+    // TRACE("call [%s] with other as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(other));      
+    operator=(other);
+  }
+// Move constructors obtain their instances of allocators by move-constructing from the allocator belonging to the old container.
+  slist(slist &&other) noexcept : slist(other.get_allocator()) {
+    // TRACE("call [%s] with other as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(other));   
+    head_ = move(other.head_);
+    ptail_ = move(other.ptail_);
+  }
+  slist(slist &&other, allocator_type a): slist(a) {
+    // TRACE("call [%s] with other as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(other));    
+    operator=(move(other));
+  }
+  slist(size_t size): slist(){
+    // TRACE(__PRETTY_FUNCTION__);       
+    reserve_(size);
+    while(size--)
+      push_front(T{});
+  }
+  ~slist() {
+    // TRACE(__PRETTY_FUNCTION__);
+    clear(); 
+  }
+
+  slist &operator=(const slist &other);
+  slist &operator=(slist &&other);
+// Swap will replace the allocator only if std::allocator_traits<allocator_type>::propagate_on_container_swap::value is true. 
+// Specifically, it will exchange the allocator instances through an unqualified call to the non-member function swap, see Swappable.  
+  void swap(slist &other) noexcept;
+
+  size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return 0 == size_; }
+
+  iterator begin() { return iterator(&head_); }
+  iterator end() { return iterator(tail_()); }
+  const_iterator begin() const { return const_iterator(&head_); }
+  const_iterator end() const { return const_iterator(tail_()); }
+  const_iterator cbegin() const { return const_iterator(&head_); }
+  const_iterator cend() const { return const_iterator(tail_()); }
+
+  T &front() { return head_.next_->value_; }
+  T const &front() const { return head_.next_->value_; }
+
+  template <typename... Args> iterator emplace(iterator i, Args &&... args);
+  template <typename... Args> void emplace_front(Args &&... args) {
+    emplace(begin(), forward<Args>(args)...);
+  }
+  template <typename... Args> void emplace_back(Args &&... args) {
+    emplace(end(), forward<Args>(args)...);
+  }
+
+  iterator insert(iterator i, const T &v) { return emplace(i, v); }
+  void push_front(const T &v) { emplace(begin(), v); }
+  void push_back(const T &v) { emplace(end(), v); }
+
+  // Note: erasing elements invalidates iterators to the node following the element being erased.
+  iterator erase(iterator b, iterator e);
+  // With an allocator that can release all its slots at once (bpool_alloc::release) and owns nothing
+  // but this list nodes, the nodes are given back in one call: O(segments) + destructor calls, if any.
+  // Otherwise node by node, so it throws what the allocator's deallocate throws (bpool_alloc: a foreign node).
+  void clear();
+private:
+  iterator erase_(iterator b, iterator e);
+public:
+  iterator erase(iterator i) {
+    iterator e = i;
+    return erase(i, ++e);
+  }
+  void pop_front() { erase(begin()); }
+
+  // Moves elements into freshly allocated nodes in traversal order and relinks them, 
+  // so that after heavy churn a traversal walks (mostly) adjacent slots again.
+  // Note: invalidates all iterators and references.
+  void compact();
+
+  // Node reusing operations: never allocate or free, elements are relinked in place.
+  // As everywhere in slist, an iterator refers to its element through the predecessor node,
+  // so splice(pos, ...) links elements right before pos (= forward_list::splice_after(prev(pos), ...)).
+  // Lists exchanging nodes must have equal allocators.
+  void splice(iterator pos, slist &other, iterator first, iterator last) {
+    splice_(pos, other, first, last, (&other == this) ? 0 : static_cast<size_t>(std::distance(first, last)));
+  }
+  void splice(iterator pos, slist &other) {
+    splice_(pos, other, other.begin(), other.end(), other.size_);
+  }
+  void splice(iterator pos, slist &other, iterator it) {
+    iterator next = it;
+    splice(pos, other, it, ++next);
+  }
+  template <typename Compare = std::less<>> void merge(slist &other, Compare comp = {});
+  template <typename Compare = std::less<>> void sort(Compare comp = {});
+  void reverse() noexcept;
+  template <typename Pred> size_t remove_if(Pred pred);
+  size_t remove(const T &v) {
+    return remove_if([&v](const T &x) { return x == v; });
+  }
+  template <typename BinaryPred = std::equal_to<>> size_t unique(BinaryPred pred = {});
+
+  // Builds the new nodes as a detached chain (hinted to lie next to each other)
+  // and links it in at once, the list is left untouched if an exception is thrown.
+  // A sized range reserves its nodes' room first (bpool_alloc: taken in runs of adjacent slots, try_allocate_slots).
+  template <std::ranges::input_range R> iterator insert_range(iterator pos, R &&rg);
+  template <std::ranges::input_range R> void append_range(R &&rg) {
+    insert_range(end(), std::forward<R>(rg));
+  }
+  template <std::ranges::input_range R> void prepend_range(R &&rg) {
+    insert_range(begin(), std::forward<R>(rg));
+  }
+
+  // Appends gen(0) .. gen(n - 1), built on up to threads threads (0: one per core) in chunks of consecutive
+  // elements, each a detached chain, linked in at the end; the list is left untouched if gen throws. gen is called
+  // concurrently. The node allocator decides who allocates: with a concurrent one (std::allocator, alloc::sync_alloc)
+  // every thread, a pool with try_allocate_slots (bpool_alloc) is reserved and cut into runs of adjacent slots by
+  // the calling thread, a run list per chunk (single slots if it has no runs: allocates_slots()), the threads only
+  // construct and link; any other allocator builds on the calling thread.
+  template <typename Gen> void parallel_append(size_t n, Gen gen, unsigned threads = 0);
+
+  // The accessor get_allocator() obtains a copy of the allocator that was used to construct the container or installed by the most recent allocator replacement operation.
+  allocator_type get_allocator() && {
+    // WARNING(__PRETTY_FUNCTION__);      
+    return allocator_type{}; 
+  }
+  node_allocator_type& get_node_allocator() & { 
+    // WARNING(__PRETTY_FUNCTION__);
+    return node_alloc_; 
+  }
+
+};
+template <typename T, typename A, typename TT, typename AA>
+bool operator==(const slist<T, A> &a, const slist<TT, AA> &b) {
+  // TRACE("call [%s] with a as [%s] and b as [%s]", __PRETTY_FUNCTION__, boost::typeindex::type_id_runtime(a), boost::typeindex::type_id_runtime(b));  
+  return (a.size() == b.size()) && equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename T, typename A, typename TT, typename AA>
+bool operator!=(const slist<T, A> &a, const slist<TT, AA> &b) {
+  return !(a == b);
+}
+
+template <typename T, typename A> 
+slist<T, A> &slist<T, A>::operator=(const slist &other) {
+  if (&other == this)
+    return *this;
+  clear();
+  reserve_(other.size());
+  for (const T &v : other)
+    push_back(v);
+  return *this;
+}
+
+template <typename T, typename A> 
+slist<T, A> &slist<T, A>::operator=(slist &&other) {
+  if (&other == this)
+    return *this;
+  if (node_alloc_ == other.node_alloc_) {
+    erase(begin(), end());
+    swap(other);
+  } else
+    operator=(other); // Copy assign
+  return *this;
+}
+
+template <typename T, typename A> 
+void slist<T, A>::swap(slist &other) noexcept {
+  assert(node_alloc_ == other.node_alloc_);
+  node_base *new_tail = other.empty() ? &head_ : other.tail_();
+  node_base *new_other_tail = empty() ? &other.head_ : tail_();
+  swap(head_.next_, other.head_.next_);
+  swap(size_, other.size_);
+  ptail_ = new_tail;
+  other.ptail_ = new_other_tail;
+}
+
+template <typename T, typename A>
+template <typename... Args>
+typename slist<T, A>::iterator slist<T, A>::emplace(iterator it, Args &&... args) {
+  // TRACE(__PRETTY_FUNCTION__);    
+  ALLO_PROBE(slist_emplace_start, this, size_);
+  // node *new_node = node_alloc_.allocate(); // static_cast<node *>(...)
+  node *new_node = allocate_node_(it.prev_);
+  try {
+/* 
+  Allocator-aware containers always call std::allocator_traits<A>::construct(m, p, args) 
+  to construct an object of type T at p using args, with m == get_allocator(). 
+  The default construct in std::allocator calls ::new((void*)p) T(args) (until C++20) 
+  std::allocator has no construct member and std::construct_at(p, args) is called when constructing elements (since C++20), 
+  but specialized allocators may choose a different definition
+*/
+    // node_alloc_traits::construct(node_alloc_, addressof(new_node->value_), forward<Args>(args)...);
+    std::construct_at(addressof(new_node->value_), forward<Args>(args)...);
+  } catch (...) {
+    // Recover resources if exception on constructor call.
+    // node_alloc_.deallocate(new_node);
+    deallocate_node_(new_node);
+    // node_alloc_.deallocate(new_node, 1);  
+    throw;
+  }
+  new_node->next_ = it.prev_->next_;
+  it.prev_->next_ = new_node;
+  if (it.prev_ == tail_())
+    ptail_ = new_node; // Added at end
+  ++size_;
+  ALLO_PROBE(slist_emplace_done, this, size_, new_node);
+  return it;
+}
+
+template <typename T, typename A>
+void slist<T, A>::clear() {
+  // TRACE(__PRETTY_FUNCTION__);
+  if constexpr (requires { node_alloc_.release(); node_alloc_.used_count(); }) {
+    if (node_alloc_.used_count() == size_) {
+      if constexpr (not std::is_trivially_destructible_v<T>)
+        for (node *n = slist_details::raw(head_.next_); n != nullptr; n = slist_details::raw(n->next_))
+          addressof(n->value_)->~T();
+      node_alloc_.release();
+      head_.next_ = nullptr;
+      ptail_ = &head_;
+      size_ = 0;
+      return;
+    }
+  }
+  erase_(begin(), end());
+}
+
+template <typename T, typename A>
+typename slist<T, A>::iterator slist<T, A>::erase(iterator b, iterator e) {
+  // TRACE(__PRETTY_FUNCTION__);  
+  ALLO_PROBE(slist_erase_start, this, size_);
+  if (b == begin() && e == end()) {
+    clear();
+    ALLO_PROBE(slist_erase_done, this, size_);
+    return end();
+  }
+  iterator r = erase_(b, e);
+  ALLO_PROBE(slist_erase_done, this, size_);
+  return r;
+}
+
+template <typename T, typename A>
+typename slist<T, A>::iterator slist<T, A>::erase_(iterator b, iterator e) {
+  node *erase_next = slist_details::raw(b.prev_->next_);
+  node *erase_past = slist_details::raw(e.prev_->next_); // one past last erasure
+  if (nullptr == erase_past)
+    ptail_ = b.prev_;          // Erasing at tail
+  b.prev_->next_ = erase_past; // splice out sublist
+  while (erase_next != erase_past) {
+    node *old_node = erase_next;
+    erase_next = slist_details::raw(erase_next->next_);
+    --size_;
+    // node_alloc_traits::destroy(node_alloc_, addressof(old_node->value_));
+		if constexpr (not std::is_fundamental_v<T>)
+		{
+      addressof(old_node->value_)->~T();
+		}    
+    deallocate_node_(old_node);
+    // node_alloc_.deallocate(old_node, 1);    
+  }
+  return b;
+}
+
+template <typename T, typename A>
+void slist<T, A>::compact() {
+  // TRACE(__PRETTY_FUNCTION__);
+  // old nodes are released only at the end, otherwise allocator would hand the just freed (scattered) slots back
+  node_base released;
+  node_base *prev = &head_;
+  try {
+    while (node *old_node = slist_details::raw(prev->next_)) {
+      node *new_node = allocate_node_(prev);
+      try {
+        std::construct_at(addressof(new_node->value_), std::move_if_noexcept(old_node->value_));
+      } catch (...) {
+        deallocate_node_(new_node);
+        throw;
+      }
+      new_node->next_ = old_node->next_;
+      prev->next_ = new_node;
+      if (tail_() == old_node)
+        ptail_ = new_node;
+      if constexpr (not std::is_fundamental_v<T>)
+      {
+        addressof(old_node->value_)->~T();
+      }
+      old_node->next_ = released.next_;
+      released.next_ = old_node;
+      prev = new_node;
+    }
+  } catch (...) {
+    // list stays consistent (partially compacted), only the released nodes have to be freed
+    compact_release_(released);
+    throw;
+  }
+  compact_release_(released);
+}
+
+template <typename T, typename A>
+void slist<T, A>::compact_release_(node_base &released) {
+  while (node *old_node = slist_details::raw(released.next_)) {
+    released.next_ = old_node->next_;
+    deallocate_node_(old_node);
+  }
+}
+
+template <typename T, typename A>
+void slist<T, A>::splice_(iterator pos, slist &other, iterator first, iterator last, size_t n) {
+  // TRACE(__PRETTY_FUNCTION__);
+  assert(can_relink_(other));
+  if (first == last || pos == last)
+    return;
+  node *first_node = slist_details::raw(first.prev_->next_);
+  node_base *last_node = last.prev_; // last node of the range
+  // unlink [first, last) from other
+  first.prev_->next_ = last_node->next_;
+  if (other.tail_() == last_node)
+    other.ptail_ = first.prev_;
+  // and link it in before pos
+  last_node->next_ = pos.prev_->next_;
+  pos.prev_->next_ = first_node;
+  if (tail_() == pos.prev_)
+    ptail_ = last_node;
+  other.size_ -= n;
+  size_ += n;
+}
+
+template <typename T, typename A>
+template <typename Compare>
+typename slist<T, A>::node *slist<T, A>::merge_chains_(node *a, node *b, Compare &comp) {
+  node_base head;
+  node_base *last = &head;
+  while (a != nullptr && b != nullptr) {
+    // equal elements are taken from a first: stable
+    if (comp(b->value_, a->value_)) {
+      last->next_ = b;
+      b = slist_details::raw(b->next_);
+    } else {
+      last->next_ = a;
+      a = slist_details::raw(a->next_);
+    }
+    last = slist_details::raw(last->next_);
+  }
+  last->next_ = (a != nullptr) ? a : b;
+  node *result = slist_details::raw(head.next_);
+  head.next_ = nullptr;
+  return result;
+}
+
+template <typename T, typename A>
+template <typename Compare>
+void slist<T, A>::merge(slist &other, Compare comp) {
+  // TRACE(__PRETTY_FUNCTION__);
+  if (&other == this || other.empty())
+    return;
+  assert(can_relink_(other));
+  // ties keep elements of this list first, so the other tail ends the result unless it is less
+  if (empty() || !comp(static_cast<node *>(other.tail_())->value_, static_cast<node *>(tail_())->value_))
+    ptail_ = other.tail_();
+  head_.next_ = merge_chains_(slist_details::raw(head_.next_), slist_details::raw(other.head_.next_), comp);
+  size_ += other.size_;
+  other.head_.next_ = nullptr;
+  other.ptail_ = &other.head_;
+  other.size_ = 0;
+}
+
+template <typename T, typename A>
+template <typename Compare>
+void slist<T, A>::sort(Compare comp) {
+  // TRACE(__PRETTY_FUNCTION__);
+  if (size_ < 2)
+    return;
+  // bottom-up merge sort: bins[i] holds a sorted chain of 2^i nodes, older (earlier) elements in higher bins
+  constexpr size_t max_bins = std::numeric_limits<size_t>::digits;
+  node *bins[max_bins] = {};
+  node *rest = slist_details::raw(head_.next_);
+  while (rest != nullptr) {
+    node *carry = rest;
+    rest = slist_details::raw(rest->next_);
+    carry->next_ = nullptr;
+    size_t i = 0;
+    for (; bins[i] != nullptr; ++i) {
+      carry = merge_chains_(bins[i], carry, comp);
+      bins[i] = nullptr;
+    }
+    bins[i] = carry;
+  }
+  node *result = nullptr;
+  for (node *bin : bins)
+    if (bin != nullptr)
+      result = (result == nullptr) ? bin : merge_chains_(bin, result, comp);
+  head_.next_ = result;
+  node_base *last = &head_;
+  while (last->next_ != nullptr)
+    last = slist_details::raw(last->next_);
+  ptail_ = last;
+}
+
+template <typename T, typename A>
+void slist<T, A>::reverse() noexcept {
+  // TRACE(__PRETTY_FUNCTION__);
+  node *reversed = nullptr;
+  node *rest = slist_details::raw(head_.next_);
+  if (rest != nullptr)
+    ptail_ = rest;
+  while (rest != nullptr) {
+    node *next = slist_details::raw(rest->next_);
+    rest->next_ = reversed;
+    reversed = rest;
+    rest = next;
+  }
+  head_.next_ = reversed;
+}
+
+template <typename T, typename A>
+template <typename Pred>
+size_t slist<T, A>::remove_if(Pred pred) {
+  // TRACE(__PRETTY_FUNCTION__);
+  size_t removed = 0;
+  for (iterator it = begin(); it != end();) {
+    if (pred(*it)) {
+      it = erase(it);
+      ++removed;
+    } else
+      ++it;
+  }
+  return removed;
+}
+
+template <typename T, typename A>
+template <typename BinaryPred>
+size_t slist<T, A>::unique(BinaryPred pred) {
+  // TRACE(__PRETTY_FUNCTION__);
+  size_t removed = 0;
+  if (empty())
+    return removed;
+  iterator kept = begin();
+  for (iterator it = std::next(kept); it != end();) {
+    if (pred(*kept, *it)) {
+      it = erase(it);
+      ++removed;
+    } else
+      kept = it++;
+  }
+  return removed;
+}
+
+template <typename T, typename A>
+template <std::ranges::input_range R>
+typename slist<T, A>::iterator slist<T, A>::insert_range(iterator pos, R &&rg) {
+  // TRACE(__PRETTY_FUNCTION__);
+  node_base chain;
+  node_base *last = &chain;
+  size_t n = 0;
+  // sized ranges: the room reserved up front, and with a pool handing out runs of adjacent slots (bpool_alloc)
+  // the nodes taken from them, as in parallel_append; the unused rest of a run is given back slot by slot
+  size_t left = 0;        // nodes still to take, the one being taken included
+  node *run = nullptr;
+  size_t run_left = 0;    // slots of the run not taken yet
+  size_t run_len = slist_details::parallel_run_slots; // halved while no segment has them in a row, doubled back after
+  if constexpr (std::ranges::sized_range<R>) {
+    left = static_cast<size_t>(std::ranges::size(rg));
+    reserve_(left);
+  }
+  if constexpr (requires { node_alloc_.allocates_slots(); }) {
+    if (!node_alloc_.allocates_slots())
+      run_len = 1;
+  }
+  auto take_node = [&](const node_base *prev) {
+    if constexpr (requires { slist_details::raw(node_alloc_.try_allocate_slots(left)); }) {
+      if (run_left == 0)
+        for (run_len = std::min(run_len, left); run_len > 1; run_len /= 2)
+          if (node *first = slist_details::raw(node_alloc_.try_allocate_slots(run_len)); first != nullptr) {
+            run = first;
+            run_left = run_len;
+            run_len = std::min(run_len * 2, slist_details::parallel_run_slots);
+            break;
+          }
+      if (left != 0)
+        --left;
+      if (run_left != 0) {
+        --run_left;
+        return run++;
+      }
+    }
+    return allocate_node_(prev);
+  };
+  auto free_run = [&] {
+    for (; run_left != 0; --run_left)
+      deallocate_node_(run++);
+  };
+  try {
+    for (auto &&v : rg) {
+      node *new_node = take_node(last == &chain ? pos.prev_ : last);
+      try {
+        std::construct_at(addressof(new_node->value_), forward<decltype(v)>(v));
+      } catch (...) {
+        deallocate_node_(new_node);
+        throw;
+      }
+      new_node->next_ = nullptr;
+      last->next_ = new_node;
+      last = new_node;
+      ++n;
+    }
+  } catch (...) {
+    free_run();
+    while (node *old_node = slist_details::raw(chain.next_)) {
+      chain.next_ = old_node->next_;
+      if constexpr (not std::is_fundamental_v<T>)
+      {
+        addressof(old_node->value_)->~T();
+      }
+      deallocate_node_(old_node);
+    }
+    throw;
+  }
+  free_run();   // a range shorter than its size()
+  if (n == 0)
+    return pos;
+  last->next_ = pos.prev_->next_;
+  pos.prev_->next_ = chain.next_;
+  chain.next_ = nullptr;
+  if (tail_() == pos.prev_)
+    ptail_ = last;
+  size_ += n;
+  return pos;
+}
+
+template <typename T, typename A>
+template <typename Gen>
+void slist<T, A>::parallel_append(size_t n, Gen gen, unsigned threads) {
+  if constexpr (!slist_details::concurrent_allocator<node_allocator_type> &&
+                !requires { slist_details::raw(node_alloc_.try_allocate_slots(n)); }) {
+    append_range(std::views::iota(size_t{0}, n) | std::views::transform(std::ref(gen)));
+  } else {
+    if (n == 0)
+      return;
+    const unsigned k = slist_details::parallel_threads(n, threads);
+    const size_t chunk = (n + k - 1) / k;
+    struct chain {
+      node *first = nullptr;
+      node *last = nullptr;   // of the elements built
+    };
+    struct run {
+      node *first;
+      size_t count;
+    };
+    std::vector<chain> chains(k);
+    std::vector<std::vector<run>> runs(k);  // pool: the slots of each chunk
+    auto chunk_from = [&](unsigned j) { return std::min(n, j * chunk); };
+    auto chunk_to = [&](unsigned j) { return std::min(n, (j + 1) * chunk); };
+    auto append = [](chain &c, node *new_node) {
+      new_node->next_ = nullptr;
+      if (c.last == nullptr)
+        c.first = new_node;
+      else
+        c.last->next_ = new_node;
+      c.last = new_node;
+    };
+    auto free_runs = [&] {    // slot by slot, as the nodes of a run are freed once in the list
+      for (auto &chunk_runs : runs)
+        for (const run &r : chunk_runs)
+          for (node *slot = r.first; slot != r.first + r.count; ++slot)
+            deallocate_node_(slot);
+    };
+
+    if constexpr (slist_details::concurrent_allocator<node_allocator_type>) {
+      try {
+        slist_details::run_parallel(k, [&](unsigned j) {
+          node_allocator_type &a = node_alloc_;
+          chain c;    // a local: chains[j] shares its cache line with the neighbours
+          try {
+            for (size_t i = chunk_from(j); i < chunk_to(j); ++i) {
+              node *new_node = slist_details::raw(node_alloc_traits::allocate(a, 1));
+              try {
+                std::construct_at(addressof(new_node->value_), gen(i));
+              } catch (...) {
+                node_alloc_traits::deallocate(a, std::pointer_traits<node_pointer>::pointer_to(*new_node), 1);
+                throw;
+              }
+              append(c, new_node);
+            }
+          } catch (...) {
+            chains[j] = c;
+            throw;
+          }
+          chains[j] = c;
+        });
+      } catch (...) {
+        for (const chain &c : chains)
+          for (node *old_node = c.first, *next = nullptr; old_node != nullptr; old_node = next) {
+            next = slist_details::raw(old_node->next_);
+            if constexpr (not std::is_trivially_destructible_v<T>)
+              addressof(old_node->value_)->~T();
+            deallocate_node_(old_node);
+          }
+        throw;
+      }
+    } else {
+      reserve_(n);
+      bool slot_runs = true;
+      if constexpr (requires { node_alloc_.allocates_slots(); })
+        slot_runs = node_alloc_.allocates_slots();
+      try {
+        for (unsigned j = 0; j < k; ++j)
+          for (size_t left = chunk_to(j) - chunk_from(j), len = slist_details::parallel_run_slots; left != 0;) {
+            if (!slot_runs) {
+              runs[j].push_back({slist_details::raw(node_alloc_traits::allocate(node_alloc_, 1)), 1});
+              --left;
+              continue;
+            }
+            len = std::min(len, left);
+            node *first = slist_details::raw(node_alloc_.try_allocate_slots(len));
+            if (first == nullptr && len > 1) {
+              len /= 2;
+              continue;
+            }
+            if (first == nullptr)
+              first = slist_details::raw(node_alloc_traits::allocate(node_alloc_, 1));
+            runs[j].push_back({first, len});
+            left -= len;
+            len = std::min(len * 2, slist_details::parallel_run_slots);
+          }
+        slist_details::run_parallel(k, [&](unsigned j) {
+          chain c;
+          size_t i = chunk_from(j);
+          try {
+            for (const run &r : runs[j])
+              for (node *new_node = r.first; new_node != r.first + r.count; ++new_node, ++i) {
+                std::construct_at(addressof(new_node->value_), gen(i));
+                append(c, new_node);
+              }
+          } catch (...) {
+            chains[j] = c;
+            throw;
+          }
+          chains[j] = c;
+        });
+      } catch (...) {
+        if constexpr (not std::is_trivially_destructible_v<T>)
+          for (const chain &c : chains)
+            for (node *old_node = c.first; old_node != nullptr; old_node = slist_details::raw(old_node->next_))
+              addressof(old_node->value_)->~T();
+        free_runs();
+        throw;
+      }
+    }
+
+    node_base *last = tail_();
+    for (const chain &c : chains)
+      if (c.first != nullptr) {
+        last->next_ = c.first;
+        last = c.last;
+      }
+    ptail_ = last;
+    size_ += n;
+  }
+}
+
+} // namespace cont
@@ -0,0 +1,545 @@
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+#include <algorithm>
+#include <chrono>
+#include <forward_list>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <thread>
+#include <vector>
+#include "alloc/bpool_alloc.hpp"
+#include "alloc/index_bpool.hpp"
+#include "slist.hpp"
+#include "slist_parallel.hpp"
+
+/////////////////////////////////////////////////////////////////////////
+// traversal of a list whose traversal order is scattered over the pool vs the same list after compact()
+constexpr static size_t locality_count = 1 << 20;
+// segments of N, 2N, 4N, 8N slots hold the list and its compacted copy (freed slots are not reused by last policy)
+constexpr static size_t locality_bpool_n = 1 << 18;
+using locality_bpool_slist = cont::slist<int, alloc::bpool_alloc<int, locality_bpool_n>>;
+using locality_node_alloc = alloc::bpool_alloc<cont::slist_details::node<int>, locality_bpool_n>;
+
+template <typename List>
+static void fill_scattered(List &sl, size_t count)
+{
+    // every element is inserted in front of a random earlier one: O(1) per insert, random traversal order
+    std::mt19937 gen(42);
+    std::vector<typename List::iterator> pos{sl.begin()};
+    pos.reserve(count + 1);
+    for (size_t i = 0; i < count; i++)
+    {
+        auto it = pos[std::uniform_int_distribution<size_t>(0, pos.size() - 1)(gen)];
+        sl.emplace(it, static_cast<int>(i));
+        pos.push_back(std::next(it));
+    }
+}
+
+template <typename List>
+static void BM_slist_traverse(benchmark::State& state, List &sl)
+{
+    for(auto _: state)
+    {
+        benchmark::DoNotOptimize(std::accumulate(sl.begin(), sl.end(), 0LL));
+    }
+    state.SetItemsProcessed(state.iterations() * sl.size());
+}
+
+static void BM_slist_std_alloc_traverse_scattered(benchmark::State& state)
+{
+    cont::slist<int> sl;
+    fill_scattered(sl, locality_count);
+    BM_slist_traverse(state, sl);
+}
+BENCHMARK(BM_slist_std_alloc_traverse_scattered)->Unit(benchmark::kMillisecond);
+
+static void BM_slist_std_alloc_traverse_compacted(benchmark::State& state)
+{
+    cont::slist<int> sl;
+    fill_scattered(sl, locality_count);
+    sl.compact();
+    BM_slist_traverse(state, sl);
+}
+BENCHMARK(BM_slist_std_alloc_traverse_compacted)->Unit(benchmark::kMillisecond);
+
+static void BM_slist_bpool_alloc_traverse_scattered(benchmark::State& state)
+{
+    locality_bpool_slist sl(locality_node_alloc(alloc::placement_policy::last));
+    fill_scattered(sl, locality_count);
+    BM_slist_traverse(state, sl);
+}
+BENCHMARK(BM_slist_bpool_alloc_traverse_scattered)->Unit(benchmark::kMillisecond);
+
+static void BM_slist_bpool_alloc_traverse_compacted(benchmark::State& state)
+{
+    locality_bpool_slist sl(locality_node_alloc(alloc::placement_policy::last));
+    fill_scattered(sl, locality_count);
+    sl.compact();
+    BM_slist_traverse(state, sl);
+}
+BENCHMARK(BM_slist_bpool_alloc_traverse_compacted)->Unit(benchmark::kMillisecond);
+
+static void BM_slist_bpool_alloc_compact(benchmark::State& state)
+{
+    for(auto _: state)
+    {
+        // list set up and destruction are too heavy for Pause/ResumeTiming, so only compact() is timed
+        locality_bpool_slist sl(locality_node_alloc(alloc::placement_policy::last));
+        fill_scattered(sl, locality_count);
+        auto start = std::chrono::high_resolution_clock::now();
+        sl.compact();
+        auto end = std::chrono::high_resolution_clock::now();
+        state.SetIterationTime(std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count());
+    }
+    state.SetItemsProcessed(state.iterations() * locality_count);
+}
+BENCHMARK(BM_slist_bpool_alloc_compact)->Unit(benchmark::kMillisecond)->UseManualTime()->Iterations(3);
+
+/////////////////////////////////////////////////////////////////////////
+// node reusing algorithms vs std::forward_list
+template <typename List>
+static void assign_values(List &l, const std::vector<int> &values)
+{
+    std::copy(values.begin(), values.end(), l.begin());
+}
+
+static std::vector<int> random_values(size_t count)
+{
+    std::mt19937 gen(42);
+    std::vector<int> values(count);
+    std::generate(values.begin(), values.end(), [&gen]() { return static_cast<int>(gen() % 1024); });
+    return values;
+}
+
+template <typename List>
+static void BM_sort(benchmark::State& state)
+{
+    auto values = random_values(state.range(0));
+    List l(values.begin(), values.end());
+    for(auto _: state)
+    {
+        state.PauseTiming();
+        assign_values(l, values);
+        state.ResumeTiming();
+        l.sort();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename List>
+static void BM_reverse(benchmark::State& state)
+{
+    auto values = random_values(state.range(0));
+    List l(values.begin(), values.end());
+    for(auto _: state)
+    {
+        l.reverse();
+        benchmark::DoNotOptimize(l.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename List>
+static void BM_merge(benchmark::State& state)
+{
+    auto values = random_values(state.range(0));
+    std::sort(values.begin(), values.end());
+    for(auto _: state)
+    {
+        state.PauseTiming();
+        {
+            List a(values.begin(), values.end()), b(values.begin(), values.end());
+            state.ResumeTiming();
+            a.merge(b);
+            state.PauseTiming();
+        }
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 2);
+}
+
+template <typename List>
+static void BM_unique(benchmark::State& state)
+{
+    auto values = random_values(state.range(0));
+    std::sort(values.begin(), values.end());
+    for(auto _: state)
+    {
+        state.PauseTiming();
+        {
+            List l(values.begin(), values.end());
+            state.ResumeTiming();
+            l.unique();
+            state.PauseTiming();
+        }
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// moves the whole content to the other list and back
+template <typename List>
+static void BM_splice(benchmark::State& state)
+{
+    auto values = random_values(state.range(0));
+    List a(values.begin(), values.end()), b;
+    for(auto _: state)
+    {
+        if constexpr (requires { a.splice(a.end(), b); }) {
+            b.splice(b.end(), a);
+            a.splice(a.end(), b);
+        } else {
+            b.splice_after(b.before_begin(), a);
+            a.splice_after(a.before_begin(), b);
+        }
+        benchmark::DoNotOptimize(a.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 2);
+}
+
+template <typename List>
+static void BM_append_range(benchmark::State& state)
+{
+    auto values = random_values(state.range(0));
+    for(auto _: state)
+    {
+        List l;
+        if constexpr (requires { l.append_range(values); })
+            l.append_range(values);
+        else
+            l.insert_after(l.before_begin(), values.begin(), values.end());
+        benchmark::DoNotOptimize(l.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// input without size(): nothing reserved, a node allocation per element (slist: hinted)
+template <typename List>
+static void BM_append_range_unsized(benchmark::State& state)
+{
+    auto values = random_values(state.range(0));
+    auto unsized = values | std::views::filter([](int) { return true; });
+    for(auto _: state)
+    {
+        List l;
+        if constexpr (requires { l.append_range(unsized); })
+            l.append_range(unsized);
+        else
+            l.insert_after(l.before_begin(), unsized.begin(), unsized.end());
+        benchmark::DoNotOptimize(l.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename List>
+static void BM_push_back_loop(benchmark::State& state)
+{
+    auto values = random_values(state.range(0));
+    for(auto _: state)
+    {
+        List l;
+        for (auto v: values)
+            l.push_back(v);
+        benchmark::DoNotOptimize(l.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// slist has no range constructor, the benchmarks above need one
+template <typename Base>
+struct range_constructible: Base {
+    using Base::Base;
+    range_constructible() = default;
+    template <typename It>
+    range_constructible(It first, It last) { this->append_range(std::ranges::subrange(first, last)); }
+};
+
+using algo_forward_list = std::forward_list<int>;
+using algo_slist = range_constructible<cont::slist<int>>;
+// sized ranges are reserved and taken in runs of adjacent slots, the rest node by node
+using algo_bpool_slist = range_constructible<cont::slist<int, alloc::bpool_alloc<int, 1 << 16>>>;
+
+BENCHMARK(BM_sort<algo_forward_list>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_sort<algo_slist>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_reverse<algo_forward_list>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_reverse<algo_slist>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_merge<algo_forward_list>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_merge<algo_slist>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_unique<algo_forward_list>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_unique<algo_slist>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_splice<algo_forward_list>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_splice<algo_slist>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_append_range<algo_forward_list>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_append_range<algo_slist>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_append_range<algo_bpool_slist>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_append_range_unsized<algo_forward_list>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_append_range_unsized<algo_slist>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_append_range_unsized<algo_bpool_slist>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_push_back_loop<algo_slist>)->Range(1 << 10, 1 << 20);
+
+/////////////////////////////////////////////////////////////////////////
+// destruction of a 1M element list: per node deallocate vs bulk release of the pool
+constexpr static size_t destroy_bpool_n = 1 << 16;
+using destroy_std_slist = cont::slist<int>;
+using destroy_bpool_slist = cont::slist<int, alloc::bpool_alloc<int, destroy_bpool_n>>;
+
+template <typename List, bool PerNode = false>
+static void BM_slist_destroy(benchmark::State& state)
+{
+    for(auto _: state)
+    {
+        auto sl = std::make_unique<List>();
+        for (size_t i = 0; i < locality_count; i++)
+            sl->push_back(static_cast<int>(i));
+        if constexpr (PerNode) {
+            // one slot the list does not own disables the bulk release
+            [[maybe_unused]] auto *foreign = sl->get_node_allocator().allocate(1);
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        sl.reset();
+        auto end = std::chrono::high_resolution_clock::now();
+        state.SetIterationTime(std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count());
+    }
+    state.SetItemsProcessed(state.iterations() * locality_count);
+}
+BENCHMARK(BM_slist_destroy<destroy_std_slist>)->Unit(benchmark::kMillisecond)->UseManualTime()->Iterations(10);
+BENCHMARK(BM_slist_destroy<destroy_bpool_slist, true>)->Unit(benchmark::kMillisecond)->UseManualTime()->Iterations(10);
+BENCHMARK(BM_slist_destroy<destroy_bpool_slist>)->Unit(benchmark::kMillisecond)->UseManualTime()->Iterations(10);
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2
+----------------------------------------------------------------------------------------------------------------
+Benchmark                                                             Time             CPU   Iterations
+----------------------------------------------------------------------------------------------------------------
+BM_slist_std_alloc_traverse_scattered                               156 ms          154 ms            4 items_per_second=6.79973M/s
+BM_slist_std_alloc_traverse_compacted                              2.17 ms         2.13 ms          345 items_per_second=491.732M/s
+BM_slist_bpool_alloc_traverse_scattered                             139 ms          138 ms            5 items_per_second=7.59875M/s
+BM_slist_bpool_alloc_traverse_compacted                            1.86 ms         1.84 ms          377 items_per_second=570.498M/s
+BM_slist_bpool_alloc_compact/iterations:3/manual_time               282 ms          540 ms            3 items_per_second=3.72079M/s
+BM_sort<algo_forward_list>/1048576                           1234739238 ns   1223921272 ns            1 items_per_second=856.735k/s
+BM_sort<algo_slist>/1048576                                   793855257 ns    785122157 ns            1 items_per_second=1.33556M/s
+BM_reverse<algo_forward_list>/1048576                           2385763 ns      2365805 ns          275 items_per_second=443.222M/s
+BM_reverse<algo_slist>/1048576                                  2459688 ns      2406805 ns          250 items_per_second=435.671M/s
+BM_merge<algo_forward_list>/1048576                            48861064 ns     48232107 ns           36 items_per_second=43.4804M/s
+BM_merge<algo_slist>/1048576                                   56568693 ns     56179062 ns           38 items_per_second=37.3298M/s
+BM_unique<algo_forward_list>/1048576                           27188630 ns     26786818 ns           27 items_per_second=39.1452M/s
+BM_unique<algo_slist>/1048576                                  15827280 ns     15560527 ns           66 items_per_second=67.3869M/s
+BM_splice<algo_forward_list>/1048576                            4884175 ns      4808220 ns          145 items_per_second=436.16M/s
+BM_splice<algo_slist>/1048576                                      4.48 ns         4.43 ns    187794530 items_per_second=473.206T/s
+BM_append_range<algo_forward_list>/1048576                     35747471 ns     34727792 ns           19 items_per_second=30.1941M/s
+BM_append_range<algo_slist>/1048576                            19881319 ns     19627132 ns           36 items_per_second=53.4248M/s
+BM_push_back_loop<algo_slist>/1048576                          18985232 ns     18765648 ns           33 items_per_second=55.8774M/s
+BM_slist_destroy<destroy_std_slist>/iterations:10/manual_time               10.1 ms         21.4 ms           10 items_per_second=104.042M/s
+BM_slist_destroy<destroy_bpool_slist, true>/iterations:10/manual_time       11.5 ms         20.1 ms           10 items_per_second=90.8386M/s
+BM_slist_destroy<destroy_bpool_slist>/iterations:10/manual_time            0.018 ms         8.79 ms           10 items_per_second=57.7897G/s
+*/
+
+/////////////////////////////////////////////////////////////////////////
+// 32 bit links (index_bpool.hpp): slist<int> nodes of 8 bytes against the 16 byte ones of bpool_alloc and the heap,
+// on lists that fill segments N..8N. An index_bpool_alloc Tag is one arena for the whole process, mmap'ed: the
+// footprint run has a Tag of its own and counts the bytes placed in its arena instead of the malloc'ed ones.
+constexpr static size_t compact_n = 1 << 18;
+constexpr static size_t compact_count = 15 * compact_n;    // ~3.9M, the compacted copy goes to the 16N segment
+struct compact_tag {};
+struct compact_footprint_tag {};
+using compact_bpool_slist = cont::slist<int, alloc::bpool_alloc<int, compact_n>>;
+using compact_bpool_node_alloc = alloc::bpool_alloc<cont::slist_details::node<int>, compact_n>;
+template <typename Tag>
+using compact_index_slist = cont::slist<int, alloc::index_bpool_alloc<int, Tag, compact_n>>;
+
+static auto compact_heap_list() { return std::make_unique<cont::slist<int>>(); }
+static auto compact_bpool_list() {
+    return std::make_unique<compact_bpool_slist>(compact_bpool_node_alloc(alloc::placement_policy::last));
+}
+template <typename Tag = compact_tag>
+static auto compact_index_list() { return std::make_unique<compact_index_slist<Tag>>(); }
+
+// malloc'ed bytes in use: chunks of the heap and mmap'ed blocks (pool segments)
+static size_t heap_bytes()
+{
+    auto mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+// bytes per element of a compact_count list built by push_back (list nodes or segments with their bitmaps)
+template <typename Make, typename Bytes>
+static void BM_compact_footprint(benchmark::State& state, Make make, Bytes bytes)
+{
+    double per_element = 0;
+    for(auto _: state)
+    {
+        const size_t before = bytes();
+        auto sl = make();
+        for (size_t i = 0; i < compact_count; i++)
+            sl->push_back(static_cast<int>(i));
+        per_element = double(bytes() - before) / compact_count;
+        benchmark::DoNotOptimize(sl.get());
+        state.PauseTiming();
+        sl.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * compact_count);
+    state.counters["bytes_per_element"] = per_element;
+}
+
+// traversal in allocation order (push_back), or scattered over the pool (fill_scattered), optionally compacted
+template <typename Make>
+static void BM_compact_traverse(benchmark::State& state, Make make)
+{
+    auto sl = make();
+    if (state.range(0) == 0)
+        for (size_t i = 0; i < compact_count; i++)
+            sl->push_back(static_cast<int>(i));
+    else
+        fill_scattered(*sl, compact_count);
+    if (state.range(0) == 2)
+        sl->compact();
+    BM_slist_traverse(state, *sl);
+}
+
+BENCHMARK_CAPTURE(BM_compact_footprint, heap, compact_heap_list, heap_bytes)->Unit(benchmark::kMillisecond)->Iterations(1);
+BENCHMARK_CAPTURE(BM_compact_footprint, bpool, compact_bpool_list, heap_bytes)->Unit(benchmark::kMillisecond)->Iterations(1);
+BENCHMARK_CAPTURE(BM_compact_footprint, index, compact_index_list<compact_footprint_tag>,
+                  alloc::index_arena<compact_footprint_tag>::placed)->Unit(benchmark::kMillisecond)->Iterations(1);
+// order: 0 push_back, 1 scattered, 2 scattered and compact()-ed
+BENCHMARK_CAPTURE(BM_compact_traverse, heap, compact_heap_list)->ArgName("order")->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_compact_traverse, bpool, compact_bpool_list)->ArgName("order")->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_compact_traverse, index, compact_index_list<>)->ArgName("order")->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2, L3 of 300 MiB: the 3.9M element lists (63 / 31 MiB of nodes) are cache resident,
+scattered traversal is bound by the TLB and the latency of the dependent loads for every node size alike.
+footprint: malloc'ed bytes per element (heap, bpool segments and bitmaps), arena bytes for index (first run only,
+the arena is kept). In allocation order the 8 byte nodes walk ~5-10% faster than bpool's 16 byte ones.
+--------------------------------------------------------------------------------------------------
+Benchmark                                        Time             CPU   Iterations UserCounters...
+--------------------------------------------------------------------------------------------------
+BM_compact_footprint/heap/iterations:1         125 ms          121 ms            1 bytes_per_element=32 items_per_second=32.4206M/s
+BM_compact_footprint/bpool/iterations:1       42.2 ms         42.2 ms            1 bytes_per_element=16.1251 items_per_second=93.2443M/s
+BM_compact_footprint/index/iterations:1       42.1 ms         42.1 ms            1 bytes_per_element=8.12917 items_per_second=93.3274M/s
+BM_compact_traverse/heap/order:0              27.3 ms         27.1 ms           23 items_per_second=145.278M/s
+BM_compact_traverse/heap/order:1               555 ms          550 ms            1 items_per_second=7.15275M/s
+BM_compact_traverse/heap/order:2              19.4 ms         19.3 ms           37 items_per_second=203.546M/s
+BM_compact_traverse/bpool/order:0             12.6 ms         12.0 ms           62 items_per_second=326.794M/s
+BM_compact_traverse/bpool/order:1              550 ms          543 ms            1 items_per_second=7.24369M/s
+BM_compact_traverse/bpool/order:2             11.9 ms         11.8 ms           62 items_per_second=333.356M/s
+BM_compact_traverse/index/order:0             11.2 ms         11.1 ms           66 items_per_second=353.027M/s
+BM_compact_traverse/index/order:1              533 ms          529 ms            1 items_per_second=7.43902M/s
+BM_compact_traverse/index/order:2             11.4 ms         11.3 ms           62 items_per_second=348.667M/s
+*/
+
+/////////////////////////////////////////////////////////////////////////
+// parallel construction and algorithms (slist_parallel.hpp) on 10M element lists, threads from 1 to all cores
+// (4 at least, to show the cost of more threads than cores); threads:0 is the serial baseline: append_range of
+// the same values, std::accumulate / a loop for the algorithms
+constexpr static size_t parallel_count = 10'000'000;
+constexpr static size_t parallel_bpool_n = 1 << 19;       // 31 N slots: 16.2M
+using parallel_heap_slist = cont::slist<int>;
+using parallel_bpool_slist = cont::slist<int, alloc::bpool_alloc<int, parallel_bpool_n>>;
+using parallel_bpool_node_alloc = alloc::bpool_alloc<cont::slist_details::node<int>, parallel_bpool_n>;
+
+static auto parallel_heap_list() { return std::make_unique<parallel_heap_slist>(); }
+static auto parallel_bpool_list() {
+    return std::make_unique<parallel_bpool_slist>(parallel_bpool_node_alloc(alloc::placement_policy::last));
+}
+
+static void parallel_threads(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("threads")->Arg(0);
+    const unsigned cores = std::max(4u, std::thread::hardware_concurrency());
+    for (unsigned t = 1; t < cores; t *= 2)
+        b->Arg(t);
+    b->Arg(cores);
+}
+
+template <typename Make>
+static void BM_parallel_build(benchmark::State& state, Make make)
+{
+    const auto threads = static_cast<unsigned>(state.range(0));
+    auto gen = [](size_t i) { return static_cast<int>(i); };
+    for(auto _: state)
+    {
+        auto sl = make();
+        if (threads == 0)
+            sl->append_range(std::views::iota(size_t{0}, parallel_count) | std::views::transform(gen));
+        else
+            sl->parallel_append(parallel_count, gen, threads);
+        benchmark::DoNotOptimize(sl->size());
+        state.PauseTiming();
+        sl.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * parallel_count);
+}
+
+template <typename Make>
+static void BM_parallel_reduce(benchmark::State& state, Make make)
+{
+    const auto threads = static_cast<unsigned>(state.range(0));
+    auto sl = make();
+    sl->parallel_append(parallel_count, [](size_t i) { return static_cast<int>(i); });
+    for(auto _: state)
+    {
+        long sum = threads == 0 ? std::accumulate(sl->begin(), sl->end(), 0L)
+                                : cont::parallel_reduce(*sl, 0L, std::plus<>{}, threads);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * parallel_count);
+}
+
+template <typename Make>
+static void BM_parallel_transform(benchmark::State& state, Make make)
+{
+    const auto threads = static_cast<unsigned>(state.range(0));
+    auto sl = make();
+    sl->parallel_append(parallel_count, [](size_t i) { return static_cast<int>(i); });
+    auto f = [](int x) { return x * 7 + 3; };
+    for(auto _: state)
+    {
+        if (threads == 0)
+            for (int& x: *sl)
+                x = f(x);
+        else
+            cont::parallel_transform(*sl, f, threads);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * parallel_count);
+}
+BENCHMARK_CAPTURE(BM_parallel_build, heap, parallel_heap_list)->Apply(parallel_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_parallel_build, bpool, parallel_bpool_list)->Apply(parallel_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_parallel_reduce, heap, parallel_heap_list)->Apply(parallel_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_parallel_reduce, bpool, parallel_bpool_list)->Apply(parallel_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_parallel_transform, bpool, parallel_bpool_list)->Apply(parallel_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2, 3 repetitions, means, wall time: one core, so the runs past threads:1 only show
+what the threads cost when they cannot run at once (no scaling to be measured here). threads:1 against the serial
+baseline: bpool_alloc nodes reserved and taken in runs of adjacent slots build 1.6x faster than per node, the algorithms cost
+the same (one range, no walk). With k cores the walk to the range boundaries, (k - 1) / k of a traversal, stays
+serial: for work as cheap as an addition per element the speedup is bounded by about 2x, heavier f scale further.
+---------------------------------------------------------------------------------------------------------------
+Benchmark                                                      Time             CPU   Iterations UserCounters...
+---------------------------------------------------------------------------------------------------------------
+BM_parallel_build/heap/threads:0/real_time_mean             90.3 ms         89.8 ms            3 items_per_second=111.369M/s
+BM_parallel_build/heap/threads:1/real_time_mean              105 ms          104 ms            3 items_per_second=95.2373M/s
+BM_parallel_build/heap/threads:2/real_time_mean              203 ms          102 ms            3 items_per_second=49.2147M/s
+BM_parallel_build/heap/threads:4/real_time_mean              198 ms         48.9 ms            3 items_per_second=50.51M/s
+BM_parallel_build/bpool/threads:0/real_time_mean            76.3 ms         75.8 ms            3 items_per_second=131.071M/s
+BM_parallel_build/bpool/threads:1/real_time_mean            47.3 ms         47.0 ms            3 items_per_second=211.546M/s
+BM_parallel_build/bpool/threads:2/real_time_mean            48.7 ms         34.6 ms            3 items_per_second=205.682M/s
+BM_parallel_build/bpool/threads:4/real_time_mean            48.2 ms         27.2 ms            3 items_per_second=207.737M/s
+BM_parallel_reduce/heap/threads:0/real_time_mean            62.1 ms         61.1 ms            3 items_per_second=164.724M/s
+BM_parallel_reduce/heap/threads:1/real_time_mean            57.5 ms         56.4 ms            3 items_per_second=177.646M/s
+BM_parallel_reduce/heap/threads:2/real_time_mean            92.2 ms         61.5 ms            3 items_per_second=113.503M/s
+BM_parallel_reduce/heap/threads:4/real_time_mean             107 ms         61.9 ms            3 items_per_second=97.3727M/s
+BM_parallel_reduce/bpool/threads:0/real_time_mean           27.8 ms         27.6 ms            3 items_per_second=359.883M/s
+BM_parallel_reduce/bpool/threads:1/real_time_mean           27.9 ms         27.6 ms            3 items_per_second=358.952M/s
+BM_parallel_reduce/bpool/threads:2/real_time_mean           41.5 ms         27.2 ms            3 items_per_second=241.133M/s
+BM_parallel_reduce/bpool/threads:4/real_time_mean           48.6 ms         27.5 ms            3 items_per_second=205.837M/s
+BM_parallel_transform/bpool/threads:0/real_time_mean        27.8 ms         27.7 ms            3 items_per_second=359.096M/s
+BM_parallel_transform/bpool/threads:1/real_time_mean        28.5 ms         27.9 ms            3 items_per_second=350.885M/s
+BM_parallel_transform/bpool/threads:2/real_time_mean        42.8 ms         28.1 ms            3 items_per_second=233.55M/s
+BM_parallel_transform/bpool/threads:4/real_time_mean        50.1 ms         28.2 ms            3 items_per_second=199.826M/s
+*/
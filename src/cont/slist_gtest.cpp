@@ -1,48 +1,351 @@
-#include <iostream>
-#include <sstream>
-#include <numeric>
-#include <gtest/gtest.h>
-
-#include "alloc/bpool_alloc.hpp"
-#include "slist.hpp"
-
-using namespace cont;
-
-TEST(cont_unit_tests, slist_push) {
-  slist<int> sl;
-  sl.push_back(10);
-  sl.push_back(20);
-  sl.push_front(30);
-  sl.push_front(40);
-  std::stringstream ss;
-  std::copy(sl.begin(), sl.end(), std::ostream_iterator<int>(ss, "-"));
-  EXPECT_EQ(ss.str(), "40-30-10-20-");
-}
-
-TEST(cont_unit_tests, slist_bpool_push) {
-  // std::set_terminate(&my_terminate_handler);
-  slist<int, alloc::bpool_alloc<int, 10>> sl;
-  sl.push_back(10);
-  sl.push_back(20);
-  sl.push_front(30);
-  sl.push_front(40);
-  std::stringstream ss;
-  std::copy(sl.begin(), sl.end(), std::ostream_iterator<int>(ss, "-"));
-  EXPECT_EQ(ss.str(), "40-30-10-20-");
-}
-
-TEST(cont_unit_tests, slist_bpool_hw3_p1) {
-  slist<int> sl(10);
-  std::iota(sl.begin(), sl.end(), 0);
-  std::stringstream ss;
-  std::copy(sl.begin(), sl.end(), std::ostream_iterator<int>(ss, " "));
-  EXPECT_EQ(ss.str(), "0 1 2 3 4 5 6 7 8 9 ");
-}
-
-TEST(cont_unit_tests, slist_bpool_hw3_p2) {
-  slist<int, alloc::bpool_alloc<int, 10>> sl(10);
-  std::iota(sl.begin(), sl.end(), 0);
-  std::stringstream ss;
-  std::copy(sl.begin(), sl.end(), std::ostream_iterator<int>(ss, " "));
-  EXPECT_EQ(ss.str(), "0 1 2 3 4 5 6 7 8 9 ");
-}
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <numeric>
+#include <ranges>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "alloc/bpool_alloc.hpp"
+#include "alloc/sync_alloc.hpp"
+#include "slist.hpp"
+#include "slist_parallel.hpp"
+
+using namespace cont;
+
+TEST(cont_unit_tests, slist_push) {
+  slist<int> sl;
+  sl.push_back(10);
+  sl.push_back(20);
+  sl.push_front(30);
+  sl.push_front(40);
+  std::stringstream ss;
+  std::copy(sl.begin(), sl.end(), std::ostream_iterator<int>(ss, "-"));
+  EXPECT_EQ(ss.str(), "40-30-10-20-");
+}
+
+TEST(cont_unit_tests, slist_bpool_push) {
+  // std::set_terminate(&my_terminate_handler);
+  slist<int, alloc::bpool_alloc<int, 10>> sl;
+  sl.push_back(10);
+  sl.push_back(20);
+  sl.push_front(30);
+  sl.push_front(40);
+  std::stringstream ss;
+  std::copy(sl.begin(), sl.end(), std::ostream_iterator<int>(ss, "-"));
+  EXPECT_EQ(ss.str(), "40-30-10-20-");
+}
+
+TEST(cont_unit_tests, slist_bpool_hw3_p1) {
+  slist<int> sl(10);
+  std::iota(sl.begin(), sl.end(), 0);
+  std::stringstream ss;
+  std::copy(sl.begin(), sl.end(), std::ostream_iterator<int>(ss, " "));
+  EXPECT_EQ(ss.str(), "0 1 2 3 4 5 6 7 8 9 ");
+}
+
+TEST(cont_unit_tests, slist_bpool_hw3_p2) {
+  slist<int, alloc::bpool_alloc<int, 10>> sl(10);
+  std::iota(sl.begin(), sl.end(), 0);
+  std::stringstream ss;
+  std::copy(sl.begin(), sl.end(), std::ostream_iterator<int>(ss, " "));
+  EXPECT_EQ(ss.str(), "0 1 2 3 4 5 6 7 8 9 ");
+}
+
+
+TEST(cont_unit_tests, slist_bpool_compact) {
+  slist<int, alloc::bpool_alloc<int, 16>> sl;
+  std::vector<slist<int, alloc::bpool_alloc<int, 16>>::iterator> pos{sl.begin()};
+  for (int i = 0; i < 16; ++i) {
+    // insert in the middle to scatter traversal order over the pool slots
+    auto it = pos[(i * 7) % pos.size()];
+    sl.emplace(it, i);
+    pos.push_back(std::next(it));
+  }
+  std::vector<int> before(sl.begin(), sl.end());
+  sl.compact();
+  EXPECT_TRUE(std::equal(before.begin(), before.end(), sl.begin(), sl.end()));
+  EXPECT_EQ(sl.size(), 16);
+  // traversal order is address order now
+  const int *prev = nullptr;
+  for (const auto &v : sl) {
+    if (prev != nullptr) {
+      EXPECT_LT(prev, &v);
+    }
+    prev = &v;
+  }
+  sl.push_back(100);
+  EXPECT_EQ(*std::next(sl.begin(), 16), 100);
+}
+
+namespace {
+template <typename List>
+std::string dump(const List &sl) {
+  std::stringstream ss;
+  std::copy(sl.begin(), sl.end(), std::ostream_iterator<typename List::value_type>(ss, " "));
+  return ss.str();
+}
+}
+
+TEST(cont_unit_tests, slist_splice) {
+  slist<int> a, b;
+  a.append_range(std::vector<int>{1, 2, 3});
+  b.append_range(std::vector<int>{10, 20, 30});
+  a.splice(std::next(a.begin()), b, std::next(b.begin()), b.end());
+  EXPECT_EQ(dump(a), "1 20 30 2 3 ");
+  EXPECT_EQ(dump(b), "10 ");
+  EXPECT_EQ(a.size(), 5);
+  EXPECT_EQ(b.size(), 1);
+  a.splice(a.end(), b);
+  EXPECT_EQ(dump(a), "1 20 30 2 3 10 ");
+  EXPECT_TRUE(b.empty());
+  b.push_back(7); // tail of b is valid after the splice
+  EXPECT_EQ(dump(b), "7 ");
+  a.splice(a.begin(), a, std::next(a.begin(), 3), a.end()); // rotate inside one list
+  EXPECT_EQ(dump(a), "2 3 10 1 20 30 ");
+  a.push_back(40);
+  EXPECT_EQ(dump(a), "2 3 10 1 20 30 40 ");
+}
+
+TEST(cont_unit_tests, slist_bpool_sort_merge) {
+  slist<std::pair<int, int>, alloc::bpool_alloc<std::pair<int, int>, 16>> sl;
+  for (int i = 0; i < 100; ++i)
+    sl.emplace_back((i * 37) % 10, i);
+  auto total = sl.get_node_allocator().free_count();
+  sl.sort([](const auto &l, const auto &r) { return l.first < r.first; });
+  EXPECT_EQ(sl.get_node_allocator().free_count(), total); // no allocations
+  EXPECT_TRUE(std::is_sorted(sl.begin(), sl.end()));      // stable: equal keys keep insertion order
+  EXPECT_EQ(sl.size(), 100);
+  sl.push_back({100, 0});
+  EXPECT_EQ(std::next(sl.begin(), 100)->first, 100);
+
+  slist<int> a, b;
+  a.append_range(std::vector<int>{1, 3, 5, 7});
+  b.append_range(std::vector<int>{2, 3, 8, 9});
+  a.merge(b);
+  EXPECT_EQ(dump(a), "1 2 3 3 5 7 8 9 ");
+  EXPECT_TRUE(b.empty());
+  a.push_back(10);
+  EXPECT_EQ(a.size(), 9);
+  EXPECT_EQ(dump(a), "1 2 3 3 5 7 8 9 10 ");
+}
+
+TEST(cont_unit_tests, slist_reverse_remove_unique) {
+  slist<int> sl;
+  sl.append_range(std::vector<int>{1, 1, 2, 3, 3, 3, 4, 1});
+  EXPECT_EQ(sl.unique(), 3);
+  EXPECT_EQ(dump(sl), "1 2 3 4 1 ");
+  sl.reverse();
+  EXPECT_EQ(dump(sl), "1 4 3 2 1 ");
+  EXPECT_EQ(sl.remove(1), 2);
+  EXPECT_EQ(dump(sl), "4 3 2 ");
+  EXPECT_EQ(sl.remove_if([](int v) { return v % 2 == 1; }), 1);
+  sl.push_back(5);
+  EXPECT_EQ(dump(sl), "4 2 5 ");
+  sl.insert_range(std::next(sl.begin()), std::vector<int>{7, 8});
+  sl.prepend_range(std::vector<int>{0});
+  EXPECT_EQ(dump(sl), "0 4 7 8 2 5 ");
+  EXPECT_EQ(sl.size(), 6);
+}
+
+TEST(cont_unit_tests, slist_bpool_clear) {
+  slist<std::string, alloc::bpool_alloc<std::string, 8>> sl;
+  for (int i = 0; i < 50; ++i)
+    sl.push_back(std::string(32, 'a' + i % 26)); // not SSO: leaks would show up in sanitizer builds
+  auto &na = sl.get_node_allocator();
+  EXPECT_EQ(na.used_count(), 50);
+  sl.clear(); // bulk release
+  EXPECT_TRUE(sl.empty());
+  EXPECT_EQ(na.used_count(), 0);
+  EXPECT_EQ(na.free_count(), na.total_count());
+
+  sl.push_back("x");
+  sl.push_back("y");
+  auto *foreign = na.allocate(1); // slot not owned by the list: per node path
+  sl.erase(sl.begin(), sl.end());
+  EXPECT_EQ(na.used_count(), 1);
+  na.deallocate(foreign, 1);
+  sl.push_back("z");
+  EXPECT_EQ(dump(sl), "z ");
+}
+
+
+TEST(cont_unit_tests, slist_bpool_reserve) {
+  using list = slist<int, alloc::bpool_alloc<int, 8>>;
+  list sized(20);                                   // 8 + 16 slots reserved before the first node
+  EXPECT_EQ(sized.size(), 20);
+  EXPECT_EQ(sized.get_node_allocator().get_bpools_size(), 2);
+
+  list copy;
+  copy.push_back(1);
+  copy = sized;                                     // room for the copy is reserved after clearing
+  EXPECT_EQ(copy, sized);
+  EXPECT_EQ(copy.get_node_allocator().used_count(), 20);
+  EXPECT_EQ(copy.get_node_allocator().get_bpools_size(), 2);
+}
+
+namespace {
+
+// bpool_alloc counting the nodes taken in runs of slots and those allocated one by one
+template <class T>
+struct counting_pool : alloc::bpool_alloc<T, 1 << 10> {
+  using base = alloc::bpool_alloc<T, 1 << 10>;
+  size_t *runs;
+  size_t *singles;
+  counting_pool(size_t &r, size_t &s, alloc::placement_policy pp = alloc::placement_policy::first)
+      : base(pp), runs(&r), singles(&s) {}
+  template <class U>
+  counting_pool(const counting_pool<U> &other) : base(other), runs(other.runs), singles(other.singles) {}
+  template <class Up> struct rebind {
+    using other = counting_pool<Up>;
+  };
+  using base::allocate;
+  T *allocate(size_t n, const void *hint) {
+    ++*singles;
+    return base::allocate(n, hint);
+  }
+  T *try_allocate_slots(size_t n) noexcept {
+    T *p = base::try_allocate_slots(n);
+    *runs += p != nullptr;
+    return p;
+  }
+};
+
+}
+
+TEST(cont_unit_tests, slist_bpool_insert_range) {
+  std::vector<int> values(3000);
+  std::iota(values.begin(), values.end(), 0);
+  size_t runs = 0, singles = 0;
+
+  slist<int, counting_pool<int>> sized(counting_pool<int>(runs, singles));  // sized: reserved, taken in runs
+  sized.push_back(-1);
+  singles = 0;
+  sized.append_range(values);
+  EXPECT_EQ(sized.size(), 3001);
+  EXPECT_EQ(sized.get_node_allocator().used_count(), 3001);
+  EXPECT_EQ(sized.get_node_allocator().get_bpools_size(), 2);   // 1K + 2K slots reserved for 3001
+  EXPECT_GT(runs, 0);
+  EXPECT_EQ(singles, 0);                            // every node from a run
+  EXPECT_TRUE(std::equal(std::next(sized.begin()), sized.end(), values.begin()));
+  sized.remove_if([](int x) { return x % 2 == 0; });  // slots of the runs freed one by one
+  EXPECT_EQ(sized.get_node_allocator().used_count(), sized.size());
+
+  runs = singles = 0;
+  slist<int, counting_pool<int>> unsized(counting_pool<int>(runs, singles));  // not sized: a hinted node at a time
+  unsized.append_range(values | std::views::filter([](int x) { return x < 100; }));
+  EXPECT_EQ(unsized.size(), 100);
+  EXPECT_EQ(runs, 0);
+  EXPECT_EQ(singles, 100);
+  EXPECT_EQ(std::accumulate(unsized.begin(), unsized.end(), 0), 99 * 100 / 2);
+
+  runs = singles = 0;
+  slist<int, counting_pool<int>> buddy(counting_pool<int>(runs, singles, alloc::placement_policy::buddy));
+  buddy.append_range(values);                       // no runs under buddy: reserved, a slot per node
+  EXPECT_EQ(buddy.size(), 3000);
+  EXPECT_EQ(buddy.get_node_allocator().used_count(), 3000);
+  EXPECT_EQ(buddy.get_node_allocator().get_bpools_size(), 2);
+  EXPECT_EQ(runs, 0);
+  EXPECT_EQ(singles, 3000);
+
+  slist<std::string, alloc::bpool_alloc<std::string, 1 << 10>> strings;
+  strings.push_back("kept");
+  auto throwing = values | std::views::transform([](int x) { return x == 1500 ? throw 1 : std::to_string(x); });
+  static_assert(std::ranges::sized_range<decltype(throwing)>);
+  EXPECT_THROW(strings.append_range(throwing), int);
+  EXPECT_EQ(dump(strings), "kept ");                // untouched, the run given back with the nodes built
+  EXPECT_EQ(strings.get_node_allocator().used_count(), 1);
+}
+
+TEST(cont_unit_tests, slist_parallel_append) {
+  constexpr size_t n = 100000;                      // 6 chunks of slist_details::parallel_min_chunk at most
+  auto gen = [](size_t i) { return static_cast<int>(i); };
+  auto in_order = [](const auto &sl, int from) {
+    int expected = from;
+    for (int x : sl)
+      if (x != expected++)
+        return false;
+    return true;
+  };
+
+  slist<int> heap;                                  // every thread allocates
+  heap.push_back(-1);
+  heap.parallel_append(n, gen, 4);
+  EXPECT_EQ(heap.size(), n + 1);
+  EXPECT_TRUE(in_order(heap, -1));
+  heap.push_back(int(n));                           // the tail is the last chain's
+  EXPECT_EQ(std::accumulate(heap.begin(), heap.end(), 0L), long(n) * (n + 1) / 2 - 1);
+
+  using pool_list = slist<int, alloc::bpool_alloc<int, 1 << 12>>;
+  pool_list pool;                                   // runs of adjacent slots from the calling thread
+  pool.parallel_append(n, gen, 4);
+  EXPECT_EQ(pool.size(), n);
+  EXPECT_TRUE(in_order(pool, 0));
+  EXPECT_EQ(pool.get_node_allocator().used_count(), n);
+  pool.remove_if([](int x) { return x % 3 == 0; });   // slots of the runs freed one by one
+  EXPECT_EQ(pool.get_node_allocator().used_count(), pool.size());
+  pool.clear();
+  EXPECT_EQ(pool.get_node_allocator().used_count(), 0);
+
+  pool.push_back(7);
+  auto throwing = [](size_t i) { return i == n - 10 ? throw std::runtime_error("gen") : std::to_string(i); };
+  EXPECT_THROW(pool.parallel_append(n, [](size_t i) { return i == n / 2 ? throw 1 : int(i); }, 4), int);
+  EXPECT_EQ(pool.size(), 1);                        // untouched, the nodes given back
+  EXPECT_EQ(pool.get_node_allocator().used_count(), 1);
+  slist<std::string> strings;
+  EXPECT_THROW(strings.parallel_append(n, throwing, 4), std::runtime_error);
+  EXPECT_TRUE(strings.empty());
+  strings.parallel_append(3, [](size_t i) { return std::to_string(i); }, 4);   // too short to split: one chunk
+  EXPECT_EQ(dump(strings), "0 1 2 ");
+}
+
+TEST(cont_unit_tests, slist_parallel_append_allocators) {
+  constexpr size_t n = 100000;
+  auto gen = [](size_t i) { return static_cast<int>(i); };
+
+  slist<int, alloc::bpool_alloc<int, 1 << 12>> buddy(alloc::bpool_alloc<int, 1 << 12>(alloc::placement_policy::buddy));
+  EXPECT_FALSE(buddy.get_node_allocator().allocates_slots());
+  buddy.parallel_append(n, gen, 4);                 // no runs under buddy: a slot per node
+  EXPECT_EQ(buddy.size(), n);
+  EXPECT_EQ(buddy.get_node_allocator().used_count(), n);
+  EXPECT_EQ(std::accumulate(buddy.begin(), buddy.end(), 0L), long(n) * (n - 1) / 2);
+
+  using shared_list = slist<int, alloc::sync_alloc<alloc::bpool_alloc<int, 1 << 12>>>;
+  shared_list shared;                               // every thread allocates, under the lock
+  static_assert(slist_details::concurrent_allocator<std::remove_reference_t<decltype(shared.get_node_allocator())>>);
+  shared.parallel_append(n, gen, 4);
+  EXPECT_EQ(shared.size(), n);
+  EXPECT_EQ(shared.get_node_allocator().inner().used_count(), n);
+  int expected = 0;
+  EXPECT_TRUE(std::all_of(shared.begin(), shared.end(), [&expected](int x) { return x == expected++; }));
+}
+
+TEST(cont_unit_tests, slist_parallel_algorithms) {
+  constexpr size_t n = 100003;
+  slist<long> sl;
+  sl.parallel_append(n, [](size_t i) { return long(i); });
+
+  auto ranges = balanced_ranges(sl, 4);
+  ASSERT_EQ(ranges.size(), 4);
+  EXPECT_EQ(ranges.front().first, sl.begin());
+  EXPECT_EQ(ranges.back().second, sl.end());
+  for (size_t j = 0; j < ranges.size(); ++j) {
+    EXPECT_EQ(std::distance(ranges[j].first, ranges[j].second), j < 3 ? 25001 : 25000);
+    if (j != 0) {
+      EXPECT_EQ(ranges[j].first, ranges[j - 1].second);
+    }
+  }
+  EXPECT_EQ(balanced_ranges(sl, 0).size(), 0);
+
+  parallel_transform(sl, [](long x) { return 2 * x; }, 4);
+  EXPECT_EQ(parallel_reduce(sl, 0L, std::plus<>{}, 4), long(n) * (n - 1));
+  std::atomic<long> odd{0};
+  parallel_for_each(sl, [&odd](long &x) { if (++x % 2 != 0) odd.fetch_add(1, std::memory_order_relaxed); }, 4);
+  EXPECT_EQ(odd.load(), n);
+  EXPECT_EQ(parallel_reduce(sl, 5L, [](long a, long b) { return std::max(a, b); }, 4), 2 * long(n - 1) + 1);
+
+  const slist<long> empty;
+  EXPECT_EQ(parallel_reduce(empty, 42L), 42);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "slist.hpp"
+
+// Parallel algorithms over a cont::slist (any list with size(), begin(), end() and forward iterators): the calling
+// thread cuts the list into balanced ranges, walking all but the last one (the part that stays serial: a list has no
+// random access), then every range goes to a thread of its own (slist_details::run_parallel). A thread gets
+// slist_details::parallel_min_chunk elements at least, threads = 0 is one per core. The functions are called
+// concurrently, on distinct elements; the list must not change meanwhile.
+namespace cont {
+
+// k ranges [first, last) covering the list in order, of sizes differing by one at most (fewer if the list is
+// shorter than k, none if it is empty)
+template <typename List>
+auto balanced_ranges(List &list, unsigned k) {
+  using iterator = decltype(list.begin());
+  std::vector<std::pair<iterator, iterator>> ranges;
+  const size_t n = list.size();
+  k = static_cast<unsigned>(std::min<size_t>(k, n));
+  ranges.reserve(k);
+  iterator it = list.begin();
+  for (unsigned j = 0; j + 1 < k; ++j) {
+    iterator first = it;
+    std::advance(it, n / k + (j < n % k ? 1 : 0));
+    ranges.emplace_back(first, it);
+  }
+  if (k != 0)
+    ranges.emplace_back(it, list.end());    // the last range is not walked: one range costs no walk at all
+  return ranges;
+}
+
+// f(x) for every element x
+template <typename List, typename F>
+void parallel_for_each(List &list, F f, unsigned threads = 0) {
+  const auto ranges = balanced_ranges(list, slist_details::parallel_threads(list.size(), threads));
+  slist_details::run_parallel(static_cast<unsigned>(ranges.size()), [&](unsigned j) {
+    for (auto it = ranges[j].first; it != ranges[j].second; ++it)
+      f(*it);
+  });
+}
+
+// every element x replaced by f(x), in place
+template <typename List, typename F>
+void parallel_transform(List &list, F f, unsigned threads = 0) {
+  parallel_for_each(list, [&f](auto &x) { x = f(x); }, threads);
+}
+
+// init combined with every element by op, which has to be associative and commutative (std::reduce): each range
+// is folded from its first element, the partial results are folded into init in range order
+template <typename List, typename T, typename Op = std::plus<>>
+T parallel_reduce(const List &list, T init, Op op = {}, unsigned threads = 0) {
+  const auto ranges = balanced_ranges(list, slist_details::parallel_threads(list.size(), threads));
+  std::vector<std::optional<T>> partial(ranges.size());
+  slist_details::run_parallel(static_cast<unsigned>(ranges.size()), [&](unsigned j) {
+    auto it = ranges[j].first;
+    T acc = *it;
+    for (++it; it != ranges[j].second; ++it)
+      acc = op(std::move(acc), *it);
+    partial[j] = std::move(acc);
+  });
+  for (auto &p : partial)
+    init = op(std::move(init), std::move(*p));
+  return init;
+}
+
+} // namespace cont
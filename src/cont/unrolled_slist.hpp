@@ -0,0 +1,353 @@
+//-----------------------------------------------------------------------------
+//
+// unrolled singly linked list: every node (chunk) keeps up to K elements in place,
+// so iteration walks contiguous values and pays one next_ pointer per K elements
+//
+//----------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <utility>
+#include <memory>
+
+#include "utils/logging.hpp"
+
+namespace cont {
+namespace unrolled_slist_details {
+
+// chunk payload of about 4 cache lines, but never less than 4 elements per chunk
+template <typename Tp>
+constexpr size_t default_chunk_capacity() {
+  constexpr size_t chunk_bytes = 256;
+  constexpr size_t header_bytes = sizeof(void *) + sizeof(size_t);
+  return std::max<size_t>(4, (chunk_bytes - header_bytes) / sizeof(Tp));
+}
+
+template <typename Tp, size_t K>
+struct chunk {
+  chunk *next_;
+  size_t count_;
+  union {
+    Tp values_[K];
+  };
+};
+
+template <typename Tp, size_t K> struct const_iterator {
+  using value_type = Tp;
+  using pointer = Tp const *;
+  using reference = Tp const &;
+  using difference_type = ptrdiff_t;
+  using iterator_category = std::forward_iterator_tag;
+
+  reference operator*() const { return chunk_->values_[idx_]; }
+  pointer operator->() const { return std::addressof(chunk_->values_[idx_]); }
+
+  const_iterator &operator++() {
+    ++idx_;
+    normalize_();
+    return *this;
+  }
+  const_iterator operator++(int) {
+    const_iterator tmp(*this);
+    ++*this;
+    return tmp;
+  }
+
+  bool operator==(const_iterator other) const { return chunk_ == other.chunk_ && idx_ == other.idx_; }
+  bool operator!=(const_iterator other) const { return !operator==(other); }
+
+  chunk<Tp, K> *chunk_;
+  size_t idx_;
+
+  const_iterator(const chunk<Tp, K> *c = nullptr, size_t idx = 0)
+      : chunk_(const_cast<chunk<Tp, K> *>(c)), idx_(idx) {
+    normalize_();
+  }
+private:
+  // a position past the last element of its chunk moves on to the first element of the next non-empty one:
+  // the tail chunk may be empty (it is kept for the next append), so positions past the last element
+  // all collapse to end() == {nullptr, 0}
+  void normalize_() {
+    while (chunk_ != nullptr && idx_ == chunk_->count_) {
+      chunk_ = chunk_->next_;
+      idx_ = 0;
+    }
+  }
+};
+
+template <typename Tp, size_t K> struct iterator : public const_iterator<Tp, K> {
+  using Base = const_iterator<Tp, K>;
+
+  using pointer = Tp *;
+  using reference = Tp &;
+
+  reference operator*() const { return this->chunk_->values_[this->idx_]; }
+  pointer operator->() const { return std::addressof(this->chunk_->values_[this->idx_]); }
+
+  iterator &operator++() {
+    Base::operator++();
+    return *this;
+  }
+  iterator operator++(int) {
+    iterator tmp(*this);
+    ++*this;
+    return tmp;
+  }
+
+  iterator(chunk<Tp, K> *c = nullptr, size_t idx = 0) : Base(c, idx) {}
+};
+
+} // namespace unrolled_slist_details
+
+template <typename T,
+          typename Allocator = std::allocator<std::remove_cv_t<T>>,
+          size_t K = unrolled_slist_details::default_chunk_capacity<T>()>
+struct unrolled_slist {
+  static_assert(K > 1, "chunk must hold more than one element");
+
+  using value_type = T;
+  using reference = value_type &;
+  using const_reference = value_type const &;
+  using difference_type = ptrdiff_t;
+  using size_type = size_t;
+  using allocator_type = Allocator;
+  using iterator = unrolled_slist_details::iterator<value_type, K>;
+  using const_iterator = unrolled_slist_details::const_iterator<value_type, K>;
+  using alloc_traits = std::allocator_traits<allocator_type>;
+
+  constexpr static size_t chunk_capacity = K;
+private:
+  using chunk = unrolled_slist_details::chunk<value_type, K>;
+  using node_allocator_type = typename alloc_traits::template rebind_alloc<chunk>;
+  using node_alloc_traits = std::allocator_traits<node_allocator_type>;
+
+  chunk *head_;
+  chunk *tail_;
+  size_t size_;
+  node_allocator_type node_alloc_;
+
+  chunk *new_chunk_(chunk *after);
+  void free_chunk_(chunk *c) { node_alloc_traits::deallocate(node_alloc_, c, 1); }
+  // moves values [from, c->count_) of c to the front of (empty) dst
+  static void move_tail_(chunk *c, size_t from, chunk *dst) noexcept;
+  void merge_next_(chunk *c);
+
+public:
+  unrolled_slist(node_allocator_type&& a = {}) : head_(nullptr), tail_(nullptr), size_(0), node_alloc_(std::forward<node_allocator_type>(a)) {}
+  unrolled_slist(const unrolled_slist &other) : unrolled_slist() {
+    operator=(other);
+  }
+  unrolled_slist(unrolled_slist &&other) noexcept
+      : head_(other.head_), tail_(other.tail_), size_(other.size_), node_alloc_(std::move(other.node_alloc_)) {
+    other.head_ = other.tail_ = nullptr;
+    other.size_ = 0;
+  }
+  unrolled_slist(size_t size): unrolled_slist(){
+    while(size--)
+      push_back(T{});
+  }
+  ~unrolled_slist() {
+    clear();
+    if (head_ != nullptr)
+      free_chunk_(head_);
+  }
+
+  unrolled_slist &operator=(const unrolled_slist &other);
+  unrolled_slist &operator=(unrolled_slist &&other);
+  void swap(unrolled_slist &other) noexcept;
+
+  size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return 0 == size_; }
+
+  iterator begin() { return iterator(head_); }
+  iterator end() { return iterator(); }
+  const_iterator begin() const { return const_iterator(head_); }
+  const_iterator end() const { return const_iterator(); }
+  const_iterator cbegin() const { return const_iterator(head_); }
+  const_iterator cend() const { return const_iterator(); }
+
+  T &front() { return head_->values_[0]; }
+  T const &front() const { return head_->values_[0]; }
+
+  template <typename... Args> iterator emplace(iterator i, Args &&... args);
+  template <typename... Args> void emplace_front(Args &&... args) {
+    emplace(begin(), std::forward<Args>(args)...);
+  }
+  template <typename... Args> void emplace_back(Args &&... args) {
+    emplace(end(), std::forward<Args>(args)...);
+  }
+
+  iterator insert(iterator i, const T &v) { return emplace(i, v); }
+  void push_front(const T &v) { emplace(begin(), v); }
+  void push_back(const T &v) { emplace(end(), v); }
+
+  // Note: erasing invalidates iterators to the elements of the chunk being erased from (and of its successor).
+  iterator erase(iterator i);
+  iterator erase(iterator b, iterator e) {
+    for (auto n = std::distance(b, e); n > 0; --n)
+      b = erase(b);
+    return b;
+  }
+  void pop_front() { erase(begin()); }
+  // throws what the allocator's deallocate throws (bpool_alloc: a foreign chunk)
+  void clear();
+
+  node_allocator_type& get_node_allocator() & {
+    return node_alloc_;
+  }
+};
+
+template <typename T, typename A, size_t K, typename TT, typename AA, size_t KK>
+bool operator==(const unrolled_slist<T, A, K> &a, const unrolled_slist<TT, AA, KK> &b) {
+  return (a.size() == b.size()) && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename T, typename A, size_t K, typename TT, typename AA, size_t KK>
+bool operator!=(const unrolled_slist<T, A, K> &a, const unrolled_slist<TT, AA, KK> &b) {
+  return !(a == b);
+}
+
+template <typename T, typename A, size_t K>
+unrolled_slist<T, A, K> &unrolled_slist<T, A, K>::operator=(const unrolled_slist &other) {
+  if (&other == this)
+    return *this;
+  clear();
+  for (const T &v : other)
+    push_back(v);
+  return *this;
+}
+
+template <typename T, typename A, size_t K>
+unrolled_slist<T, A, K> &unrolled_slist<T, A, K>::operator=(unrolled_slist &&other) {
+  if (&other == this)
+    return *this;
+  if constexpr (node_alloc_traits::is_always_equal::value) {
+    clear();
+    swap(other);
+  } else {
+    clear();
+    for (T &v : other)
+      emplace_back(std::move(v));
+    other.clear();
+  }
+  return *this;
+}
+
+template <typename T, typename A, size_t K>
+void unrolled_slist<T, A, K>::swap(unrolled_slist &other) noexcept {
+  using std::swap;
+  swap(head_, other.head_);
+  swap(tail_, other.tail_);
+  swap(size_, other.size_);
+  if constexpr (node_alloc_traits::propagate_on_container_swap::value)
+    swap(node_alloc_, other.node_alloc_);
+}
+
+template <typename T, typename A, size_t K>
+typename unrolled_slist<T, A, K>::chunk *unrolled_slist<T, A, K>::new_chunk_(chunk *after) {
+  chunk *c = node_alloc_traits::allocate(node_alloc_, 1);
+  c->count_ = 0;
+  if (after == nullptr) {
+    c->next_ = nullptr;
+    head_ = tail_ = c;
+  } else {
+    c->next_ = after->next_;
+    after->next_ = c;
+    if (tail_ == after)
+      tail_ = c;
+  }
+  return c;
+}
+
+template <typename T, typename A, size_t K>
+void unrolled_slist<T, A, K>::move_tail_(chunk *c, size_t from, chunk *dst) noexcept {
+  for (size_t i = from; i < c->count_; ++i) {
+    std::construct_at(std::addressof(dst->values_[dst->count_++]), std::move(c->values_[i]));
+    std::destroy_at(std::addressof(c->values_[i]));
+  }
+  c->count_ = from;
+}
+
+template <typename T, typename A, size_t K>
+void unrolled_slist<T, A, K>::merge_next_(chunk *c) {
+  chunk *next = c->next_;
+  move_tail_(next, 0, c);
+  c->next_ = next->next_;
+  if (tail_ == next)
+    tail_ = c;
+  free_chunk_(next);
+}
+
+template <typename T, typename A, size_t K>
+template <typename... Args>
+typename unrolled_slist<T, A, K>::iterator unrolled_slist<T, A, K>::emplace(iterator it, Args &&... args) {
+  static_assert(std::is_nothrow_move_constructible_v<T>, "elements are shifted inside chunks");
+  // construct first (strong guarantee), then shift it into place
+  T value(std::forward<Args>(args)...);
+  chunk *c = it.chunk_;
+  size_t idx = it.idx_;
+  if (c == nullptr) {
+    // append: fill the tail chunk up, no split
+    c = tail_;
+    if (c == nullptr || c->count_ == K)
+      c = new_chunk_(c);
+    idx = c->count_;
+  } else if (c->count_ == K) {
+    // split the full chunk in halves and insert into the one that owns the position
+    chunk *upper = new_chunk_(c);
+    move_tail_(c, K / 2, upper);
+    if (idx > K / 2) {
+      c = upper;
+      idx -= K / 2;
+    }
+  }
+  for (size_t i = c->count_; i > idx; --i) {
+    std::construct_at(std::addressof(c->values_[i]), std::move(c->values_[i - 1]));
+    std::destroy_at(std::addressof(c->values_[i - 1]));
+  }
+  std::construct_at(std::addressof(c->values_[idx]), std::move(value));
+  ++c->count_;
+  ++size_;
+  return iterator(c, idx);
+}
+
+template <typename T, typename A, size_t K>
+typename unrolled_slist<T, A, K>::iterator unrolled_slist<T, A, K>::erase(iterator it) {
+  chunk *c = it.chunk_;
+  size_t idx = it.idx_;
+  assert(c != nullptr && idx < c->count_);
+  std::destroy_at(std::addressof(c->values_[idx]));
+  for (size_t i = idx + 1; i < c->count_; ++i) {
+    std::construct_at(std::addressof(c->values_[i - 1]), std::move(c->values_[i]));
+    std::destroy_at(std::addressof(c->values_[i]));
+  }
+  --c->count_;
+  --size_;
+  // only the tail chunk may stay empty; otherwise merge the successor in when both fit into half a chunk
+  if (c->next_ != nullptr && (c->count_ == 0 || c->count_ + c->next_->count_ <= K / 2))
+    merge_next_(c);
+  return iterator(c, idx);
+}
+
+template <typename T, typename A, size_t K>
+void unrolled_slist<T, A, K>::clear() {
+  // the head chunk is kept for reuse, released by the destructor only
+  chunk *c = head_;
+  while (c != nullptr) {
+    chunk *next = c->next_;
+    std::destroy(c->values_, c->values_ + c->count_);
+    c->count_ = 0;
+    if (c != head_)
+      free_chunk_(c);
+    c = next;
+  }
+  if (head_ != nullptr) {
+    head_->next_ = nullptr;
+    tail_ = head_;
+  }
+  size_ = 0;
+}
+
+} // namespace cont
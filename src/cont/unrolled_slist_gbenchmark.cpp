@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+#include <forward_list>
+#include <numeric>
+#include <vector>
+#include "alloc/bpool_alloc.hpp"
+#include "slist.hpp"
+#include "unrolled_slist.hpp"
+
+/////////////////////////////////////////////////////////////////////////
+// iteration heavy workload: build by push_back once, then sum all elements
+constexpr static size_t unrolled_bpool_n = 1 << 16; // 31 * N slots are enough for 1M nodes
+
+template <typename Cont>
+static void fill_back(Cont &c, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        c.push_back(static_cast<int>(i));
+}
+
+template <typename Cont>
+static void BM_iterate(benchmark::State& state)
+{
+    Cont c;
+    fill_back(c, state.range(0));
+    for(auto _: state)
+    {
+        benchmark::DoNotOptimize(std::accumulate(c.begin(), c.end(), 0LL));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Cont>
+static void BM_push_back(benchmark::State& state)
+{
+    for(auto _: state)
+    {
+        Cont c;
+        fill_back(c, state.range(0));
+        benchmark::DoNotOptimize(c.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// std::forward_list has no push_back
+struct forward_list_back: std::forward_list<int> {
+    std::forward_list<int>::iterator last_ = before_begin();
+    void push_back(int v) { last_ = emplace_after(last_, v); }
+};
+
+using vector_std = std::vector<int>;
+using forward_list_std = forward_list_back;
+using slist_std = cont::slist<int>;
+using slist_bpool = cont::slist<int, alloc::bpool_alloc<int, unrolled_bpool_n>>;
+using unrolled_slist_std = cont::unrolled_slist<int>;
+using unrolled_slist_bpool = cont::unrolled_slist<int, alloc::bpool_alloc<int, unrolled_bpool_n>>;
+
+BENCHMARK(BM_iterate<vector_std>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_iterate<forward_list_std>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_iterate<slist_std>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_iterate<slist_bpool>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_iterate<unrolled_slist_std>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_iterate<unrolled_slist_bpool>)->Range(1 << 10, 1 << 20);
+
+BENCHMARK(BM_push_back<vector_std>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_push_back<forward_list_std>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_push_back<slist_std>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_push_back<slist_bpool>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_push_back<unrolled_slist_std>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_push_back<unrolled_slist_bpool>)->Range(1 << 10, 1 << 20);
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2 (1K and 1M elements)
+-----------------------------------------------------------------------------------------------------------
+Benchmark                                               Time             CPU   Iterations
+-----------------------------------------------------------------------------------------------------------
+BM_iterate<vector_std>/1048576                     396179 ns       391688 ns         1806 items_per_second=2.67707G/s
+BM_iterate<forward_list_std>/1048576              4044971 ns      3986229 ns          200 items_per_second=263.05M/s
+BM_iterate<slist_std>/1048576                     7227947 ns      7117910 ns           92 items_per_second=147.315M/s
+BM_iterate<slist_bpool>/1048576                   1966949 ns      1948466 ns          376 items_per_second=538.155M/s
+BM_iterate<unrolled_slist_std>/1048576             469318 ns       464821 ns         1492 items_per_second=2.25587G/s
+BM_iterate<unrolled_slist_bpool>/1048576           466840 ns       461689 ns         1624 items_per_second=2.27117G/s
+BM_push_back<vector_std>/1048576                  1776022 ns      1757589 ns          433 items_per_second=596.599M/s
+BM_push_back<forward_list_std>/1048576           21273141 ns     20984228 ns           39 items_per_second=49.9697M/s
+BM_push_back<slist_std>/1048576                  29711241 ns     29468022 ns           24 items_per_second=35.5835M/s
+BM_push_back<slist_bpool>/1048576                18682582 ns     18375034 ns           40 items_per_second=57.0653M/s
+BM_push_back<unrolled_slist_std>/1048576          4898460 ns      4873980 ns          126 items_per_second=215.138M/s
+BM_push_back<unrolled_slist_bpool>/1048576        6665889 ns      6602975 ns          141 items_per_second=158.804M/s
+*/
@@ -0,0 +1,99 @@
+#include <sstream>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "alloc/bpool_alloc.hpp"
+#include "unrolled_slist.hpp"
+
+using namespace cont;
+
+TEST(cont_unit_tests, unrolled_slist_push) {
+  unrolled_slist<int, std::allocator<int>, 4> sl;
+  for (int i = 0; i < 10; ++i)
+    sl.push_back(i);
+  sl.push_front(-1);
+  sl.push_front(-2);
+  std::stringstream ss;
+  std::copy(sl.begin(), sl.end(), std::ostream_iterator<int>(ss, " "));
+  EXPECT_EQ(ss.str(), "-2 -1 0 1 2 3 4 5 6 7 8 9 ");
+  EXPECT_EQ(sl.size(), 12);
+  EXPECT_EQ(sl.front(), -2);
+}
+
+TEST(cont_unit_tests, unrolled_slist_bpool_hw3) {
+  unrolled_slist<int, alloc::bpool_alloc<int, 10>> sl(10);
+  std::iota(sl.begin(), sl.end(), 0);
+  std::stringstream ss;
+  std::copy(sl.begin(), sl.end(), std::ostream_iterator<int>(ss, " "));
+  EXPECT_EQ(ss.str(), "0 1 2 3 4 5 6 7 8 9 ");
+}
+
+TEST(cont_unit_tests, unrolled_slist_insert_erase) {
+  unrolled_slist<std::string, std::allocator<std::string>, 4> sl;
+  std::vector<std::string> ref;
+  // inserts in the middle split full chunks
+  for (int i = 0; i < 40; ++i) {
+    auto pos = static_cast<size_t>(i * 7) % (ref.size() + 1);
+    auto it = sl.insert(std::next(sl.begin(), pos), std::to_string(i));
+    EXPECT_EQ(*it, std::to_string(i));
+    ref.insert(ref.begin() + pos, std::to_string(i));
+  }
+  EXPECT_TRUE(std::equal(ref.begin(), ref.end(), sl.begin(), sl.end()));
+  // erases merge sparse chunks
+  for (int i = 0; i < 30; ++i) {
+    auto pos = static_cast<size_t>(i * 5) % ref.size();
+    auto it = sl.erase(std::next(sl.begin(), pos));
+    ref.erase(ref.begin() + pos);
+    if (pos < ref.size()) {
+      EXPECT_EQ(*it, ref[pos]);
+    } else {
+      EXPECT_TRUE(it == sl.end());
+    }
+  }
+  EXPECT_EQ(sl.size(), ref.size());
+  EXPECT_TRUE(std::equal(ref.begin(), ref.end(), sl.begin(), sl.end()));
+  sl.erase(sl.begin(), sl.end());
+  EXPECT_TRUE(sl.empty());
+  EXPECT_TRUE(sl.begin() == sl.end());
+  sl.push_back("again");
+  EXPECT_EQ(sl.front(), "again");
+}
+
+TEST(cont_unit_tests, unrolled_slist_erase_before_empty_tail) {
+  unrolled_slist<int, std::allocator<int>, 4> sl;
+  for (int i = 0; i < 5; ++i)                       // {0 1 2 3} {4}
+    sl.push_back(i);
+  auto it = sl.erase(std::next(sl.begin(), 4));     // {0 1 2 3} {}: the empty tail is kept
+  EXPECT_TRUE(it == sl.end());
+  it = sl.erase(std::next(sl.begin(), 3));          // the last element before the empty tail
+  EXPECT_TRUE(it == sl.end());
+  EXPECT_EQ(std::distance(sl.begin(), sl.end()), 3);
+  EXPECT_EQ(std::accumulate(sl.begin(), sl.end(), 0), 3);
+
+  for (int i = 3; i < 5; ++i)                       // and the range form
+    sl.push_back(i);
+  sl.erase(std::next(sl.begin(), 4));
+  it = sl.erase(std::next(sl.begin(), 2), sl.end());
+  EXPECT_TRUE(it == sl.end());
+  EXPECT_EQ(sl.size(), 2);
+  EXPECT_EQ(std::distance(sl.begin(), sl.end()), 2);
+  sl.push_back(7);
+  EXPECT_EQ(std::accumulate(sl.begin(), sl.end(), 0), 8);
+}
+
+TEST(cont_unit_tests, unrolled_slist_copy_move) {
+  unrolled_slist<int, alloc::bpool_alloc<int>, 8> a;
+  for (int i = 0; i < 100; ++i)
+    a.push_back(i);
+  unrolled_slist<int, alloc::bpool_alloc<int>, 8> b(a);
+  EXPECT_TRUE(a == b);
+  unrolled_slist<int, alloc::bpool_alloc<int>, 8> c(std::move(b));
+  EXPECT_TRUE(a == c);
+  EXPECT_TRUE(b.empty());
+  b = std::move(c);
+  EXPECT_TRUE(a == b);
+  a.pop_front();
+  EXPECT_TRUE(a != b);
+}
@@ -7,6 +7,7 @@
 #include <numeric>
 #include <algorithm>
 #include <iterator>
+#include <optional>
 
 #include "args/options.hpp"
 #include "utils/logs_init.hpp"
@@ -42,6 +43,21 @@ int main(int argc, char const *argv[]) {
     Logger::init(vm);
     TRACE("init logs");
 
+    if (const auto &command = vm["command"].as<std::string>(); command == "bench") {
+      auto cfg = args::bench_config(vm);
+      INFO("bench: %s, %zu bytes, %zu live, %u thread(s)", vm["allocator"].as<std::string>().c_str(), cfg.element_size,
+           cfg.live, cfg.threads);
+      std::optional<alloc::sizing_profile> sizing; // written when it goes out of scope
+      if (vm.count("sizing-profile")) {
+        cfg.sizing = &sizing.emplace(vm["sizing-profile"].as<std::string>());
+        INFO("sizing profile: %s", sizing->path().c_str());
+      }
+      bench::print(std::cout, bench::run(cfg));
+      return EXIT_SUCCESS;
+    } else if (command != "demo") {
+      throw args::opt::invalid_option_value(command);
+    }
+
     /////////////////////////// hw3 ///////////////////////////////
     {
       INFO("Start:...");
@@ -77,12 +93,12 @@ int main(int argc, char const *argv[]) {
     ERROR("Invalid command args: %s (see --help)\n", e.what());
     return EINVAL;
   } catch (const std::system_error &e) {
-    ERROR("System error [%s] code msg (%s)\n", e.what(), e.code().message());
+    ERROR("System error [%s] code msg (%s)\n", e.what(), e.code().message().c_str());
     return e.code().value();
   } catch (const std::exception& e) {
     const boost::stacktrace::stacktrace* st = boost::get_error_info<traced>(e);
     if (st){
-      ERROR("What: %s\nStack trace: %s\n", e.what(), *st);
+      ERROR("What: %s\nStack trace: %s\n", e.what(), boost::stacktrace::to_string(*st).c_str());
     } else {
       ERROR("What: %s\n", e.what());
     }
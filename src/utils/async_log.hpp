@@ -0,0 +1,383 @@
+#pragma once
+
+// Asynchronous binary logging: the calling thread only copies the format pointer, the call site
+// and the raw argument bytes into its own lock-free ring; a background thread decodes, formats
+// (printf or std::format style) and hands the text to a sink. No Boost dependency, logging.hpp plugs Boost.Log in.
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <pthread.h>
+
+namespace Logger::async {
+
+using clock = std::chrono::system_clock;
+// pthread_self() of the logging thread, widened: the native id Boost.Log shows as ThreadID
+using thread_id = std::uintmax_t;
+// time and thread are the caller's, taken when the record was enqueued
+using sink_fn = std::function<void(int level, const char *file, const char *func, int line,
+                                   clock::time_point time, thread_id thread, std::string_view message)>;
+
+inline thread_id current_thread_id() noexcept {
+  static_assert(sizeof(pthread_t) <= sizeof(thread_id));
+  thread_id id = 0;
+  pthread_t self = pthread_self();
+  std::memcpy(&id, &self, sizeof(self));
+  return id;
+}
+
+namespace details {
+
+// records are whole multiples of this: a wrap padding always has room for a header,
+// and records of different threads never share a cache line
+constexpr size_t record_align = 64;
+
+using decode_fn = int (*)(char *buf, size_t size, const char *fmt, size_t fmt_size, const std::byte *args);
+
+struct record_header {
+  decode_fn decode; // nullptr marks padding up to the end of the ring
+  uint32_t size;    // whole record, header included
+  uint32_t fmt_size; // std::format strings only, printf ones are null terminated
+  int level;
+  int line;
+  const char *file;
+  const char *func;
+  const char *fmt;
+  clock::rep time;
+  thread_id thread;
+};
+static_assert(sizeof(record_header) <= record_align);
+
+//-----------------------------------------------------------------------------
+// argument codec: scalars are copied as is, strings by value (length + bytes + '\0'),
+// so temporaries and buffers of the caller may die right after the call
+
+template <typename T>
+constexpr bool is_string_v = std::is_same_v<std::decay_t<T>, const char *> || std::is_same_v<std::decay_t<T>, char *> ||
+                             std::is_same_v<std::decay_t<T>, std::string> || std::is_same_v<std::decay_t<T>, std::string_view>;
+
+template <typename T>
+constexpr bool is_scalar_v = std::is_arithmetic_v<std::decay_t<T>> || std::is_enum_v<std::decay_t<T>> ||
+                             (std::is_pointer_v<std::decay_t<T>> && !is_string_v<T>);
+
+template <typename T>
+using decoded_t = std::conditional_t<is_string_v<T>, const char *, std::decay_t<T>>;
+
+inline std::string_view as_view(const char *s) noexcept { return s ? std::string_view(s) : std::string_view("(null)"); }
+inline std::string_view as_view(std::string_view s) noexcept { return s; }
+
+template <typename T>
+size_t arg_size(const T &v) noexcept {
+  static_assert(is_string_v<T> || is_scalar_v<T>, "async log arguments: arithmetic, enum, pointer or string");
+  if constexpr (is_string_v<T>)
+    return sizeof(uint32_t) + as_view(v).size() + 1;
+  else
+    return sizeof(T);
+}
+
+template <typename T>
+void encode_arg(std::byte *&p, const T &v) noexcept {
+  if constexpr (is_string_v<T>) {
+    std::string_view s = as_view(v);
+    auto len = static_cast<uint32_t>(s.size());
+    std::memcpy(p, &len, sizeof(len));
+    std::memcpy(p + sizeof(len), s.data(), len);
+    p[sizeof(len) + len] = std::byte{0};
+    p += sizeof(len) + len + 1;
+  } else {
+    std::memcpy(p, &v, sizeof(T));
+    p += sizeof(T);
+  }
+}
+
+template <typename T>
+decoded_t<T> decode_arg(const std::byte *&p) noexcept {
+  if constexpr (is_string_v<T>) {
+    uint32_t len;
+    std::memcpy(&len, p, sizeof(len));
+    auto s = reinterpret_cast<const char *>(p + sizeof(len));
+    p += sizeof(len) + len + 1;
+    return s;
+  } else {
+    std::decay_t<T> v;
+    std::memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return v;
+  }
+}
+
+// one instantiation per argument type list, its address is what the record stores
+template <typename... Args>
+int format_record(char *buf, size_t size, const char *fmt, size_t, [[maybe_unused]] const std::byte *args) {
+  // braced init evaluates left to right: arguments are read back in order
+  std::tuple<decoded_t<Args>...> values{decode_arg<Args>(args)...};
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+  return std::apply([&](auto... v) { return std::snprintf(buf, size, fmt, v...); }, values);
+#pragma GCC diagnostic pop
+}
+
+// std::format flavour, the format string was checked against Args at the call site
+template <typename... Args>
+int vformat_record(char *buf, size_t size, const char *fmt, size_t fmt_size, [[maybe_unused]] const std::byte *args) {
+  std::tuple<decoded_t<Args>...> values{decode_arg<Args>(args)...};
+  std::string text = std::apply([&](const auto &...v) { return std::vformat(std::string_view(fmt, fmt_size), std::make_format_args(v...)); }, values);
+  size_t n = std::min(text.size(), size - 1); // truncated like snprintf
+  std::memcpy(buf, text.data(), n);
+  buf[n] = '\0';
+  return static_cast<int>(text.size());
+}
+
+//-----------------------------------------------------------------------------
+// single producer (the owning thread) / single consumer (the backend) byte ring
+struct ring {
+  // made on the owning thread, which it takes the id of
+  explicit ring(size_t bytes) : buf_(new std::byte[bytes]), mask_(bytes - 1), owner_(current_thread_id()) {}
+
+  // room for a record of size bytes (multiple of record_align), nullptr when full
+  std::byte *reserve(size_t size) noexcept {
+    size_t capacity = mask_ + 1;
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t to_end = capacity - (head & mask_);
+    size_t needed = size <= to_end ? size : to_end + size; // may need padding up to the end first
+    if (head + needed - cached_tail_ > capacity) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head + needed - cached_tail_ > capacity)
+        return nullptr;
+    }
+    if (size > to_end) {
+      auto pad = ::new (static_cast<void *>(buf_.get() + (head & mask_))) record_header{};
+      pad->size = static_cast<uint32_t>(to_end);
+      head += to_end;
+      head_.store(head, std::memory_order_release);
+    }
+    return buf_.get() + (head & mask_);
+  }
+  void commit(size_t size) noexcept { head_.store(head_.load(std::memory_order_relaxed) + size, std::memory_order_release); }
+
+  // consumer side: calls f(header, args) for every published record
+  template <typename F>
+  size_t consume(F &&f) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t count = 0;
+    while (tail != head) {
+      auto h = reinterpret_cast<const record_header *>(buf_.get() + (tail & mask_));
+      if (h->decode != nullptr) {
+        f(*h, reinterpret_cast<const std::byte *>(h + 1));
+        ++count;
+      }
+      tail += h->size;
+      tail_.store(tail, std::memory_order_release);
+    }
+    return count;
+  }
+  bool empty() const noexcept { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+
+  std::unique_ptr<std::byte[]> buf_;
+  size_t mask_;
+  thread_id owner_;
+  alignas(record_align) std::atomic<size_t> head_{0};
+  size_t cached_tail_ = 0; // producer's last view of tail_
+  std::atomic<bool> writing_{false}; // producer between its running_ check and commit, the final drain waits for it
+  alignas(record_align) std::atomic<size_t> tail_{0};
+  std::atomic<bool> retired_{false}; // owning thread has exited, drop the ring once drained
+};
+
+} // namespace details
+
+class backend {
+public:
+  static backend &instance() {
+    static backend b;
+    return b;
+  }
+
+  // ring_bytes (a power of two) applies to rings of threads that log for the first time afterwards
+  void start(sink_fn sink, size_t ring_bytes = 1 << 16) {
+    stop();
+    sink_ = std::move(sink);
+    ring_bytes_ = std::bit_ceil(std::max(ring_bytes, 4 * details::record_align));
+    running_.store(true, std::memory_order_release);
+    worker_ = std::thread([this] { run_(); });
+  }
+  // formats everything already logged, then joins the background thread
+  void stop() {
+    if (!worker_.joinable())
+      return;
+    running_.store(false); // seq_cst, pairs with the writing_ flags (write_)
+    worker_.join();
+  }
+  // waits until every record logged so far has reached the sink
+  void flush() {
+    while (worker_.joinable() && !drained_())
+      std::this_thread::yield();
+  }
+  // records lost because the thread's ring was full, or could not be made (no memory)
+  uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+  bool running() const noexcept { return running_.load(std::memory_order_relaxed); }
+
+  // false when no backend thread runs or it is stopping (nothing was enqueued), a full ring drops the record
+  template <typename... Args>
+  bool write(int level, const char *file, const char *func, int line, const char *fmt, const Args &...args) noexcept {
+    return write_(&details::format_record<Args...>, level, file, func, line, fmt, 0, args...);
+  }
+  // fmt is a std::format string already checked against the arguments
+  template <typename... Args>
+  bool write_fmt(int level, const char *file, const char *func, int line, std::string_view fmt, const Args &...args) noexcept {
+    return write_(&details::vformat_record<Args...>, level, file, func, line, fmt.data(), fmt.size(), args...);
+  }
+
+  ~backend() { stop(); }
+
+private:
+  backend() = default;
+
+  template <typename... Args>
+  bool write_(details::decode_fn decode, int level, const char *file, const char *func, int line, const char *fmt, size_t fmt_size,
+              const Args &...args) noexcept {
+    if (!running_.load(std::memory_order_relaxed))
+      return false;
+    size_t size = sizeof(details::record_header) + (details::arg_size(args) + ... + 0);
+    size = (size + details::record_align - 1) & ~(details::record_align - 1);
+    details::ring *ring;
+    try {
+      ring = &local_ring_(); // allocates on the thread's first record
+    } catch (const std::exception &) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    details::ring &r = *ring;
+    // both seq_cst: either this write sees the backend stopping, or the backend sees it under way and drains after it
+    r.writing_.store(true);
+    if (!running_.load()) {
+      r.writing_.store(false, std::memory_order_relaxed);
+      return false;
+    }
+    std::byte *p = size <= (r.mask_ + 1) / 2 ? r.reserve(size) : nullptr;
+    if (p == nullptr) {
+      r.writing_.store(false, std::memory_order_relaxed);
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    ::new (static_cast<void *>(p)) details::record_header{decode, static_cast<uint32_t>(size), static_cast<uint32_t>(fmt_size),
+        level, line, file, func, fmt, clock::now().time_since_epoch().count(), r.owner_};
+    [[maybe_unused]] std::byte *a = p + sizeof(details::record_header);
+    (details::encode_arg(a, args), ...);
+    r.commit(size);
+    r.writing_.store(false, std::memory_order_release);
+    return true;
+  }
+
+  // registered once per thread, retired (and later dropped by the backend) at thread exit
+  struct ring_handle {
+    std::shared_ptr<details::ring> ring_;
+    explicit ring_handle(backend &b) : ring_(std::make_shared<details::ring>(b.ring_bytes_)) {
+      std::lock_guard guard(b.rings_mutex_);
+      b.rings_.push_back(ring_);
+    }
+    ~ring_handle() { ring_->retired_.store(true, std::memory_order_release); }
+  };
+  details::ring &local_ring_() {
+    thread_local ring_handle handle(*this);
+    return *handle.ring_;
+  }
+
+  bool drained_() {
+    std::lock_guard guard(rings_mutex_);
+    for (auto &r : rings_)
+      if (!r->empty())
+        return false;
+    return true;
+  }
+
+  size_t drain_() {
+    std::vector<std::shared_ptr<details::ring>> rings;
+    {
+      std::lock_guard guard(rings_mutex_);
+      std::erase_if(rings_, [](auto &r) { return r->retired_.load(std::memory_order_acquire) && r->empty(); });
+      rings = rings_;
+    }
+    size_t count = 0;
+    for (auto &r : rings)
+      count += r->consume([this](const details::record_header &h, const std::byte *args) {
+        std::string_view message;
+        try {
+          int n = h.decode(text_.data(), text_.size(), h.fmt, h.fmt_size, args);
+          message = std::string_view(text_.data(), n < 0 ? 0 : std::min<size_t>(n, text_.size() - 1));
+        } catch (const std::exception &e) { // std::format may still throw (bad_alloc), keep the backend alive
+          message = e.what();
+        }
+        sink_(h.level, h.file, h.func, h.line, clock::time_point(clock::duration(h.time)), h.thread, message);
+      });
+    return count;
+  }
+
+  void run_() {
+    while (running_.load())
+      if (drain_() == 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(200)); // producers never signal, poll
+    // writes that saw running_ still set commit before the final drain, later ones are refused
+    std::vector<std::shared_ptr<details::ring>> rings;
+    {
+      std::lock_guard guard(rings_mutex_);
+      rings = rings_;
+    }
+    for (auto &r : rings)
+      while (r->writing_.load())
+        std::this_thread::yield();
+    drain_();
+  }
+
+  sink_fn sink_;
+  size_t ring_bytes_ = 1 << 16;
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> dropped_{0};
+  std::thread worker_;
+  std::mutex rings_mutex_;
+  std::vector<std::shared_ptr<details::ring>> rings_;
+  std::vector<char> text_ = std::vector<char>(1024); // same limit as the synchronous write_log
+};
+
+template <typename... Args>
+inline bool write_log(int level, const char *file, const char *func, int line, const char *fmt, const Args &...args) noexcept {
+  return backend::instance().write(level, file, func, line, fmt, args...);
+}
+
+template <typename... Args>
+inline bool write_log_fmt(int level, const char *file, const char *func, int line, std::format_string<const Args &...> fmt, const Args &...args) noexcept {
+  return backend::instance().write_fmt(level, file, func, line, fmt.get(), args...);
+}
+
+// formats on the calling thread, same argument rules and limits as the backend (for use while it is not running)
+template <typename... Args>
+std::string format_now(const char *fmt, const Args &...args) {
+  std::vector<std::byte> encoded((details::arg_size(args) + ... + 1));
+  [[maybe_unused]] std::byte *a = encoded.data();
+  (details::encode_arg(a, args), ...);
+  std::string text(1024, '\0');
+  int n = details::format_record<Args...>(text.data(), text.size(), fmt, 0, encoded.data());
+  text.resize(n < 0 ? 0 : std::min<size_t>(n, text.size() - 1));
+  return text;
+}
+
+} // namespace Logger::async
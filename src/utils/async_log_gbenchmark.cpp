@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <string>
+#include "utils/async_log.hpp"
+
+/////////////////////////////////////////////////////////////////////////
+// cost of a log call on the calling thread. async: record into the thread's ring,
+// snprintf: what the synchronous Logger::write_log pays before Boost.Log even sees the
+// record (core, filter, sink formatting and I/O come on top of it)
+constexpr static size_t log_batch = 4096; // records between (untimed) flushes, fit the ring
+
+static void null_sink(int, const char*, const char*, int, Logger::async::clock::time_point, Logger::async::thread_id, std::string_view message)
+{
+    benchmark::DoNotOptimize(message.data());
+}
+
+static void BM_log_async(benchmark::State& state)
+{
+    auto& backend = Logger::async::backend::instance();
+    if (state.thread_index() == 0)
+        backend.start(null_sink, 1 << 20);
+    const std::string name("bpool_alloc");
+    uint64_t dropped = backend.dropped();
+    size_t i = 0;
+    for (auto _ : state) {
+        Logger::async::write_log(2, __FILE__, __FUNCTION__, __LINE__, "%s: segment %zu of %d, load %.3f", name, i, 5, 0.75);
+        if (++i % log_batch == 0) {
+            state.PauseTiming();
+            backend.flush();
+            state.ResumeTiming();
+        }
+    }
+    state.counters["dropped"] = backend.dropped() - dropped;
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+        backend.stop();
+}
+
+static void BM_log_snprintf(benchmark::State& state)
+{
+    const std::string name("bpool_alloc");
+    char buffer[1024];
+    size_t i = 0;
+    for (auto _ : state) {
+        std::snprintf(buffer, sizeof(buffer), "%s: segment %zu of %d, load %.3f", name.c_str(), i++, 5, 0.75);
+        benchmark::DoNotOptimize(buffer);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_log_async)->Threads(1)->Threads(2);
+BENCHMARK(BM_log_snprintf)->Threads(1)->Threads(2);
+
+/*
+Run on (1 X 2100 MHz CPU s), -O2. The formatting moved to the backend thread, which on a single
+core shares the CPU with the callers (untimed here, it runs during the flushes).
+------------------------------------------------------------------------------------
+Benchmark                          Time             CPU   Iterations UserCounters...
+------------------------------------------------------------------------------------
+BM_log_async/threads:1          44.6 ns         43.8 ns     17500201 dropped=0 items_per_second=22.844M/s
+BM_log_async/threads:2          21.4 ns         42.2 ns     18082342 dropped=0 items_per_second=23.7087M/s
+BM_log_snprintf/threads:1        306 ns          302 ns      1811423 items_per_second=3.30637M/s
+BM_log_snprintf/threads:2        299 ns          299 ns      2000000 items_per_second=3.34269M/s
+*/
@@ -0,0 +1,147 @@
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "utils/async_log.hpp"
+
+using namespace Logger;
+
+namespace {
+
+struct captured {
+    int level;
+    int line;
+    async::clock::time_point time;
+    async::thread_id thread;
+    std::string message;
+};
+
+struct capture_sink {
+    std::mutex m;
+    std::vector<captured> records;
+    async::sink_fn fn() {
+        return [this](int level, const char*, const char*, int line, async::clock::time_point time, async::thread_id thread,
+                      std::string_view message) {
+            std::lock_guard guard(m);
+            records.push_back({level, line, time, thread, std::string(message)});
+        };
+    }
+};
+
+enum class color { red = 7 };
+
+}
+
+TEST(utils_unit_tests, async_log_formats_arguments){
+    capture_sink sink;
+    auto& backend = async::backend::instance();
+    backend.start(sink.fn());
+    const auto before = async::clock::now();
+    {
+        std::string temporary("temp");
+        char buffer[] = "buffer";
+        async::write_log(1, __FILE__, __FUNCTION__, 10, "no args");
+        async::write_log(2, __FILE__, __FUNCTION__, 11, "%d %u %ld %.2f %c", -1, 2u, 3L, 4.5, 'x');
+        async::write_log(3, __FILE__, __FUNCTION__, 12, "%s|%s|%s|%s", "literal", temporary, std::string_view("view"), buffer);
+        async::write_log(4, __FILE__, __FUNCTION__, 13, "%d %s", static_cast<int>(color::red), static_cast<const char*>(nullptr));
+        temporary = "overwritten";          // the record owns its copy
+        buffer[0] = 'X';
+    }
+    const auto after = async::clock::now();
+    backend.flush();
+    backend.stop();
+
+    ASSERT_EQ(sink.records.size(), 4);
+    EXPECT_EQ(sink.records[0].message, "no args");
+    EXPECT_EQ(sink.records[1].message, "-1 2 3 4.50 x");
+    EXPECT_EQ(sink.records[2].message, "literal|temp|view|buffer");
+    EXPECT_EQ(sink.records[3].message, "7 (null)");
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(sink.records[i].level, i + 1);
+        EXPECT_EQ(sink.records[i].line, 10 + i);
+        EXPECT_EQ(sink.records[i].thread, async::current_thread_id());  // the caller's, not the backend's
+        EXPECT_GE(sink.records[i].time, before);                        // taken at the call
+        EXPECT_LE(sink.records[i].time, after);
+    }
+    EXPECT_EQ(async::format_now("%s=%d", std::string("x"), 42), "x=42");
+    EXPECT_FALSE(async::write_log(0, __FILE__, __FUNCTION__, 0, "backend stopped"));
+}
+
+TEST(utils_unit_tests, async_log_std_format){
+    capture_sink sink;
+    auto& backend = async::backend::instance();
+    backend.start(sink.fn());
+    {
+        std::string temporary("temp");
+        async::write_log_fmt(2, __FILE__, __FUNCTION__, 20, "{}|{:>5}|{:.1f}|{}", temporary, 42, 2.25, std::string_view("view"));
+        async::write_log_fmt(2, __FILE__, __FUNCTION__, 21, "{{}} {:#x}", 255u);
+        temporary = "overwritten";
+    }
+    backend.flush();
+    backend.stop();
+
+    ASSERT_EQ(sink.records.size(), 2);
+    EXPECT_EQ(sink.records[0].message, "temp|   42|2.2|view");
+    EXPECT_EQ(sink.records[1].message, "{} 0xff");
+}
+
+TEST(utils_unit_tests, async_log_threads){
+    constexpr int threads = 4;
+    constexpr int per_thread = 20000;   // many ring wraps, small ring: some records may be dropped
+    capture_sink sink;
+    auto& backend = async::backend::instance();
+    uint64_t dropped_before = backend.dropped();
+    backend.start(sink.fn(), 1 << 12);
+
+    std::vector<async::thread_id> ids(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+        workers.emplace_back([t, &ids]{
+            ids[t] = async::current_thread_id();
+            for (int i = 0; i < per_thread; ++i)
+                async::write_log(t, __FILE__, __FUNCTION__, i, "%d:%d %s", t, i, std::string(i % 50, '.'));
+        });
+    for (auto& w: workers)
+        w.join();
+    backend.flush();
+    backend.stop();
+
+    // per thread the records arrive in order and intact
+    std::vector<int> last(threads, -1);
+    for (auto& r: sink.records) {
+        EXPECT_EQ(r.thread, ids[r.level]);
+        EXPECT_GT(r.line, last[r.level]);
+        last[r.level] = r.line;
+        EXPECT_EQ(r.message, std::to_string(r.level) + ":" + std::to_string(r.line) + " " + std::string(r.line % 50, '.'));
+    }
+    EXPECT_EQ(sink.records.size() + (backend.dropped() - dropped_before), size_t(threads * per_thread));
+}
+
+TEST(utils_unit_tests, async_log_write_during_stop){
+    constexpr int threads = 4;
+    capture_sink sink;
+    auto& backend = async::backend::instance();
+    uint64_t dropped_before = backend.dropped();
+    backend.start(sink.fn(), 1 << 12);
+
+    // a write accepted while stop() runs reaches the sink or is counted as dropped, later ones are refused
+    std::atomic<size_t> accepted{0};
+    std::atomic<int> started{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+        workers.emplace_back([t, &accepted, &started]{
+            started.fetch_add(1);
+            for (int i = 0; async::write_log(t, __FILE__, __FUNCTION__, i, "%d:%d", t, i); ++i)
+                accepted.fetch_add(1, std::memory_order_relaxed);
+        });
+    while (started.load() < threads)
+        std::this_thread::yield();
+    backend.stop();
+    for (auto& w: workers)
+        w.join();
+
+    EXPECT_EQ(sink.records.size() + (backend.dropped() - dropped_before), accepted.load());
+}
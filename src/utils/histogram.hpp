@@ -0,0 +1,88 @@
+#pragma once
+
+// Latency histogram in the HdrHistogram layout: values below 128 are counted exactly, above that every
+// power of two range is split into 64 linear buckets, so any recorded value is known within 1/64 (1.6%)
+// up to 2^64 in a fixed 30 KB array. Recording is an index computation and an increment, no allocation.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace utils {
+
+class histogram {
+  static constexpr unsigned sub_bits = 7;                       // 2 significant decimal digits
+  static constexpr uint64_t sub_count = uint64_t{1} << sub_bits; // exact range, 128
+  static constexpr uint64_t half_count = sub_count / 2;          // buckets per power of two above it
+
+public:
+  static constexpr size_t bucket_count = sub_count + (64 - sub_bits) * half_count;
+
+  static constexpr size_t index_of(uint64_t v) noexcept {
+    if (v < sub_count)
+      return v;
+    unsigned shift = std::bit_width(v) - sub_bits; // >= 1, keeps the top 7 bits: [64, 128)
+    return sub_count + (shift - 1) * half_count + ((v >> shift) - half_count);
+  }
+  // the range [lowest_of(i), highest_of(i)] is counted by bucket i
+  static constexpr uint64_t lowest_of(size_t i) noexcept {
+    if (i < sub_count)
+      return i;
+    unsigned shift = (i - sub_count) / half_count + 1;
+    return ((i - sub_count) % half_count + half_count) << shift;
+  }
+  static constexpr uint64_t highest_of(size_t i) noexcept {
+    if (i < sub_count)
+      return i;
+    unsigned shift = (i - sub_count) / half_count + 1;
+    return lowest_of(i) + ((uint64_t{1} << shift) - 1);
+  }
+
+  void record(uint64_t v) noexcept {
+    ++_counts[index_of(v)];
+    ++_total;
+    _min = std::min(_min, v);
+    _max = std::max(_max, v);
+    _sum += v;
+  }
+  void merge(const histogram &other) noexcept {
+    for (size_t i = 0; i < bucket_count; ++i)
+      _counts[i] += other._counts[i];
+    _total += other._total;
+    _min = std::min(_min, other._min);
+    _max = std::max(_max, other._max);
+    _sum += other._sum;
+  }
+  void clear() noexcept { *this = histogram(); }
+
+  uint64_t count() const noexcept { return _total; }
+  uint64_t min() const noexcept { return _total ? _min : 0; }
+  uint64_t max() const noexcept { return _max; }
+  double mean() const noexcept { return _total ? static_cast<double>(_sum) / static_cast<double>(_total) : 0.0; }
+
+  // smallest recorded value v (as the top of its bucket) with at least p percent of the values <= v;
+  // never above max(), 0 when empty
+  uint64_t percentile(double p) const noexcept {
+    if (_total == 0)
+      return 0;
+    auto rank = static_cast<uint64_t>(std::clamp(p, 0.0, 100.0) / 100.0 * static_cast<double>(_total) + 0.5);
+    rank = std::clamp<uint64_t>(rank, 1, _total);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucket_count; ++i)
+      if ((seen += _counts[i]) >= rank)
+        return std::min(highest_of(i), _max);
+    return _max;
+  }
+
+private:
+  std::array<uint64_t, bucket_count> _counts{};
+  uint64_t _total = 0;
+  uint64_t _min = std::numeric_limits<uint64_t>::max();
+  uint64_t _max = 0;
+  uint64_t _sum = 0;
+};
+
+} // namespace utils
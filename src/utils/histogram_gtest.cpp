@@ -0,0 +1,72 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include "utils/histogram.hpp"
+
+using utils::histogram;
+
+TEST(utils_unit_tests, histogram_buckets){
+  for (uint64_t v : {0ull, 1ull, 127ull, 128ull, 129ull, 255ull, 256ull, 1000ull, 123456789ull, ~0ull}) {
+    auto i = histogram::index_of(v);
+    ASSERT_LT(i, histogram::bucket_count);
+    EXPECT_LE(histogram::lowest_of(i), v);
+    EXPECT_GE(histogram::highest_of(i), v);
+    EXPECT_LE(histogram::highest_of(i) - histogram::lowest_of(i), v / 64); // 1/64 relative precision
+  }
+  EXPECT_EQ(histogram::index_of(127), 127);
+  EXPECT_EQ(histogram::index_of(~0ull), histogram::bucket_count - 1);
+  for (size_t i = 1; i < histogram::bucket_count; ++i)   // contiguous, no value is lost between buckets
+    ASSERT_EQ(histogram::lowest_of(i), histogram::highest_of(i - 1) + 1);
+}
+
+TEST(utils_unit_tests, histogram_percentiles){
+  histogram h;
+  EXPECT_EQ(h.percentile(50), 0);
+  for (uint64_t v = 1; v <= 100; ++v)
+    h.record(v);
+  EXPECT_EQ(h.count(), 100);
+  EXPECT_EQ(h.min(), 1);
+  EXPECT_EQ(h.max(), 100);
+  EXPECT_DOUBLE_EQ(h.mean(), 50.5);
+  EXPECT_EQ(h.percentile(50), 50);   // exact below 128
+  EXPECT_EQ(h.percentile(99), 99);
+  EXPECT_EQ(h.percentile(100), 100);
+  EXPECT_EQ(h.percentile(0), 1);
+
+  // a long tail: p99.9 and max apart from the bulk
+  histogram t;
+  for (int i = 0; i < 9990; ++i)
+    t.record(20);
+  for (int i = 0; i < 9; ++i)
+    t.record(5000);
+  t.record(1'000'000);
+  EXPECT_EQ(t.percentile(50), 20);
+  EXPECT_EQ(t.percentile(99), 20);
+  EXPECT_NEAR(double(t.percentile(99.95)), 5000.0, 5000.0 / 64);
+  EXPECT_EQ(t.max(), 1'000'000);
+  EXPECT_EQ(t.percentile(100), 1'000'000);
+}
+
+TEST(utils_unit_tests, histogram_merge_matches_sorted){
+  std::mt19937_64 rng(7);
+  std::lognormal_distribution<double> dist(5.0, 1.5);
+  histogram a, b;
+  std::vector<uint64_t> all;
+  for (int i = 0; i < 100000; ++i) {
+    auto v = static_cast<uint64_t>(dist(rng));
+    (i % 2 ? a : b).record(v);
+    all.push_back(v);
+  }
+  a.merge(b);
+  std::sort(all.begin(), all.end());
+  EXPECT_EQ(a.count(), all.size());
+  EXPECT_EQ(a.max(), all.back());
+  EXPECT_EQ(a.min(), all.front());
+  for (double p : {50.0, 90.0, 99.0, 99.9}) {
+    auto exact = all[static_cast<size_t>(p / 100 * all.size() + 0.5) - 1];
+    EXPECT_NEAR(double(a.percentile(p)), double(exact), double(exact) / 64 + 1) << p;
+  }
+}
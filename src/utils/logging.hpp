@@ -1,5 +1,16 @@
 #pragma once
 
+// Severity numbering of boost::log::trivial::severity_level: trace 0, debug 1, info 2, warning 3, error 4, fatal 5.
+// Calls below LOG_MIN_LEVEL are compiled out, their arguments are never evaluated.
+// Default: trace only without NDEBUG, release builds keep the trace calls of the allocation hot paths out.
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL 1
+#else
+#define LOG_MIN_LEVEL 0
+#endif
+#endif
+
 #ifndef ENABLE_LOGGING
 
 #define TRACE(msg, ...)
@@ -8,19 +19,63 @@
 #define WARNING(msg, ...)
 #define ERROR(msg, ...)
 
+#define TRACE_FMT(fmt, ...)
+#define DEBUG_FMT(fmt, ...)
+#define INFO_FMT(fmt, ...)
+#define WARNING_FMT(fmt, ...)
+#define ERROR_FMT(fmt, ...)
+
 #else
 
 #include <stdarg.h>
+#include <atomic>
+#include <format>
+#include <string_view>
 // #include <boost/log/core.hpp>
 #include <boost/log/trivial.hpp>
 // #include <boost/log/expressions.hpp>
 #include <boost/log/utility/manipulators/add_value.hpp>
 
-#define TRACE(msg, ...)         Logger::write_log(boost::log::trivial::trace,   __FILE__, __FUNCTION__, __LINE__, msg, ##__VA_ARGS__)
-#define DEBUG(msg, ...)         Logger::write_log(boost::log::trivial::debug,   __FILE__, __FUNCTION__, __LINE__, msg, ##__VA_ARGS__)
-#define INFO(msg, ...)          Logger::write_log(boost::log::trivial::info,    __FILE__, __FUNCTION__, __LINE__, msg, ##__VA_ARGS__)
-#define WARNING(msg, ...)       Logger::write_log(boost::log::trivial::warning, __FILE__, __FUNCTION__, __LINE__, msg, ##__VA_ARGS__)
-#define ERROR(msg, ...)         Logger::write_log(boost::log::trivial::error,   __FILE__, __FUNCTION__, __LINE__, msg, ##__VA_ARGS__)
+#ifdef ENABLE_ASYNC_LOGGING
+// the caller only enqueues the raw arguments, formatting happens on the backend thread (see async_log.hpp)
+#include <chrono>
+#include <ctime>
+#include <boost/date_time/c_local_time_adjustor.hpp>
+#include <boost/date_time/posix_time/conversion.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/log/attributes/current_thread_id.hpp>
+#include <boost/log/attributes/mutable_constant.hpp>
+#include <boost/log/core.hpp>
+#include "utils/async_log.hpp"
+#define LOGGER_WRITE_LOG Logger::write_log_async
+#define LOGGER_WRITE_LOG_FMT Logger::write_log_fmt_async
+#else
+#define LOGGER_WRITE_LOG Logger::write_log
+#define LOGGER_WRITE_LOG_FMT Logger::write_log_fmt
+#endif
+
+// compile time cut first, then the runtime level (one relaxed load) before anything is evaluated
+#define LOGGER_LOG(write, lvl, msg, ...)                                                                  \
+    do {                                                                                                   \
+        if constexpr (Logger::compiled_in(lvl)) {                                                          \
+            if (Logger::enabled(lvl))                                                                      \
+                write(lvl, __FILE__, __FUNCTION__, __LINE__, msg, ##__VA_ARGS__);                          \
+        }                                                                                                  \
+    } while (false)
+
+// printf style
+#define TRACE(msg, ...)         LOGGER_LOG(LOGGER_WRITE_LOG, boost::log::trivial::trace,   msg, ##__VA_ARGS__)
+#define DEBUG(msg, ...)         LOGGER_LOG(LOGGER_WRITE_LOG, boost::log::trivial::debug,   msg, ##__VA_ARGS__)
+#define INFO(msg, ...)          LOGGER_LOG(LOGGER_WRITE_LOG, boost::log::trivial::info,    msg, ##__VA_ARGS__)
+#define WARNING(msg, ...)       LOGGER_LOG(LOGGER_WRITE_LOG, boost::log::trivial::warning, msg, ##__VA_ARGS__)
+#define ERROR(msg, ...)         LOGGER_LOG(LOGGER_WRITE_LOG, boost::log::trivial::error,   msg, ##__VA_ARGS__)
+
+// std::format style, the format string is checked against the arguments at compile time
+#define TRACE_FMT(fmt, ...)     LOGGER_LOG(LOGGER_WRITE_LOG_FMT, boost::log::trivial::trace,   fmt, ##__VA_ARGS__)
+#define DEBUG_FMT(fmt, ...)     LOGGER_LOG(LOGGER_WRITE_LOG_FMT, boost::log::trivial::debug,   fmt, ##__VA_ARGS__)
+#define INFO_FMT(fmt, ...)      LOGGER_LOG(LOGGER_WRITE_LOG_FMT, boost::log::trivial::info,    fmt, ##__VA_ARGS__)
+#define WARNING_FMT(fmt, ...)   LOGGER_LOG(LOGGER_WRITE_LOG_FMT, boost::log::trivial::warning, fmt, ##__VA_ARGS__)
+#define ERROR_FMT(fmt, ...)     LOGGER_LOG(LOGGER_WRITE_LOG_FMT, boost::log::trivial::error,   fmt, ##__VA_ARGS__)
 
 #define LOG_TRIVIAL(lvl)\
     BOOST_LOG_STREAM_WITH_PARAMS(::boost::log::trivial::logger::get(),\
@@ -28,6 +83,13 @@
 
 namespace Logger{
 
+constexpr bool compiled_in(int level) noexcept { return level >= LOG_MIN_LEVEL; }
+
+// set by Logger::init from --logging-level, until then everything compiled in passes
+inline std::atomic<int> runtime_level{LOG_MIN_LEVEL};
+
+inline bool enabled(int level) noexcept { return level >= runtime_level.load(std::memory_order_relaxed); }
+
 inline void write_log(boost::log::trivial::severity_level level, const char * file, const char * func, int line, const char *message, ...)
 {
     char buffer[1024];
@@ -39,9 +101,72 @@ inline void write_log(boost::log::trivial::severity_level level, const char * fi
     va_end(args);
 
     LOG_TRIVIAL(level) << boost::log::add_value("File", file) << boost::log::add_value("Func", func) << boost::log::add_value("Line", line) << buffer;
-    // LOG_TRIVIAL(level) << "File: " << file << " Func: " << func << " Ln#: " << line << buffer;    
+    // LOG_TRIVIAL(level) << "File: " << file << " Func: " << func << " Ln#: " << line << buffer;
+}
+
+template <typename... Args>
+inline void write_log_fmt(boost::log::trivial::severity_level level, const char * file, const char * func, int line, std::format_string<Args...> fmt, Args &&... args)
+{
+    LOG_TRIVIAL(level) << boost::log::add_value("File", file) << boost::log::add_value("Func", func) << boost::log::add_value("Line", line) << std::format(fmt, std::forward<Args>(args)...);
+}
+
+#ifdef ENABLE_ASYNC_LOGGING
+namespace details {
+
+// TimeStamp and ThreadID of the caller for the records the backend thread writes: thread attributes of that thread
+// override the global ones of add_common_attributes (a value added to the record would not)
+struct caller_attributes {
+    boost::log::attributes::mutable_constant<boost::posix_time::ptime> time{boost::posix_time::ptime()};
+    boost::log::attributes::mutable_constant<boost::log::attributes::current_thread_id::value_type> thread{{}};
+    caller_attributes() {
+        auto core = boost::log::core::get();
+        core->add_thread_attribute("TimeStamp", time);
+        core->add_thread_attribute("ThreadID", thread);
+    }
+};
+
+// local time, as boost::log::attributes::local_clock takes it
+inline boost::posix_time::ptime local_time(Logger::async::clock::time_point tp)
+{
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(tp.time_since_epoch()).count();
+    auto utc = boost::posix_time::from_time_t(static_cast<std::time_t>(us / 1000000)) + boost::posix_time::microseconds(us % 1000000);
+    return boost::date_time::c_local_adjustor<boost::posix_time::ptime>::utc_to_local(utc);
+}
+
+inline void write_message(boost::log::trivial::severity_level level, const char * file, const char * func, int line, std::string_view message)
+{
+    LOG_TRIVIAL(level) << boost::log::add_value("File", file) << boost::log::add_value("Func", func) << boost::log::add_value("Line", line) << message;
+}
+
+}
+
+// async backend sink, runs on the backend thread with the time and thread of the call
+inline void write_record(int level, const char * file, const char * func, int line, Logger::async::clock::time_point time,
+                         Logger::async::thread_id thread, std::string_view message)
+{
+    thread_local details::caller_attributes caller;
+    caller.time.set(details::local_time(time));
+    caller.thread.set(boost::log::attributes::current_thread_id::value_type(thread));
+    details::write_message(static_cast<boost::log::trivial::severity_level>(level), file, func, line, message);
+}
+
+// until Logger::init starts the backend (e.g. command line errors) records are formatted and written in place,
+// with the attributes of the calling thread
+template <typename... Args>
+inline void write_log_async(boost::log::trivial::severity_level level, const char * file, const char * func, int line, const char *message, const Args &... args)
+{
+    if (!Logger::async::write_log(level, file, func, line, message, args...))
+        details::write_message(level, file, func, line, Logger::async::format_now(message, args...));
+}
+
+template <typename... Args>
+inline void write_log_fmt_async(boost::log::trivial::severity_level level, const char * file, const char * func, int line, std::format_string<const Args &...> fmt, const Args &... args)
+{
+    if (!Logger::async::write_log_fmt(level, file, func, line, fmt, args...))
+        details::write_message(level, file, func, line, std::format(fmt, args...));
 }
+#endif
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -27,6 +27,8 @@ inline void init([[maybe_unused]] const boost::program_options::variables_map &v
 #include <boost/log/sources/record_ostream.hpp>
 #include <boost/log/support/date_time.hpp>
 
+#include "utils/logging.hpp"
+
 namespace Logger{
 
 inline void init(const boost::program_options::variables_map &vm){
@@ -78,6 +80,12 @@ inline void init(const boost::program_options::variables_map &vm){
   (
       logging::trivial::severity >= logSeverity
   );
+  // the same level checked by the log macros before any argument is evaluated
+  Logger::runtime_level.store(logSeverity, std::memory_order_relaxed);
+
+#ifdef ENABLE_ASYNC_LOGGING
+  Logger::async::backend::instance().start(&Logger::write_record);
+#endif
                      
 }
 
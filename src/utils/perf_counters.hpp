@@ -0,0 +1,107 @@
+#pragma once
+
+// Hardware event counters of the calling thread through perf_event_open(2), user space only.
+// Each event is opened on its own: the ones the CPU, the hypervisor or perf_event_paranoid / seccomp deny
+// are left out and the rest still count (available()). Counts are scaled by enabled / running time,
+// so events multiplexed on too few PMU registers give estimates instead of partial sums.
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace utils {
+
+class perf_counters {
+public:
+  enum event { cycles, instructions, l1d_misses, llc_misses, dtlb_misses, branch_misses, page_faults, event_count };
+  static constexpr const char *names[event_count] = {"cycles",      "instructions",  "L1d_misses", "LLC_misses",
+                                                      "dTLB_misses", "branch_misses", "page_faults"};
+
+  perf_counters() noexcept {
+    for (int e = 0; e < event_count; ++e)
+      _fds[e] = _open(static_cast<event>(e));
+  }
+  ~perf_counters() {
+    for (int fd : _fds)
+      if (fd != -1)
+        ::close(fd);
+  }
+  perf_counters(const perf_counters &) = delete;
+  perf_counters &operator=(const perf_counters &) = delete;
+
+  bool available(event e) const noexcept { return _fds[e] != -1; }
+  bool any() const noexcept {
+    for (int fd : _fds)
+      if (fd != -1)
+        return true;
+    return false;
+  }
+
+  // zeroes and enables every available counter
+  void start() noexcept {
+    for (int fd : _fds)
+      if (fd != -1) {
+        ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+  }
+  void stop() noexcept {
+    for (int fd : _fds)
+      if (fd != -1)
+        ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+  }
+
+  // counts since start(), 0 for events that are not available or never got a PMU register
+  std::array<double, event_count> read() const noexcept {
+    std::array<double, event_count> values{};
+    for (int e = 0; e < event_count; ++e) {
+      uint64_t v[3] = {}; // value, time enabled, time running
+      if (_fds[e] == -1 || ::read(_fds[e], v, sizeof(v)) != sizeof(v) || v[2] == 0)
+        continue;
+      values[e] = static_cast<double>(v[0]) * (static_cast<double>(v[1]) / static_cast<double>(v[2]));
+    }
+    return values;
+  }
+
+private:
+  std::array<int, event_count> _fds;
+
+  static int _open(event e) noexcept {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    auto cache = [](uint64_t id, uint64_t op, uint64_t result) { return id | (op << 8) | (result << 16); };
+    attr.type = PERF_TYPE_HARDWARE;
+    switch (e) {
+    case cycles: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+    case instructions: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+    case branch_misses: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+    case llc_misses: attr.config = PERF_COUNT_HW_CACHE_MISSES; break; // last level cache on most CPUs
+    case l1d_misses:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+      break;
+    case dtlb_misses:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+      break;
+    case page_faults: // software event: there even where the PMU is not (VMs, containers)
+      attr.type = PERF_TYPE_SOFTWARE;
+      attr.config = PERF_COUNT_SW_PAGE_FAULTS;
+      break;
+    default: return -1;
+    }
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+  }
+};
+
+} // namespace utils
@@ -0,0 +1,48 @@
+#include <sys/mman.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+
+#include "utils/perf_counters.hpp"
+
+using utils::perf_counters;
+
+TEST(utils_unit_tests, perf_counters_page_faults){
+  perf_counters counters;
+  if (!counters.available(perf_counters::page_faults))
+    GTEST_SKIP() << "perf_event_open not permitted";
+  constexpr size_t pages = 256;
+  const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  auto *p = static_cast<volatile char *>(::mmap(nullptr, pages * page, PROT_READ | PROT_WRITE,
+                                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  ASSERT_NE(p, MAP_FAILED);
+  counters.start();
+  for (size_t i = 0; i < pages; ++i)
+    p[i * page] = 1;                                       // first touch: one fault per page
+  counters.stop();
+  auto faults = counters.read()[perf_counters::page_faults];
+  ::munmap(const_cast<char *>(p), pages * page);
+  EXPECT_GE(faults, pages);
+  EXPECT_LT(faults, 2 * pages);
+
+  counters.start();                                        // start() zeroes
+  counters.stop();
+  EXPECT_LT(counters.read()[perf_counters::page_faults], pages);
+}
+
+TEST(utils_unit_tests, perf_counters_instructions){
+  perf_counters counters;
+  if (!counters.available(perf_counters::instructions))
+    GTEST_SKIP() << "no hardware counters here (VM without PMU, perf_event_paranoid)";
+  volatile uint64_t sink = 0;
+  counters.start();
+  for (uint64_t i = 0; i < 1'000'000; ++i)
+    sink = sink + i;
+  counters.stop();
+  auto values = counters.read();
+  EXPECT_GT(values[perf_counters::instructions], 1'000'000);
+  if (counters.available(perf_counters::cycles)) {
+    EXPECT_GT(values[perf_counters::cycles], 0);
+  }
+}
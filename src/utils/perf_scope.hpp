@@ -0,0 +1,61 @@
+#pragma once
+
+// Google Benchmark glue of perf_counters: a perf_scope made right before the `for (auto _: state)` loop
+// counts until the benchmark function returns and adds one user counter per available event, divided by
+// iterations * ops_per_iteration (per allocation / operation, comparable across benchmarks), plus IPC.
+// Unavailable events are missing from the report; the first perf_scope says which on stderr.
+// Paused timing (PauseTiming) is counted as well.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+
+#include "utils/perf_counters.hpp"
+
+namespace utils {
+
+class perf_scope {
+  benchmark::State &_state;
+  double _ops_per_iteration;
+
+  // opened once per thread, not per benchmark run
+  static perf_counters &_counters() {
+    thread_local perf_counters counters;
+    static bool reported = [] {
+      std::string missing;
+      for (int e = 0; e < perf_counters::event_count; ++e)
+        if (!counters.available(static_cast<perf_counters::event>(e)))
+          missing += std::string(" ") + perf_counters::names[e];
+      if (!missing.empty())
+        std::fprintf(stderr, "perf_event_open: not counted (no PMU, perf_event_paranoid or seccomp):%s\n", missing.c_str());
+      return true;
+    }();
+    (void)reported;
+    return counters;
+  }
+
+public:
+  explicit perf_scope(benchmark::State &state, double ops_per_iteration = 1) noexcept
+      : _state(state), _ops_per_iteration(ops_per_iteration) {
+    _counters().start();
+  }
+  ~perf_scope() {
+    auto &counters = _counters();
+    counters.stop();
+    if (!counters.any() || _state.iterations() == 0)
+      return;
+    const auto values = counters.read();
+    const double ops = static_cast<double>(_state.iterations()) * _ops_per_iteration;
+    for (int e = 0; e < perf_counters::event_count; ++e)
+      if (counters.available(static_cast<perf_counters::event>(e)))
+        _state.counters[perf_counters::names[e]] = values[e] / ops;
+    if (counters.available(perf_counters::cycles) && counters.available(perf_counters::instructions) &&
+        values[perf_counters::cycles] > 0)
+      _state.counters["IPC"] = values[perf_counters::instructions] / values[perf_counters::cycles];
+  }
+  perf_scope(const perf_scope &) = delete;
+  perf_scope &operator=(const perf_scope &) = delete;
+};
+
+} // namespace utils
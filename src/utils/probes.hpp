@@ -0,0 +1,20 @@
+#pragma once
+
+// USDT (static user space tracing) probes of provider "allo", for bpftrace / perf / systemtap on a running binary.
+// Compiled in with ENABLE_USDT (needs <sys/sdt.h>, package systemtap-sdt-dev): each probe site is a single nop
+// plus an ELF note describing where its arguments live, nothing is done unless a tracer attaches.
+// Without ENABLE_USDT the probes and their arguments vanish. See scripts/bpftrace/ for consumers.
+//
+//   ALLO_PROBE(name, args...)   up to 12 integer or pointer arguments (arg0.. in bpftrace)
+
+#ifdef ENABLE_USDT
+
+#include <sys/sdt.h>
+
+#define ALLO_PROBE(name, ...) STAP_PROBEV(allo, name, ##__VA_ARGS__)
+
+#else
+
+#define ALLO_PROBE(name, ...) do {} while (false)
+
+#endif